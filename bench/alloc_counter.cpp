@@ -0,0 +1,89 @@
+#include "./alloc_counter.h"
+
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+static std::atomic<uint64_t> count(0);
+static __thread bool ignored = false;
+
+static inline void countAllocation() {
+    if (!ignored) count.fetch_add(1, std::memory_order_relaxed);
+}
+
+namespace bench {
+
+uint64_t allocations() {
+    return count.load(std::memory_order_relaxed);
+}
+
+void ignoreThisThread() {
+    ignored = true;
+}
+
+}
+
+// --- malloc family, redirected here by -Wl,--wrap ---------------------------
+
+extern "C" {
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    countAllocation();
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    countAllocation();
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    countAllocation();
+    return __real_realloc(ptr, size);
+}
+
+}
+
+// --- operator new ------------------------------------------------------------
+// libstdc++ calls malloc from inside the shared library, out of reach of
+// --wrap, so the global operators are replaced as well.
+
+void *operator new(size_t size) {
+    countAllocation();
+    void *ptr = __real_malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    countAllocation();
+    return __real_malloc(size ? size : 1);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+    free(ptr);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdint.h>
+
+// ----------------------------------------------------------------------------
+// Heap allocation counter
+// ----------------------------------------------------------------------------
+// Counts operator new and malloc/calloc/realloc calls made by the firmware
+// (the latter through the linker's --wrap, see [env:bench]). Threads that
+// only generate load opt out, so the count is what serving the calls costs.
+// ----------------------------------------------------------------------------
+
+namespace bench {
+
+uint64_t allocations();
+
+// stops counting the allocations made by the calling thread
+void ignoreThisThread();
+
+}
@@ -0,0 +1,428 @@
+/**
+ * ----------------------------------------------------------------------------
+ * Control path benchmark
+ * ----------------------------------------------------------------------------
+ * Runs the firmware on the native HAL and drives it over loopback with 1 to
+ * 32 concurrent clients, each issuing its next call as soon as the previous
+ * one is answered. Per scenario and client count it reports latency
+ * percentiles, throughput and the heap allocations made per call by the
+ * firmware (server and loop tasks, the HAL included).
+ *
+ *   pio run -e bench -t exec
+ *
+ * It serves on the port of the native build (NATIVE_HTTP_PORT, default 8080).
+ * BENCH_SECONDS (default 1) sets the length of each run and BENCH_CSV names
+ * a file that receives the results as CSV, for comparison between builds.
+ *
+ * The HAL closes HTTP connections after every response, as the firmware's
+ * server does, so HTTP latencies include the TCP handshake. WebSocket runs
+ * use at most DEFAULT_MAX_WS_CLIENTS connections, the most the firmware keeps.
+ * ----------------------------------------------------------------------------
+ */
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <NativeHAL.h>
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "./alloc_counter.h"
+
+#define BENCH_IO_TIMEOUT_MS 2000
+#define BENCH_BUFFER_SIZE 4096
+
+static const int CLIENT_COUNTS[] = {1, 2, 4, 8, 16, 32};
+
+static uint16_t port;
+
+static uint64_t nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// ----------------------------------------------------------------------------
+// Loopback clients
+// ----------------------------------------------------------------------------
+
+static int openSocket() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    timeval timeout = {BENCH_IO_TIMEOUT_MS / 1000, (BENCH_IO_TIMEOUT_MS % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool sendAll(int fd, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t*)data;
+    while (len) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+// One request on a fresh connection, read to the server's close. Returns
+// true on a 2xx status.
+static bool httpCall(const char *request, size_t len) {
+    int fd = openSocket();
+    if (fd < 0) return false;
+
+    char buffer[BENCH_BUFFER_SIZE];
+    size_t head = 0;
+    bool ok = sendAll(fd, request, len);
+    while (ok) {
+        ssize_t n = recv(fd, buffer + head, sizeof(buffer) - head, 0);
+        if (n < 0) ok = false;
+        if (n <= 0) break;
+        // only the status line is kept, the body is drained
+        if (head < 12) head += n;
+        if (head > 12) head = 12;
+    }
+    close(fd);
+    return ok && head >= 12 && memcmp(buffer, "HTTP/1.", 7) == 0 && buffer[9] == '2';
+}
+
+struct WsClient {
+    int fd;
+    uint8_t buffer[BENCH_BUFFER_SIZE];
+    size_t len;
+};
+
+static bool wsOpen(WsClient &client) {
+    static const char upgrade[] =
+        "GET /ws HTTP/1.1\r\n"
+        "Host: bench\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+        "Sec-WebSocket-Version: 13\r\n\r\n";
+
+    client.len = 0;
+    client.fd = openSocket();
+    if (client.fd < 0) return false;
+    if (!sendAll(client.fd, upgrade, sizeof(upgrade) - 1)) return false;
+
+    for (;;) {
+        ssize_t n = recv(client.fd, client.buffer + client.len, sizeof(client.buffer) - client.len, 0);
+        if (n <= 0) return false;
+        client.len += n;
+        uint8_t *end = (uint8_t*)memmem(client.buffer, client.len, "\r\n\r\n", 4);
+        if (!end) continue;
+        if (memcmp(client.buffer, "HTTP/1.1 101", 12) != 0) return false;
+        // keep whatever followed the handshake
+        size_t used = end + 4 - client.buffer;
+        memmove(client.buffer, client.buffer + used, client.len - used);
+        client.len -= used;
+        return true;
+    }
+}
+
+static void wsClose(WsClient &client) {
+    if (client.fd >= 0) close(client.fd);
+    client.fd = -1;
+}
+
+static bool wsSend(WsClient &client, uint8_t opcode, const void *data, size_t len) {
+    uint8_t frame[8 + 126];
+    if (len >= 126) return false;
+    static const uint8_t mask[4] = {0x12, 0x34, 0x56, 0x78};
+    frame[0] = 0x80 | opcode;
+    frame[1] = 0x80 | len;
+    memcpy(frame + 2, mask, 4);
+    for (size_t i = 0; i < len; i++) frame[6 + i] = ((const uint8_t*)data)[i] ^ mask[i % 4];
+    return sendAll(client.fd, frame, 6 + len);
+}
+
+// Reads frames until one of the given opcode arrives; its payload stays in
+// the buffer until wsConsume(). Other frames (telemetry, pings) are skipped.
+static bool wsReceive(WsClient &client, uint8_t opcode, const uint8_t *&payload, size_t &payloadLen) {
+    for (;;) {
+        size_t header = 2;
+        size_t len = 0;
+        if (client.len >= 2) {
+            len = client.buffer[1] & 0x7f;
+            if (len == 126) {
+                header = 4;
+                len = client.len >= 4 ? (client.buffer[2] << 8 | client.buffer[3]) : 0;
+            } else if (len == 127) {
+                return false;
+            }
+        }
+        if (client.len >= header && client.len >= header + len) {
+            if ((client.buffer[0] & 0x0f) == opcode) {
+                payload = client.buffer + header;
+                payloadLen = len;
+                return true;
+            }
+            memmove(client.buffer, client.buffer + header + len, client.len - header - len);
+            client.len -= header + len;
+            continue;
+        }
+        if (header + len > sizeof(client.buffer)) return false;
+
+        ssize_t n = recv(client.fd, client.buffer + client.len, sizeof(client.buffer) - client.len, 0);
+        if (n <= 0) return false;
+        client.len += n;
+    }
+}
+
+// drops the frame wsReceive() returned
+static void wsConsume(WsClient &client, const uint8_t *payload, size_t payloadLen) {
+    size_t used = payload + payloadLen - client.buffer;
+    memmove(client.buffer, client.buffer + used, client.len - used);
+    client.len -= used;
+}
+
+// ----------------------------------------------------------------------------
+// Scenarios
+// ----------------------------------------------------------------------------
+// Each call is one request and its reply; n counts the calls of a client, to
+// vary the commanded position.
+
+static bool getPositionCall(WsClient &, uint32_t) {
+    static const char request[] = "GET /getPosition HTTP/1.1\r\nHost: bench\r\n\r\n";
+    return httpCall(request, sizeof(request) - 1);
+}
+
+static bool getAxesLimitsCall(WsClient &, uint32_t) {
+    static const char request[] = "GET /getAxesLimits HTTP/1.1\r\nHost: bench\r\n\r\n";
+    return httpCall(request, sizeof(request) - 1);
+}
+
+static bool setPositionCall(WsClient &, uint32_t n) {
+    char body[64];
+    int bodyLen = snprintf(body, sizeof(body), "{\"position\":[%u],\"feedrate\":50}", n % 2 ? 20 : 10);
+    char request[256];
+    int len = snprintf(request, sizeof(request),
+        "POST /setPosition HTTP/1.1\r\nHost: bench\r\n"
+        "Content-Type: application/json\r\nContent-Length: %d\r\n\r\n%s", bodyLen, body);
+    return httpCall(request, len);
+}
+
+// binary SetPosition of axis 0, answered with an Ack
+static bool wsBinaryCall(WsClient &client, uint32_t n) {
+    uint8_t frame[16] = {1, 0x01, 1, 0x01};
+    float position = n % 2 ? 20 : 10;
+    float feedrate = 50;
+    memcpy(frame + 4, &n, 4);
+    memcpy(frame + 8, &position, 4);
+    memcpy(frame + 12, &feedrate, 4);
+    if (!wsSend(client, WS_BINARY, frame, sizeof(frame))) return false;
+
+    const uint8_t *reply;
+    size_t len;
+    if (!wsReceive(client, WS_BINARY, reply, len)) return false;
+    bool ok = len >= 8 && reply[1] == 0x80 && reply[3] == 0 && memcmp(reply + 4, &n, 4) == 0;
+    wsConsume(client, reply, len);
+    return ok;
+}
+
+// text {"action":"status"}, answered with the program status
+static bool wsTextCall(WsClient &client, uint32_t) {
+    static const char message[] = "{\"action\":\"status\"}";
+    if (!wsSend(client, WS_TEXT, message, sizeof(message) - 1)) return false;
+
+    const uint8_t *reply;
+    size_t len;
+    if (!wsReceive(client, WS_TEXT, reply, len)) return false;
+    bool ok = memmem(reply, len, "programStatus", 13) != nullptr;
+    wsConsume(client, reply, len);
+    return ok;
+}
+
+struct Scenario {
+    const char *name;
+    bool websocket;
+    bool (*call)(WsClient &client, uint32_t n);
+};
+
+static const Scenario SCENARIOS[] = {
+    {"GET /getPosition",   false, getPositionCall},
+    {"POST /setPosition",  false, setPositionCall},
+    {"GET /getAxesLimits", false, getAxesLimitsCall},
+    {"WS binary setPosition", true, wsBinaryCall},
+    {"WS text status",     true, wsTextCall},
+};
+
+// ----------------------------------------------------------------------------
+// Runner
+// ----------------------------------------------------------------------------
+
+struct Result {
+    int clients;
+    uint64_t calls;
+    uint64_t errors;
+    double p50Us;
+    double p99Us;
+    double maxUs;
+    double callsPerSecond;
+    double allocsPerCall;
+};
+
+static double percentileUs(const std::vector<uint32_t> &sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t i = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[i] / 1000.0;
+}
+
+static Result run(const Scenario &scenario, int clients, double seconds) {
+    std::vector<WsClient> sockets(clients);
+    std::vector<std::vector<uint32_t>> latencies(clients);
+    std::vector<uint64_t> errors(clients, 0);
+    std::atomic<int> ready(0);
+    std::atomic<bool> go(false);
+    std::atomic<bool> stop(false);
+
+    std::vector<std::thread> threads;
+    for (int c = 0; c < clients; c++) {
+        threads.push_back(std::thread([&, c]() {
+            bench::ignoreThisThread();
+            WsClient &client = sockets[c];
+            client.fd = -1;
+            if (scenario.websocket && !wsOpen(client)) wsClose(client);
+            latencies[c].reserve(1 << 16);
+            ready++;
+            while (!go) std::this_thread::yield();
+
+            for (uint32_t n = 0; !stop; n++) {
+                if (scenario.websocket && client.fd < 0) {
+                    errors[c]++;
+                    break;
+                }
+                uint64_t start = nowNs();
+                bool ok = scenario.call(client, n);
+                uint64_t ns = nowNs() - start;
+                if (ok) latencies[c].push_back(ns > UINT32_MAX ? UINT32_MAX : ns);
+                else errors[c]++;
+            }
+        }));
+    }
+    while (ready < clients) std::this_thread::yield();
+
+    uint64_t allocationsBefore = bench::allocations();
+    uint64_t start = nowNs();
+    go = true;
+    std::this_thread::sleep_for(std::chrono::microseconds((uint64_t)(seconds * 1e6)));
+    stop = true;
+    for (std::thread &thread : threads) thread.join();
+    double elapsed = (nowNs() - start) / 1e9;
+    uint64_t allocations = bench::allocations() - allocationsBefore;
+
+    for (WsClient &client : sockets) wsClose(client);
+
+    std::vector<uint32_t> all;
+    Result result;
+    memset(&result, 0, sizeof(result));
+    result.clients = clients;
+    for (int c = 0; c < clients; c++) {
+        all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+        result.errors += errors[c];
+    }
+    std::sort(all.begin(), all.end());
+    result.calls = all.size();
+    result.p50Us = percentileUs(all, 0.50);
+    result.p99Us = percentileUs(all, 0.99);
+    result.maxUs = all.empty() ? 0 : all.back() / 1000.0;
+    result.callsPerSecond = result.calls / elapsed;
+    uint64_t attempts = result.calls + result.errors;
+    result.allocsPerCall = attempts ? (double)allocations / attempts : 0;
+    return result;
+}
+
+static bool waitForServer() {
+    for (int i = 0; i < 500; i++) {
+        int fd = openSocket();
+        if (fd >= 0) {
+            close(fd);
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+int main() {
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+    // the server took its port from the environment while constructed
+    const char *portEnv = getenv("NATIVE_HTTP_PORT");
+    port = portEnv ? atoi(portEnv) : 8080;
+    const char *secondsEnv = getenv("BENCH_SECONDS");
+    const double seconds = secondsEnv ? atof(secondsEnv) : 1.0;
+
+    // the firmware's own tasks, as NativeMain.cpp runs them
+    setup();
+    std::thread loopTask([]() {
+        const uint32_t period = native::loopPeriodMicros();
+        for (;;) {
+            loop();
+            if (period) delayMicroseconds(period);
+        }
+    });
+    loopTask.detach();
+
+    bench::ignoreThisThread();
+    if (!waitForServer()) {
+        fprintf(stderr, "bench: no server on port %u\n", port);
+        return 1;
+    }
+
+    FILE *csv = nullptr;
+    if (getenv("BENCH_CSV")) {
+        csv = fopen(getenv("BENCH_CSV"), "w");
+        if (csv) fprintf(csv, "scenario,clients,calls,errors,p50_us,p99_us,max_us,calls_per_s,allocs_per_call\n");
+    }
+
+    printf("\n%-22s %7s %9s %7s %9s %9s %9s %10s %12s\n",
+           "scenario", "clients", "calls", "errors", "p50 us", "p99 us", "max us", "calls/s", "allocs/call");
+    for (const Scenario &scenario : SCENARIOS) {
+        for (int clients : CLIENT_COUNTS) {
+            if (scenario.websocket && clients > DEFAULT_MAX_WS_CLIENTS) continue;
+            Result r = run(scenario, clients, seconds);
+            printf("%-22s %7d %9llu %7llu %9.1f %9.1f %9.1f %10.0f %12.1f\n",
+                   scenario.name, r.clients, (unsigned long long)r.calls, (unsigned long long)r.errors,
+                   r.p50Us, r.p99Us, r.maxUs, r.callsPerSecond, r.allocsPerCall);
+            if (csv) {
+                fprintf(csv, "%s,%d,%llu,%llu,%.1f,%.1f,%.1f,%.0f,%.2f\n",
+                        scenario.name, r.clients, (unsigned long long)r.calls, (unsigned long long)r.errors,
+                        r.p50Us, r.p99Us, r.maxUs, r.callsPerSecond, r.allocsPerCall);
+            }
+            // let the server notice the closed WebSocket clients
+            if (scenario.websocket) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+    if (csv) fclose(csv);
+
+    // the server and loop tasks never return; leave without running the
+    // destructors of the objects they still use
+    fflush(stdout);
+    _exit(0);
+}
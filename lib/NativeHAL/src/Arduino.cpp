@@ -0,0 +1,96 @@
+#include "Arduino.h"
+#include "NativeHAL.h"
+#include "NativeNet.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+namespace {
+
+std::atomic<uint8_t>  pinLevels[native::PIN_COUNT];
+std::atomic<uint8_t>  pinModes[native::PIN_COUNT];
+std::atomic<uint32_t> pinRisingEdges[native::PIN_COUNT];
+
+const std::chrono::steady_clock::time_point bootTime = std::chrono::steady_clock::now();
+
+}
+
+HardwareSerial Serial;
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin >= native::PIN_COUNT) return;
+    pinModes[pin] = mode;
+    // an unconnected pulled-up input reads HIGH, like on the board
+    if (mode == INPUT_PULLUP) pinLevels[pin] = HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    if (pin >= native::PIN_COUNT) return;
+    uint8_t previous = pinLevels[pin].exchange(val ? HIGH : LOW);
+    if (!previous && val) pinRisingEdges[pin]++;
+}
+
+int digitalRead(uint8_t pin) {
+    if (pin >= native::PIN_COUNT) return LOW;
+    return pinLevels[pin];
+}
+
+unsigned long millis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - bootTime).count();
+}
+
+unsigned long micros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - bootTime).count();
+}
+
+// both let the other tasks at the server state meanwhile, see AsyncMutex
+void delay(uint32_t ms) {
+    const unsigned held = native::asyncLock().releaseAll();
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    native::asyncLock().reacquire(held);
+}
+
+void delayMicroseconds(uint32_t us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield() {
+    const unsigned held = native::asyncLock().releaseAll();
+    std::this_thread::yield();
+    native::asyncLock().reacquire(held);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+    return fwrite(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::flush() {
+    fflush(stdout);
+}
+
+namespace native {
+
+void setPinLevel(uint8_t pin, uint8_t level) {
+    if (pin < PIN_COUNT) pinLevels[pin] = level ? HIGH : LOW;
+}
+
+uint8_t pinLevel(uint8_t pin) {
+    return pin < PIN_COUNT ? pinLevels[pin].load() : LOW;
+}
+
+uint32_t risingEdges(uint8_t pin) {
+    return pin < PIN_COUNT ? pinRisingEdges[pin].load() : 0;
+}
+
+uint32_t loopPeriodMicros() {
+    const char *env = getenv("NATIVE_LOOP_PERIOD_US");
+    return env ? strtoul(env, nullptr, 10) : 1000;
+}
+
+}
@@ -0,0 +1,63 @@
+/**
+ * ----------------------------------------------------------------------------
+ * Native HAL: Arduino core
+ * ----------------------------------------------------------------------------
+ * Just enough of the arduino-esp32 core for the firmware to run as a Linux
+ * process. GPIO levels live in a simulated pin table (see NativeHAL.h) and
+ * time comes from the host monotonic clock.
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "Esp.h"
+#include "IPAddress.h"
+#include "Print.h"
+#include "WString.h"
+#include "esp32-hal-timer.h"
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT          0x01
+#define OUTPUT         0x02
+#define INPUT_PULLUP   0x05
+#define INPUT_PULLDOWN 0x09
+
+#define LED_BUILTIN 2
+
+#define IRAM_ATTR
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int  digitalRead(uint8_t pin);
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+class HardwareSerial : public Print {
+    public:
+        void begin(unsigned long baud) { (void)baud; }
+        size_t write(uint8_t c) override;
+        size_t write(const uint8_t *buffer, size_t size) override;
+        using Print::write;
+        void flush() override;
+};
+
+extern HardwareSerial Serial;
+
+// provided by the sketch
+void setup();
+void loop();
@@ -0,0 +1,70 @@
+/**
+ * ----------------------------------------------------------------------------
+ * Native HAL: AsyncJson
+ * ----------------------------------------------------------------------------
+ * AsyncCallbackJsonWebHandler for ArduinoJson 7: buffers the request body
+ * and hands the parsed document to the callback.
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <ArduinoJson.h>
+
+#include "ESPAsyncWebServer.h"
+
+#define DEFAULT_MAX_JSON_CONTENT_LENGTH 16384
+
+typedef std::function<void(AsyncWebServerRequest *request, JsonVariant &json)> ArJsonRequestHandlerFunction;
+
+class AsyncCallbackJsonWebHandler : public AsyncWebHandler {
+    public:
+        AsyncCallbackJsonWebHandler(const String &uri, ArJsonRequestHandlerFunction onRequest = nullptr)
+            : _uri(uri), _onRequest(onRequest) {}
+
+        void setMethod(WebRequestMethodComposite method) { _method = method; }
+        void setMaxContentLength(size_t maxContentLength) { _maxContentLength = maxContentLength; }
+        void onRequest(ArJsonRequestHandlerFunction fn) { _onRequest = fn; }
+
+        bool canHandle(AsyncWebServerRequest *request) override {
+            if (!_onRequest || !(_method & request->method())) return false;
+            if (_uri.length() && _uri != request->url() && !request->url().startsWith(_uri + "/")) return false;
+            return request->contentType().equalsIgnoreCase("application/json");
+        }
+
+        void handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) override {
+            if (total > _maxContentLength) return;
+            if (index == 0) {
+                request->_tempObject = malloc(total + 1);
+                _contentLength = total;
+            }
+            if (request->_tempObject) {
+                memcpy((uint8_t *)request->_tempObject + index, data, len);
+                ((uint8_t *)request->_tempObject)[index + len] = 0;
+            }
+        }
+
+        void handleRequest(AsyncWebServerRequest *request) override {
+            if (!request->_tempObject) {
+                request->send(request->contentLength() > _maxContentLength ? 413 : 400);
+                return;
+            }
+            JsonDocument doc;
+            DeserializationError error = deserializeJson(doc, (const char *)request->_tempObject, _contentLength);
+            if (error) {
+                request->send(400);
+                return;
+            }
+            JsonVariant json = doc.as<JsonVariant>();
+            _onRequest(request, json);
+        }
+
+        bool isRequestHandlerTrivial() override { return false; }
+
+    private:
+        String _uri;
+        WebRequestMethodComposite _method = HTTP_POST | HTTP_PUT | HTTP_PATCH;
+        ArJsonRequestHandlerFunction _onRequest;
+        size_t _contentLength = 0;
+        size_t _maxContentLength = DEFAULT_MAX_JSON_CONTENT_LENGTH;
+};
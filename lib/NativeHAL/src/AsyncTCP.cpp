@@ -0,0 +1,51 @@
+#include "AsyncTCP.h"
+#include "NativeNet.h"
+
+#include <mutex>
+
+// ----------------------------------------------------------------------------
+// AsyncClient
+// ----------------------------------------------------------------------------
+
+AsyncClient::~AsyncClient() {
+    std::lock_guard<native::AsyncMutex> lock(native::asyncLock());
+    if (!_conn) return;
+    _conn->tcp = nullptr;
+    _conn->closeWhenFlushed();
+    native::wake();
+}
+
+void AsyncClient::close(bool now) {
+    (void)now;
+    std::lock_guard<native::AsyncMutex> lock(native::asyncLock());
+    if (!_conn) return;
+    _conn->closeWhenFlushed();
+    native::wake();
+}
+
+void AsyncClient::_onData(uint8_t *data, size_t len) {
+    if (_dataHandler) _dataHandler(_dataArg, this, data, len);
+}
+
+void AsyncClient::_onDisconnect() {
+    _conn = nullptr;
+    // may delete this
+    if (_disconnectHandler) _disconnectHandler(_disconnectArg, this);
+}
+
+// ----------------------------------------------------------------------------
+// AsyncServer
+// ----------------------------------------------------------------------------
+
+void AsyncServer::begin() {
+    native::listen(this, _port);
+}
+
+void AsyncServer::end() {
+    native::unlisten(this);
+}
+
+void AsyncServer::_onClient(AsyncClient *client) {
+    if (_connectHandler) _connectHandler(_connectArg, client);
+    else delete client;
+}
@@ -0,0 +1,73 @@
+/**
+ * ----------------------------------------------------------------------------
+ * Native HAL: AsyncTCP
+ * ----------------------------------------------------------------------------
+ * The raw AsyncServer/AsyncClient pair, for loopback use within the process.
+ * An AsyncServer gets no host socket: begin() registers it by port, and a
+ * WiFiClient connecting to 127.0.0.1 on that port is joined to it through a
+ * socket pair. Client events run on the network thread, serialized by
+ * native::asyncLock() like every other AsyncTCP callback.
+ *
+ * As with AsyncTCP, the owner deletes an accepted AsyncClient, typically
+ * from its onDisconnect handler.
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "IPAddress.h"
+
+namespace native { class Connection; }
+
+class AsyncClient;
+
+typedef std::function<void(void *arg, AsyncClient *client)> AcConnectHandler;
+typedef std::function<void(void *arg, AsyncClient *client, void *data, size_t len)> AcDataHandler;
+
+class AsyncClient {
+    public:
+        explicit AsyncClient(native::Connection *conn = nullptr) : _conn(conn) {}
+        ~AsyncClient();
+
+        void onData(AcDataHandler callback, void *arg = nullptr) { _dataHandler = callback; _dataArg = arg; }
+        void onDisconnect(AcConnectHandler callback, void *arg = nullptr) { _disconnectHandler = callback; _disconnectArg = arg; }
+
+        bool connected() const { return _conn != nullptr; }
+        void close(bool now = false);
+
+        // called by the network thread
+        void _onData(uint8_t *data, size_t len);
+        void _onDisconnect();
+
+    private:
+        native::Connection *_conn;
+        AcDataHandler _dataHandler;
+        void *_dataArg = nullptr;
+        AcConnectHandler _disconnectHandler;
+        void *_disconnectArg = nullptr;
+};
+
+class AsyncServer {
+    public:
+        AsyncServer(IPAddress addr, uint16_t port) : _port(port) { (void)addr; }
+        explicit AsyncServer(uint16_t port) : _port(port) {}
+        ~AsyncServer() { end(); }
+
+        void onClient(AcConnectHandler callback, void *arg) { _connectHandler = callback; _connectArg = arg; }
+        void setNoDelay(bool nodelay) { (void)nodelay; }
+        void begin();
+        void end();
+
+        uint16_t _getPort() const { return _port; }
+        // called by the network thread with a newly joined client
+        void _onClient(AsyncClient *client);
+
+    private:
+        uint16_t _port;
+        AcConnectHandler _connectHandler;
+        void *_connectArg = nullptr;
+};
@@ -0,0 +1,429 @@
+#include "AsyncWebSocket.h"
+#include "NativeNet.h"
+
+namespace {
+
+typedef std::lock_guard<native::AsyncMutex> AsyncLock;
+
+void appendFrameHeader(std::string &out, uint8_t opcode, size_t len) {
+    out.push_back((char)(0x80 | opcode));
+    if (len < 126) {
+        out.push_back((char)len);
+    } else if (len <= 0xFFFF) {
+        out.push_back(126);
+        out.push_back((char)(len >> 8));
+        out.push_back((char)len);
+    } else {
+        out.push_back(127);
+        for (int i = 7; i >= 0; i--) out.push_back((char)((uint64_t)len >> (i * 8)));
+    }
+}
+
+size_t headerSize(const std::string &header) {
+    if (header.size() < 2) return 2;
+    uint8_t lenCode = header[1] & 0x7F;
+    size_t size = 2 + (lenCode == 126 ? 2 : lenCode == 127 ? 8 : 0);
+    return size + ((header[1] & 0x80) ? 4 : 0);
+}
+
+}
+
+// ----------------------------------------------------------------------------
+// AsyncWebSocketMessageBuffer
+// ----------------------------------------------------------------------------
+
+AsyncWebSocketMessageBuffer::AsyncWebSocketMessageBuffer() {}
+
+AsyncWebSocketMessageBuffer::AsyncWebSocketMessageBuffer(size_t size) {
+    reserve(size);
+}
+
+AsyncWebSocketMessageBuffer::AsyncWebSocketMessageBuffer(uint8_t *data, size_t size) {
+    if (reserve(size) && data) memcpy(_data, data, size);
+}
+
+AsyncWebSocketMessageBuffer::~AsyncWebSocketMessageBuffer() {
+    delete[] _data;
+}
+
+bool AsyncWebSocketMessageBuffer::reserve(size_t size) {
+    delete[] _data;
+    _len = size;
+    // one spare byte so that text payloads can be used as C strings
+    _data = new uint8_t[_len + 1];
+    _data[_len] = 0;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// AsyncWebSocketClient
+// ----------------------------------------------------------------------------
+
+AsyncWebSocketClient::AsyncWebSocketClient(AsyncWebServerRequest *request, AsyncWebSocket *server)
+    : _conn(request->_connection()), _server(server), _clientId(server->_getNextId()) {
+    memset(&_pinfo, 0, sizeof(_pinfo));
+    _conn->client = this;
+    _server->_addClient(this);
+    _server->_handleEvent(this, WS_EVT_CONNECT, request, nullptr, 0);
+}
+
+AsyncWebSocketClient::~AsyncWebSocketClient() {
+    for (Message &message : _messageQueue) {
+        if (message.shared) (*message.shared)--;
+    }
+}
+
+IPAddress AsyncWebSocketClient::remoteIP() {
+    AsyncLock lock(native::asyncLock());
+    return _conn ? _conn->remoteIP : IPAddress();
+}
+
+uint16_t AsyncWebSocketClient::remotePort() {
+    AsyncLock lock(native::asyncLock());
+    return _conn ? _conn->remotePort : 0;
+}
+
+void AsyncWebSocketClient::close(uint16_t code, const char *message) {
+    AsyncLock lock(native::asyncLock());
+    if (_status != WS_CONNECTED) return;
+    std::string payload;
+    if (code) {
+        payload.push_back((char)(code >> 8));
+        payload.push_back((char)code);
+        if (message) payload.append(message);
+    }
+    _queueControl(WS_DISCONNECT, (const uint8_t *)payload.data(), payload.size());
+    _status = WS_DISCONNECTING;
+}
+
+void AsyncWebSocketClient::ping(uint8_t *data, size_t len) {
+    AsyncLock lock(native::asyncLock());
+    if (_status == WS_CONNECTED) _queueControl(WS_PING, data, len);
+}
+
+bool AsyncWebSocketClient::queueIsFull() {
+    AsyncLock lock(native::asyncLock());
+    return _messageQueue.size() >= WS_MAX_QUEUED_MESSAGES || _status != WS_CONNECTED;
+}
+
+size_t AsyncWebSocketClient::queueLen() {
+    AsyncLock lock(native::asyncLock());
+    return _messageQueue.size() + _controlQueue.size();
+}
+
+bool AsyncWebSocketClient::canSend() {
+    AsyncLock lock(native::asyncLock());
+    return _messageQueue.size() < WS_MAX_QUEUED_MESSAGES;
+}
+
+void AsyncWebSocketClient::text(const char *message, size_t len) { _queueMessage(WS_TEXT, (const uint8_t *)message, len); }
+void AsyncWebSocketClient::text(const char *message) { text(message, strlen(message)); }
+void AsyncWebSocketClient::text(uint8_t *message, size_t len) { _queueMessage(WS_TEXT, message, len); }
+void AsyncWebSocketClient::text(const String &message) { text(message.c_str(), message.length()); }
+void AsyncWebSocketClient::text(AsyncWebSocketMessageBuffer *buffer) { _queueMessage(WS_TEXT, buffer); }
+
+void AsyncWebSocketClient::binary(const char *message, size_t len) { _queueMessage(WS_BINARY, (const uint8_t *)message, len); }
+void AsyncWebSocketClient::binary(const char *message) { binary(message, strlen(message)); }
+void AsyncWebSocketClient::binary(uint8_t *message, size_t len) { _queueMessage(WS_BINARY, message, len); }
+void AsyncWebSocketClient::binary(const String &message) { binary(message.c_str(), message.length()); }
+void AsyncWebSocketClient::binary(AsyncWebSocketMessageBuffer *buffer) { _queueMessage(WS_BINARY, buffer); }
+
+void AsyncWebSocketClient::_queueMessage(uint8_t opcode, const uint8_t *data, size_t len) {
+    AsyncLock lock(native::asyncLock());
+    if (_status != WS_CONNECTED) return;
+    if (_messageQueue.size() >= WS_MAX_QUEUED_MESSAGES) {
+        Serial.printf("ERROR: Too many messages queued\n");
+        return;
+    }
+    Message message = { opcode, std::string((const char *)data, len), nullptr };
+    _messageQueue.push_back(message);
+    native::wake();
+}
+
+void AsyncWebSocketClient::_queueMessage(uint8_t opcode, AsyncWebSocketMessageBuffer *buffer) {
+    AsyncLock lock(native::asyncLock());
+    if (!buffer || _status != WS_CONNECTED) return;
+    if (_messageQueue.size() >= WS_MAX_QUEUED_MESSAGES) {
+        Serial.printf("ERROR: Too many messages queued\n");
+        return;
+    }
+    (*buffer)++;
+    Message message = { opcode, std::string(), buffer };
+    _messageQueue.push_back(message);
+    native::wake();
+}
+
+void AsyncWebSocketClient::_queueControl(uint8_t opcode, const uint8_t *data, size_t len) {
+    Message message = { opcode, std::string((const char *)data, data ? len : 0), nullptr };
+    _controlQueue.push_back(message);
+    native::wake();
+}
+
+bool AsyncWebSocketClient::_runQueue(std::string &out) {
+    std::deque<Message> &queue = _controlQueue.empty() ? _messageQueue : _controlQueue;
+    if (queue.empty()) return false;
+
+    Message &message = queue.front();
+    const uint8_t *data = message.shared ? message.shared->get() : (const uint8_t *)message.own.data();
+    size_t len = message.shared ? message.shared->length() : message.own.size();
+    appendFrameHeader(out, message.opcode, len);
+    out.append((const char *)data, len);
+
+    if (message.shared) (*message.shared)--;
+    queue.pop_front();
+    return true;
+}
+
+void AsyncWebSocketClient::_onData(uint8_t *data, size_t len) {
+    while (len) {
+        if (!_inPayload) {
+            size_t needed = headerSize(_header);
+            size_t take = needed - _header.size();
+            if (take > len) take = len;
+            _header.append((const char *)data, take);
+            data += take;
+            len -= take;
+            if (_header.size() < headerSize(_header) || _header.size() < 2) continue;
+
+            const uint8_t *h = (const uint8_t *)_header.data();
+            uint8_t lenCode = h[1] & 0x7F;
+            size_t pos = 2;
+            uint64_t payloadLen = lenCode;
+            if (lenCode == 126) {
+                payloadLen = (uint64_t)h[2] << 8 | h[3];
+                pos = 4;
+            } else if (lenCode == 127) {
+                payloadLen = 0;
+                for (int i = 0; i < 8; i++) payloadLen = payloadLen << 8 | h[2 + i];
+                pos = 10;
+            }
+
+            _pinfo.final = (h[0] & 0x80) != 0;
+            _pinfo.opcode = h[0] & 0x0F;
+            _pinfo.masked = (h[1] & 0x80) != 0;
+            _pinfo.len = payloadLen;
+            _pinfo.index = 0;
+            if (_pinfo.masked) memcpy(_pinfo.mask, h + pos, 4);
+            _inPayload = true;
+            _control.clear();
+            if (payloadLen == 0) _dispatchFrameData(data, 0);
+            continue;
+        }
+
+        size_t take = _pinfo.len - _pinfo.index;
+        if (take > len) take = len;
+        if (_pinfo.masked) {
+            for (size_t i = 0; i < take; i++) data[i] ^= _pinfo.mask[(_pinfo.index + i) % 4];
+        }
+        _dispatchFrameData(data, take);
+        data += take;
+        len -= take;
+    }
+}
+
+void AsyncWebSocketClient::_dispatchFrameData(uint8_t *data, size_t len) {
+    bool complete = _pinfo.index + len == _pinfo.len;
+
+    if (_pinfo.opcode < WS_DISCONNECT) {
+        // the library only tracks the message across a frame it splits
+        if (_pinfo.index == 0 && !complete) {
+            if (_pinfo.opcode != WS_CONTINUATION) {
+                _pinfo.message_opcode = _pinfo.opcode;
+                _pinfo.num = 0;
+            } else {
+                _pinfo.num++;
+            }
+        }
+        // null terminated copy so that text handlers may treat it as a C string
+        std::string copy((const char *)data, len);
+        _server->_handleEvent(this, WS_EVT_DATA, &_pinfo, (uint8_t *)&copy[0], len);
+        _pinfo.index += len;
+    } else {
+        _control.append((const char *)data, len);
+        _pinfo.index += len;
+        if (complete) {
+            if (_pinfo.opcode == WS_PING) {
+                _queueControl(WS_PONG, (const uint8_t *)_control.data(), _control.size());
+            } else if (_pinfo.opcode == WS_PONG) {
+                _server->_handleEvent(this, WS_EVT_PONG, nullptr, (uint8_t *)&_control[0], _control.size());
+            } else if (_pinfo.opcode == WS_DISCONNECT) {
+                if (_status == WS_CONNECTED) _queueControl(WS_DISCONNECT, (const uint8_t *)_control.data(), _control.size() >= 2 ? 2 : 0);
+                _status = WS_DISCONNECTED;
+            }
+        }
+    }
+
+    if (complete) {
+        _inPayload = false;
+        _header.clear();
+    }
+}
+
+void AsyncWebSocketClient::_onDisconnect() {
+    _status = WS_DISCONNECTED;
+    _conn = nullptr;
+    _server->_handleDisconnect(this);
+}
+
+// ----------------------------------------------------------------------------
+// AsyncWebSocket
+// ----------------------------------------------------------------------------
+
+AsyncWebSocket::AsyncWebSocket(const String &url) : _url(url) {}
+
+AsyncWebSocket::~AsyncWebSocket() {
+    closeAll();
+}
+
+size_t AsyncWebSocket::count() const {
+    AsyncLock lock(native::asyncLock());
+    size_t connected = 0;
+    for (AsyncWebSocketClient *c : _clients) {
+        if (c->status() == WS_CONNECTED) connected++;
+    }
+    return connected;
+}
+
+AsyncWebSocketClient *AsyncWebSocket::client(uint32_t id) {
+    AsyncLock lock(native::asyncLock());
+    for (AsyncWebSocketClient *c : _clients) {
+        if (c->id() == id && c->status() == WS_CONNECTED) return c;
+    }
+    return nullptr;
+}
+
+void AsyncWebSocket::close(uint32_t id, uint16_t code, const char *message) {
+    AsyncLock lock(native::asyncLock());
+    AsyncWebSocketClient *c = client(id);
+    if (c) c->close(code, message);
+}
+
+void AsyncWebSocket::closeAll(uint16_t code, const char *message) {
+    AsyncLock lock(native::asyncLock());
+    for (AsyncWebSocketClient *c : _clients) {
+        if (c->status() == WS_CONNECTED) c->close(code, message);
+    }
+}
+
+void AsyncWebSocket::cleanupClients(uint16_t maxClients) {
+    AsyncLock lock(native::asyncLock());
+    if (count() > maxClients) _clients.front()->close();
+    _cleanBuffers();
+}
+
+void AsyncWebSocket::text(uint32_t id, const char *message, size_t len) {
+    AsyncLock lock(native::asyncLock());
+    AsyncWebSocketClient *c = client(id);
+    if (c) c->text(message, len);
+}
+
+void AsyncWebSocket::text(uint32_t id, const String &message) {
+    text(id, message.c_str(), message.length());
+}
+
+void AsyncWebSocket::textAll(const char *message, size_t len) {
+    textAll(makeBuffer((uint8_t *)message, len));
+}
+
+void AsyncWebSocket::textAll(const char *message) {
+    textAll(message, strlen(message));
+}
+
+void AsyncWebSocket::textAll(const String &message) {
+    textAll(message.c_str(), message.length());
+}
+
+void AsyncWebSocket::textAll(AsyncWebSocketMessageBuffer *buffer) {
+    if (!buffer) return;
+    AsyncLock lock(native::asyncLock());
+    buffer->lock();
+    for (AsyncWebSocketClient *c : _clients) {
+        if (c->status() == WS_CONNECTED) c->text(buffer);
+    }
+    buffer->unlock();
+    _cleanBuffers();
+}
+
+void AsyncWebSocket::binaryAll(const char *message, size_t len) {
+    binaryAll(makeBuffer((uint8_t *)message, len));
+}
+
+void AsyncWebSocket::binaryAll(uint8_t *message, size_t len) {
+    binaryAll(makeBuffer(message, len));
+}
+
+void AsyncWebSocket::binaryAll(AsyncWebSocketMessageBuffer *buffer) {
+    if (!buffer) return;
+    AsyncLock lock(native::asyncLock());
+    buffer->lock();
+    for (AsyncWebSocketClient *c : _clients) {
+        if (c->status() == WS_CONNECTED) c->binary(buffer);
+    }
+    buffer->unlock();
+    _cleanBuffers();
+}
+
+AsyncWebSocketMessageBuffer *AsyncWebSocket::makeBuffer(size_t size) {
+    AsyncLock lock(native::asyncLock());
+    AsyncWebSocketMessageBuffer *buffer = new AsyncWebSocketMessageBuffer(size);
+    _buffers.push_back(buffer);
+    return buffer;
+}
+
+AsyncWebSocketMessageBuffer *AsyncWebSocket::makeBuffer(uint8_t *data, size_t size) {
+    AsyncLock lock(native::asyncLock());
+    AsyncWebSocketMessageBuffer *buffer = new AsyncWebSocketMessageBuffer(data, size);
+    _buffers.push_back(buffer);
+    return buffer;
+}
+
+void AsyncWebSocket::_cleanBuffers() {
+    AsyncLock lock(native::asyncLock());
+    for (auto it = _buffers.begin(); it != _buffers.end(); ) {
+        if ((*it)->canDelete()) {
+            delete *it;
+            it = _buffers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool AsyncWebSocket::canHandle(AsyncWebServerRequest *request) {
+    if (!_enabled || request->method() != HTTP_GET || request->url() != _url) return false;
+    AsyncWebHeader *upgrade = request->getHeader("Upgrade");
+    return upgrade && upgrade->value().equalsIgnoreCase("websocket");
+}
+
+void AsyncWebSocket::handleRequest(AsyncWebServerRequest *request) {
+    if (!request->hasHeader("Sec-WebSocket-Version") || !request->hasHeader("Sec-WebSocket-Key")) {
+        request->send(400);
+        return;
+    }
+    request->send(new AsyncWebSocketResponse(request->getHeader("Sec-WebSocket-Key")->value(), this));
+    new AsyncWebSocketClient(request, this);
+}
+
+void AsyncWebSocket::_handleDisconnect(AsyncWebSocketClient *client) {
+    _clients.remove(client);
+    _handleEvent(client, WS_EVT_DISCONNECT, nullptr, nullptr, 0);
+    delete client;
+    _cleanBuffers();
+}
+
+void AsyncWebSocket::_handleEvent(AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len) {
+    if (_eventHandler) _eventHandler(this, client, type, arg, data, len);
+}
+
+// ----------------------------------------------------------------------------
+// AsyncWebSocketResponse
+// ----------------------------------------------------------------------------
+
+AsyncWebSocketResponse::AsyncWebSocketResponse(const String &key, AsyncWebSocket *server) {
+    (void)server;
+    _code = 101;
+    _sendContentLength = false;
+    addHeader("Upgrade", "websocket");
+    addHeader("Connection", "Upgrade");
+    addHeader("Sec-WebSocket-Accept", String(native::websocketAccept(key.str())));
+}
@@ -0,0 +1,208 @@
+/**
+ * ----------------------------------------------------------------------------
+ * Native HAL: AsyncWebSocket
+ * ----------------------------------------------------------------------------
+ * RFC 6455 server side with the ESPAsyncWebServer event model: payloads are
+ * delivered as they arrive off the socket, so one frame may produce several
+ * WS_EVT_DATA events (info->index > 0) and fragmented messages show up as
+ * continuation frames, exactly as on the board.
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <deque>
+#include <list>
+
+#include "ESPAsyncWebServer.h"
+
+#ifndef WS_MAX_QUEUED_MESSAGES
+#define WS_MAX_QUEUED_MESSAGES 32
+#endif
+
+#define DEFAULT_MAX_WS_CLIENTS 8
+
+class AsyncWebSocket;
+class AsyncWebSocketClient;
+
+typedef enum { WS_CONTINUATION, WS_TEXT, WS_BINARY, WS_DISCONNECT = 0x08, WS_PING, WS_PONG } AwsFrameType;
+typedef enum { WS_DISCONNECTED, WS_CONNECTED, WS_DISCONNECTING } AwsClientStatus;
+typedef enum { WS_EVT_CONNECT, WS_EVT_DISCONNECT, WS_EVT_PONG, WS_EVT_ERROR, WS_EVT_DATA } AwsEventType;
+
+typedef struct {
+    // opcode of the message this frame belongs to (WS_TEXT or WS_BINARY) and
+    // frame number within it; like the library, only set when a frame is
+    // delivered in several events, and stale otherwise
+    uint8_t message_opcode;
+    uint32_t num;
+    // last fragment of the message
+    uint8_t final;
+    // whether the payload was masked
+    uint8_t masked;
+    // opcode of this frame (WS_CONTINUATION for later fragments)
+    uint8_t opcode;
+    // payload length of this frame
+    uint64_t len;
+    uint8_t mask[4];
+    // offset of the data passed with this event inside the frame payload
+    uint64_t index;
+} AwsFrameInfo;
+
+typedef std::function<void(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len)> AwsEventHandler;
+
+// Payload shared between the queues of several clients; deleted by the
+// server once no queued message references it and it is unlocked.
+class AsyncWebSocketMessageBuffer {
+    public:
+        AsyncWebSocketMessageBuffer();
+        explicit AsyncWebSocketMessageBuffer(size_t size);
+        AsyncWebSocketMessageBuffer(uint8_t *data, size_t size);
+        ~AsyncWebSocketMessageBuffer();
+
+        void operator++(int) { _count++; }
+        void operator--(int) { if (_count > 0) _count--; }
+        bool reserve(size_t size);
+        void lock() { _lock = true; }
+        void unlock() { _lock = false; }
+        uint8_t *get() { return _data; }
+        size_t length() const { return _len; }
+        uint32_t count() const { return _count; }
+        bool canDelete() const { return !_count && !_lock; }
+
+    private:
+        AsyncWebSocketMessageBuffer(const AsyncWebSocketMessageBuffer &);
+        AsyncWebSocketMessageBuffer &operator=(const AsyncWebSocketMessageBuffer &);
+
+        uint8_t *_data = nullptr;
+        size_t _len = 0;
+        bool _lock = false;
+        uint32_t _count = 0;
+};
+
+class AsyncWebSocketClient {
+    friend class AsyncWebSocket;
+
+    public:
+        AsyncWebSocketClient(AsyncWebServerRequest *request, AsyncWebSocket *server);
+        ~AsyncWebSocketClient();
+
+        uint32_t id() const { return _clientId; }
+        AwsClientStatus status() const { return _status; }
+        AsyncWebSocket *server() { return _server; }
+        AwsFrameInfo const &pinfo() const { return _pinfo; }
+        IPAddress remoteIP();
+        uint16_t remotePort();
+
+        void close(uint16_t code = 0, const char *message = nullptr);
+        void ping(uint8_t *data = nullptr, size_t len = 0);
+
+        bool queueIsFull();
+        size_t queueLen();
+        bool canSend();
+
+        void text(const char *message, size_t len);
+        void text(const char *message);
+        void text(uint8_t *message, size_t len);
+        void text(const String &message);
+        void text(AsyncWebSocketMessageBuffer *buffer);
+
+        void binary(const char *message, size_t len);
+        void binary(const char *message);
+        void binary(uint8_t *message, size_t len);
+        void binary(const String &message);
+        void binary(AsyncWebSocketMessageBuffer *buffer);
+
+        void *_tempObject = nullptr;
+
+        // native only, called by the network thread
+        void _onData(uint8_t *data, size_t len);
+        bool _runQueue(std::string &out);
+        void _onDisconnect();
+
+    private:
+        struct Message {
+            uint8_t opcode;
+            std::string own;
+            AsyncWebSocketMessageBuffer *shared;
+        };
+
+        void _queueMessage(uint8_t opcode, const uint8_t *data, size_t len);
+        void _queueMessage(uint8_t opcode, AsyncWebSocketMessageBuffer *buffer);
+        void _queueControl(uint8_t opcode, const uint8_t *data, size_t len);
+        void _dispatchFrameData(uint8_t *data, size_t len);
+
+        native::Connection *_conn;
+        AsyncWebSocket *_server;
+        uint32_t _clientId;
+        AwsClientStatus _status = WS_CONNECTED;
+
+        std::deque<Message> _controlQueue;
+        std::deque<Message> _messageQueue;
+
+        // incoming frame parser
+        std::string _header;
+        AwsFrameInfo _pinfo;
+        bool _inPayload = false;
+        std::string _control;
+};
+
+class AsyncWebSocket : public AsyncWebHandler {
+    public:
+        explicit AsyncWebSocket(const String &url);
+        ~AsyncWebSocket();
+
+        const char *url() const { return _url.c_str(); }
+        void enable(bool e) { _enabled = e; }
+        bool enabled() const { return _enabled; }
+
+        size_t count() const;
+        AsyncWebSocketClient *client(uint32_t id);
+        bool hasClient(uint32_t id) { return client(id) != nullptr; }
+        const std::list<AsyncWebSocketClient *> &getClients() const { return _clients; }
+
+        void close(uint32_t id, uint16_t code = 0, const char *message = nullptr);
+        void closeAll(uint16_t code = 0, const char *message = nullptr);
+        void cleanupClients(uint16_t maxClients = DEFAULT_MAX_WS_CLIENTS);
+
+        void text(uint32_t id, const char *message, size_t len);
+        void text(uint32_t id, const String &message);
+
+        void textAll(const char *message, size_t len);
+        void textAll(const char *message);
+        void textAll(const String &message);
+        void textAll(AsyncWebSocketMessageBuffer *buffer);
+
+        void binaryAll(const char *message, size_t len);
+        void binaryAll(uint8_t *message, size_t len);
+        void binaryAll(AsyncWebSocketMessageBuffer *buffer);
+
+        AsyncWebSocketMessageBuffer *makeBuffer(size_t size = 0);
+        AsyncWebSocketMessageBuffer *makeBuffer(uint8_t *data, size_t size);
+
+        void onEvent(AwsEventHandler handler) { _eventHandler = handler; }
+
+        bool canHandle(AsyncWebServerRequest *request) override;
+        void handleRequest(AsyncWebServerRequest *request) override;
+
+        // internals shared with AsyncWebSocketClient
+        uint32_t _getNextId() { return _cNextId++; }
+        void _addClient(AsyncWebSocketClient *client) { _clients.push_back(client); }
+        void _handleDisconnect(AsyncWebSocketClient *client);
+        void _handleEvent(AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len);
+        void _cleanBuffers();
+
+    private:
+        String _url;
+        std::list<AsyncWebSocketClient *> _clients;
+        std::list<AsyncWebSocketMessageBuffer *> _buffers;
+        uint32_t _cNextId = 1;
+        AwsEventHandler _eventHandler;
+        bool _enabled = true;
+};
+
+// 101 Switching Protocols reply that hands the connection to a client
+class AsyncWebSocketResponse : public AsyncWebServerResponse {
+    public:
+        AsyncWebSocketResponse(const String &key, AsyncWebSocket *server);
+        bool _sourceValid() const override { return true; }
+};
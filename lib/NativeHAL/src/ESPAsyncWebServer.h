@@ -0,0 +1,270 @@
+/**
+ * ----------------------------------------------------------------------------
+ * Native HAL: ESP Async WebServer
+ * ----------------------------------------------------------------------------
+ * Host implementation of the ESPAsyncWebServer API used by the firmware.
+ * Requests are served over loopback sockets by a single network thread that
+ * plays the part of the AsyncTCP task: every handler, body callback and
+ * WebSocket event runs there, serialized by native::asyncLock().
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <functional>
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Arduino.h"
+#include "FS.h"
+
+namespace native { class Connection; }
+
+class AsyncWebServer;
+class AsyncWebServerRequest;
+class AsyncWebServerResponse;
+class AsyncWebHeader;
+class AsyncWebParameter;
+class AsyncWebHandler;
+class AsyncStaticWebHandler;
+class AsyncCallbackWebHandler;
+class AsyncResponseStream;
+
+typedef enum {
+    HTTP_GET     = 0b00000001,
+    HTTP_POST    = 0b00000010,
+    HTTP_DELETE  = 0b00000100,
+    HTTP_PUT     = 0b00001000,
+    HTTP_PATCH   = 0b00010000,
+    HTTP_HEAD    = 0b00100000,
+    HTTP_OPTIONS = 0b01000000,
+    HTTP_ANY     = 0b01111111,
+} WebRequestMethod;
+
+typedef uint8_t WebRequestMethodComposite;
+
+#define RESPONSE_TRY_AGAIN 0xFFFFFFFF
+
+typedef std::function<void(AsyncWebServerRequest *request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)> ArBodyHandlerFunction;
+typedef std::function<bool(AsyncWebServerRequest *request)> ArRequestFilterFunction;
+typedef std::function<String(const String &)> AwsTemplateProcessor;
+typedef std::function<size_t(uint8_t *buffer, size_t maxLen, size_t index)> AwsResponseFiller;
+
+// ----------------------------------------------------------------------------
+// Headers and parameters
+// ----------------------------------------------------------------------------
+
+class AsyncWebHeader {
+    public:
+        AsyncWebHeader(const String &name, const String &value) : _name(name), _value(value) {}
+        const String &name() const { return _name; }
+        const String &value() const { return _value; }
+
+    private:
+        String _name;
+        String _value;
+};
+
+class AsyncWebParameter {
+    public:
+        AsyncWebParameter(const String &name, const String &value, bool form = false)
+            : _name(name), _value(value), _isForm(form) {}
+        const String &name() const { return _name; }
+        const String &value() const { return _value; }
+        bool isPost() const { return _isForm; }
+        bool isFile() const { return false; }
+
+    private:
+        String _name;
+        String _value;
+        bool _isForm;
+};
+
+// ----------------------------------------------------------------------------
+// Request
+// ----------------------------------------------------------------------------
+
+class AsyncWebServerRequest {
+    friend class AsyncWebServer;
+    friend class native::Connection;
+
+    public:
+        AsyncWebServerRequest(AsyncWebServer *server, native::Connection *conn);
+        ~AsyncWebServerRequest();
+
+        WebRequestMethodComposite method() const { return _method; }
+        const char *methodToString() const;
+        const String &url() const { return _url; }
+        const String &host() const { return _host; }
+        const String &contentType() const { return _contentType; }
+        size_t contentLength() const { return _contentLength; }
+        IPAddress remoteIP() const;
+
+        size_t headers() const { return _headers.size(); }
+        bool hasHeader(const String &name) const;
+        AsyncWebHeader *getHeader(const String &name) const;
+        AsyncWebHeader *getHeader(size_t num) const;
+
+        size_t params() const { return _params.size(); }
+        bool hasParam(const String &name, bool post = false, bool file = false) const;
+        AsyncWebParameter *getParam(const String &name, bool post = false, bool file = false) const;
+        AsyncWebParameter *getParam(size_t num) const;
+        const String &arg(const String &name) const;
+
+        void send(AsyncWebServerResponse *response);
+        void send(int code, const String &contentType = String(), const String &content = String());
+        void send(FS &fs, const String &path, const String &contentType = String(), bool download = false, AwsTemplateProcessor callback = nullptr);
+        void send(const String &contentType, size_t len, AwsResponseFiller callback, AwsTemplateProcessor templateCallback = nullptr);
+        void sendChunked(const String &contentType, AwsResponseFiller callback, AwsTemplateProcessor templateCallback = nullptr);
+        void send_P(int code, const String &contentType, const uint8_t *content, size_t len, AwsTemplateProcessor callback = nullptr);
+        void send_P(int code, const String &contentType, const char *content, AwsTemplateProcessor callback = nullptr);
+        void redirect(const String &url);
+
+        AsyncWebServerResponse *beginResponse(int code, const String &contentType = String(), const String &content = String());
+        AsyncWebServerResponse *beginResponse(FS &fs, const String &path, const String &contentType = String(), bool download = false, AwsTemplateProcessor callback = nullptr);
+        AsyncWebServerResponse *beginResponse(const String &contentType, size_t len, AwsResponseFiller callback, AwsTemplateProcessor templateCallback = nullptr);
+        AsyncWebServerResponse *beginChunkedResponse(const String &contentType, AwsResponseFiller callback, AwsTemplateProcessor templateCallback = nullptr);
+        AsyncResponseStream *beginResponseStream(const String &contentType, size_t bufferSize = 1460);
+        AsyncWebServerResponse *beginResponse_P(int code, const String &contentType, const uint8_t *content, size_t len, AwsTemplateProcessor callback = nullptr);
+        AsyncWebServerResponse *beginResponse_P(int code, const String &contentType, const char *content, AwsTemplateProcessor callback = nullptr);
+
+        void onDisconnect(std::function<void()> fn) { _onDisconnectFn = fn; }
+
+        // freed with free() when the request is destroyed
+        void *_tempObject = nullptr;
+
+        // native only
+        native::Connection *_connection() const { return _conn; }
+        bool _parse(const std::string &head);
+        AsyncWebServerResponse *_takeResponse();
+
+    private:
+        void _addGetParams(const String &query);
+
+        AsyncWebServer *_server;
+        native::Connection *_conn;
+        AsyncWebHandler *_handler = nullptr;
+        AsyncWebServerResponse *_response = nullptr;
+        std::function<void()> _onDisconnectFn;
+
+        WebRequestMethodComposite _method = HTTP_ANY;
+        String _url;
+        String _host;
+        String _contentType;
+        size_t _contentLength = 0;
+        std::vector<AsyncWebHeader *> _headers;
+        std::vector<AsyncWebParameter *> _params;
+};
+
+// ----------------------------------------------------------------------------
+// Handlers
+// ----------------------------------------------------------------------------
+
+class AsyncWebHandler {
+    public:
+        virtual ~AsyncWebHandler() {}
+
+        AsyncWebHandler &setFilter(ArRequestFilterFunction fn) { _filter = fn; return *this; }
+        bool filter(AsyncWebServerRequest *request) { return _filter == nullptr || _filter(request); }
+
+        virtual bool canHandle(AsyncWebServerRequest *request) { (void)request; return false; }
+        virtual void handleRequest(AsyncWebServerRequest *request) { (void)request; }
+        virtual void handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+            (void)request; (void)data; (void)len; (void)index; (void)total;
+        }
+        virtual bool isRequestHandlerTrivial() { return true; }
+
+    protected:
+        ArRequestFilterFunction _filter;
+};
+
+// ----------------------------------------------------------------------------
+// Responses
+// ----------------------------------------------------------------------------
+
+class AsyncWebServerResponse {
+    public:
+        AsyncWebServerResponse();
+        virtual ~AsyncWebServerResponse() {}
+
+        virtual void setCode(int code) { _code = code; }
+        virtual void setContentLength(size_t len) { _contentLength = len; }
+        virtual void setContentType(const String &type) { _contentType = type; }
+        virtual void addHeader(const String &name, const String &value);
+        int code() const { return _code; }
+
+        static const char *responseCodeToString(int code);
+
+        // native only: renders the complete HTTP response into `out`
+        virtual bool _sourceValid() const { return false; }
+        virtual void _assemble(std::string &out);
+
+    protected:
+        void _assembleHead(std::string &out);
+        virtual void _assembleBody(std::string &out) { (void)out; }
+
+        int _code = 0;
+        String _contentType;
+        size_t _contentLength = 0;
+        bool _sendContentLength = true;
+        bool _chunked = false;
+        std::vector<AsyncWebHeader> _headers;
+};
+
+class AsyncResponseStream : public AsyncWebServerResponse, public Print {
+    public:
+        AsyncResponseStream(const String &contentType, size_t bufferSize);
+
+        bool _sourceValid() const override { return _code < 500; }
+        void _assemble(std::string &out) override;
+        size_t write(uint8_t data) override;
+        size_t write(const uint8_t *data, size_t len) override;
+        using Print::write;
+        size_t available() const { return _content.size(); }
+
+    protected:
+        void _assembleBody(std::string &out) override;
+
+    private:
+        std::string _content;
+};
+
+// ----------------------------------------------------------------------------
+// Server
+// ----------------------------------------------------------------------------
+
+class AsyncWebServer {
+    public:
+        explicit AsyncWebServer(uint16_t port);
+        ~AsyncWebServer();
+
+        void begin();
+        void end();
+
+        AsyncWebHandler &addHandler(AsyncWebHandler *handler);
+        bool removeHandler(AsyncWebHandler *handler);
+
+        AsyncCallbackWebHandler &on(const char *uri, ArRequestHandlerFunction onRequest);
+        AsyncCallbackWebHandler &on(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest);
+        AsyncCallbackWebHandler &on(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest, ArRequestHandlerFunction onUpload, ArBodyHandlerFunction onBody);
+        AsyncStaticWebHandler &serveStatic(const char *uri, fs::FS &fs, const char *path, const char *cache_control = nullptr);
+
+        void onNotFound(ArRequestHandlerFunction fn) { _notFound = fn; }
+        void reset();
+
+        // native only: port actually bound on the host
+        uint16_t port() const { return _port; }
+        void _handleRequest(AsyncWebServerRequest *request, uint8_t *body, size_t len);
+
+    private:
+        uint16_t _port;
+        std::list<AsyncWebHandler *> _handlers;
+        ArRequestHandlerFunction _notFound;
+};
+
+#include "WebHandlerImpl.h"
+#include "WebResponseImpl.h"
+#include "AsyncWebSocket.h"
@@ -0,0 +1,44 @@
+#include "Esp.h"
+
+#include <atomic>
+#include <chrono>
+#include <malloc.h>
+
+namespace {
+
+size_t heapInUse() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 info = mallinfo2();
+#else
+    struct mallinfo info = mallinfo();
+#endif
+    return info.uordblks + info.hblkhd;
+}
+
+// what the host runtime had allocated before the firmware started
+const size_t heapAtStart = heapInUse();
+std::atomic<uint32_t> minFreeHeap(NATIVE_HEAP_SIZE);
+
+}
+
+EspClass ESP;
+
+uint32_t EspClass::getCycleCount() {
+    const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    return (uint32_t)(ns * NATIVE_CPU_FREQ_MHZ / 1000);
+}
+
+uint32_t EspClass::getFreeHeap() {
+    const size_t inUse = heapInUse();
+    const size_t used = inUse > heapAtStart ? inUse - heapAtStart : 0;
+    const uint32_t free = used < NATIVE_HEAP_SIZE ? NATIVE_HEAP_SIZE - used : 0;
+    uint32_t min = minFreeHeap.load();
+    while (free < min && !minFreeHeap.compare_exchange_weak(min, free)) {}
+    return free;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+    getFreeHeap();
+    return minFreeHeap.load();
+}
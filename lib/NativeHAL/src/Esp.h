@@ -0,0 +1,30 @@
+/**
+ * ----------------------------------------------------------------------------
+ * Native HAL: ESP system information
+ * ----------------------------------------------------------------------------
+ * The ESP object of the arduino-esp32 core. The cycle counter ticks at the
+ * simulated CPU clock from the host monotonic clock. Heap figures simulate
+ * the board's heap of NATIVE_HEAP_SIZE bytes from what the process has
+ * allocated since start; the minimum is sampled whenever they are read.
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#define NATIVE_CPU_FREQ_MHZ 240
+#define NATIVE_HEAP_SIZE    327680
+
+class EspClass {
+    public:
+        uint32_t getCycleCount();
+        uint32_t getCpuFreqMHz() { return NATIVE_CPU_FREQ_MHZ; }
+
+        uint32_t getHeapSize() { return NATIVE_HEAP_SIZE; }
+        uint32_t getFreeHeap();
+        uint32_t getMinFreeHeap();
+        uint32_t getMaxAllocHeap() { return getFreeHeap(); }
+};
+
+extern EspClass ESP;
@@ -0,0 +1,129 @@
+#include "FS.h"
+#include "SPIFFS.h"
+
+#include <cstdlib>
+#include <dirent.h>
+#include <sys/stat.h>
+
+namespace fs {
+
+namespace {
+
+void closeHandle(FILE *handle) {
+    if (handle) fclose(handle);
+}
+
+}
+
+File::File(FILE *handle, const String &path) : _handle(handle, closeHandle), _path(path) {}
+
+size_t File::write(uint8_t c) {
+    return _handle ? fwrite(&c, 1, 1, _handle.get()) : 0;
+}
+
+size_t File::write(const uint8_t *buffer, size_t size) {
+    return _handle ? fwrite(buffer, 1, size, _handle.get()) : 0;
+}
+
+int File::available() {
+    return _handle ? (int)(size() - position()) : 0;
+}
+
+int File::read() {
+    return _handle ? fgetc(_handle.get()) : -1;
+}
+
+size_t File::read(uint8_t *buffer, size_t size) {
+    return _handle ? fread(buffer, 1, size, _handle.get()) : 0;
+}
+
+String File::readString() {
+    std::string out;
+    char chunk[256];
+    size_t n;
+    while ((n = read((uint8_t *)chunk, sizeof(chunk))) > 0) out.append(chunk, n);
+    return String(out);
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+    static const int whence[] = { SEEK_SET, SEEK_CUR, SEEK_END };
+    return _handle && fseek(_handle.get(), pos, whence[mode]) == 0;
+}
+
+size_t File::position() const {
+    return _handle ? (size_t)ftell(_handle.get()) : 0;
+}
+
+size_t File::size() const {
+    if (!_handle) return 0;
+    struct stat st;
+    return fstat(fileno(_handle.get()), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+void File::flush() {
+    if (_handle) fflush(_handle.get());
+}
+
+void File::close() {
+    _handle.reset();
+}
+
+File FS::open(const String &path, const char *mode) {
+    struct stat st;
+    std::string host = hostPath(path);
+    if (mode[0] == 'r' && (stat(host.c_str(), &st) != 0 || !S_ISREG(st.st_mode))) return File();
+    FILE *handle = fopen(host.c_str(), mode[0] == 'r' ? "rb" : mode[0] == 'a' ? "ab" : "wb");
+    return handle ? File(handle, path) : File();
+}
+
+bool FS::exists(const String &path) {
+    struct stat st;
+    return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const String &path) {
+    return ::remove(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const String &from, const String &to) {
+    return ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+std::string FS::hostPath(const String &path) const {
+    std::string relative = path.str();
+    // keep lookups inside the volume
+    if (relative.find("..") != std::string::npos) relative = "/.invalid";
+    if (relative.empty() || relative[0] != '/') relative.insert(0, "/");
+    return _root + relative;
+}
+
+SPIFFSFS::SPIFFSFS() : FS(getenv("NATIVE_SPIFFS_DIR") ? getenv("NATIVE_SPIFFS_DIR") : "data") {}
+
+bool SPIFFSFS::begin(bool formatOnFail, const char *basePath, uint8_t maxOpenFiles, const char *partitionLabel) {
+    (void)formatOnFail; (void)basePath; (void)maxOpenFiles; (void)partitionLabel;
+    struct stat st;
+    _mounted = stat(_root.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+    return _mounted;
+}
+
+size_t SPIFFSFS::totalBytes() {
+    // size of the default 1.5 MB spiffs partition once formatted
+    return 1374476;
+}
+
+size_t SPIFFSFS::usedBytes() {
+    size_t used = 0;
+    DIR *dir = opendir(_root.c_str());
+    if (!dir) return 0;
+    while (struct dirent *entry = readdir(dir)) {
+        struct stat st;
+        std::string path = _root + "/" + entry->d_name;
+        if (stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode)) used += st.st_size;
+    }
+    closedir(dir);
+    return used;
+}
+
+}
+
+fs::SPIFFSFS SPIFFS;
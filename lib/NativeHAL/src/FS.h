@@ -0,0 +1,80 @@
+/**
+ * ----------------------------------------------------------------------------
+ * Native HAL: file system
+ * ----------------------------------------------------------------------------
+ * fs::FS and fs::File backed by a directory on the host. Paths are absolute
+ * inside the volume ("/index.html") and resolved against its root directory.
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include "Print.h"
+#include "WString.h"
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class File : public Print {
+    public:
+        File() {}
+        File(FILE *handle, const String &path);
+
+        size_t write(uint8_t c) override;
+        size_t write(const uint8_t *buffer, size_t size) override;
+        using Print::write;
+
+        int available();
+        int read();
+        size_t read(uint8_t *buffer, size_t size);
+        size_t readBytes(char *buffer, size_t length) { return read((uint8_t *)buffer, length); }
+        String readString();
+        bool seek(uint32_t pos, SeekMode mode = SeekSet);
+        size_t position() const;
+        size_t size() const;
+        void flush() override;
+        void close();
+
+        const char *name() const { return _path.c_str(); }
+        bool isDirectory() const { return false; }
+        operator bool() const { return (bool)_handle; }
+
+    private:
+        std::shared_ptr<FILE> _handle;
+        String _path;
+};
+
+class FS {
+    public:
+        explicit FS(const std::string &root) : _root(root) {}
+        virtual ~FS() {}
+
+        File open(const String &path, const char *mode = FILE_READ);
+        File open(const char *path, const char *mode = FILE_READ) { return open(String(path), mode); }
+        bool exists(const String &path);
+        bool exists(const char *path) { return exists(String(path)); }
+        bool remove(const String &path);
+        bool rename(const String &from, const String &to);
+
+    protected:
+        std::string hostPath(const String &path) const;
+        std::string _root;
+};
+
+}
+
+using fs::FS;
+using fs::File;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
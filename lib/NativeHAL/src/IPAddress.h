@@ -0,0 +1,33 @@
+/**
+ * ----------------------------------------------------------------------------
+ * Native HAL: IPAddress
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+#include "WString.h"
+
+class IPAddress {
+    public:
+        IPAddress() : _octets{0, 0, 0, 0} {}
+        IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _octets{a, b, c, d} {}
+
+        uint8_t operator[](int index) const { return _octets[index]; }
+        bool operator==(const IPAddress &rhs) const {
+            return _octets[0] == rhs._octets[0] && _octets[1] == rhs._octets[1]
+                && _octets[2] == rhs._octets[2] && _octets[3] == rhs._octets[3];
+        }
+
+        String toString() const {
+            char buf[16];
+            snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _octets[0], _octets[1], _octets[2], _octets[3]);
+            return String(buf);
+        }
+
+    private:
+        uint8_t _octets[4];
+};
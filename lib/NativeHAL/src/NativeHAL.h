@@ -0,0 +1,47 @@
+/**
+ * ----------------------------------------------------------------------------
+ * Native HAL: simulation controls
+ * ----------------------------------------------------------------------------
+ * Hooks that let a host harness drive the simulated hardware: inject input
+ * levels, observe outputs and count pin transitions.
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace native {
+
+const uint8_t PIN_COUNT = 40;
+
+// forces the level seen by digitalRead() on an input pin
+void setPinLevel(uint8_t pin, uint8_t level);
+
+// last level written to a pin with digitalWrite()
+uint8_t pinLevel(uint8_t pin);
+
+// number of LOW -> HIGH transitions seen on a pin since start
+uint32_t risingEdges(uint8_t pin);
+
+// sleep between loop() iterations, from NATIVE_LOOP_PERIOD_US (default 1000)
+uint32_t loopPeriodMicros();
+
+// How late the interrupts of a hardware timer fired against their ideal
+// schedule. An interrupt due while the previous one still ran is an overrun.
+struct TimerStats {
+    uint64_t interrupts;
+    uint64_t overruns;
+    uint32_t meanLateNs;
+    uint32_t p50LateNs;
+    uint32_t p99LateNs;
+    uint32_t maxLateNs;
+};
+
+TimerStats timerStats(uint8_t timer);
+void resetTimerStats(uint8_t timer);
+
+// Preferences values written since start, to check write coalescing
+uint32_t nvsWrites();
+
+}
@@ -0,0 +1,29 @@
+/**
+ * ----------------------------------------------------------------------------
+ * Native HAL: entry point
+ * ----------------------------------------------------------------------------
+ * Plays the part of the arduino-esp32 loopTask: setup() once, then loop()
+ * forever. Harnesses that drive setup()/loop() themselves (benchmarks) build
+ * with NATIVE_HAL_NO_MAIN.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef NATIVE_HAL_NO_MAIN
+
+#include "Arduino.h"
+#include "NativeHAL.h"
+
+#include <cstdio>
+
+int main() {
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+
+    setup();
+    const uint32_t period = native::loopPeriodMicros();
+    for (;;) {
+        loop();
+        if (period) delayMicroseconds(period);
+    }
+}
+
+#endif
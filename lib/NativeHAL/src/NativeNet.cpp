@@ -0,0 +1,476 @@
+#include "NativeNet.h"
+#include "AsyncTCP.h"
+#include "ESPAsyncWebServer.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <list>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace native {
+
+namespace {
+
+// biggest request head accepted, same order as the board can buffer
+const size_t MAX_REQUEST_HEAD = 8192;
+const size_t MAX_REQUEST_BODY = 65536;
+const int POLL_TIMEOUT_MS = 100;
+
+struct Listener {
+    int fd;
+    AsyncWebServer *server;
+};
+
+class Loop {
+    public:
+        static Loop &instance() {
+            static Loop loop;
+            return loop;
+        }
+
+        bool listen(AsyncWebServer *server, uint16_t port);
+        void unlisten(AsyncWebServer *server);
+        bool listen(AsyncServer *server, uint16_t port);
+        void unlisten(AsyncServer *server);
+        int connectLocal(uint16_t port);
+        void wake();
+
+    private:
+        Loop();
+        void start();
+        void run();
+        void acceptFrom(const Listener &listener);
+        bool readFrom(Connection *conn);
+        bool writeTo(Connection *conn);
+        void pump(Connection *conn);
+        void handleHttp(Connection *conn);
+        void drop(Connection *conn);
+
+        std::vector<Listener> _listeners;
+        std::vector<AsyncServer *> _localServers;
+        std::list<Connection *> _connections;
+        int _wakePipe[2];
+        std::thread::id _threadId;
+        bool _started = false;
+};
+
+Loop::Loop() {
+    if (pipe(_wakePipe) == 0) {
+        fcntl(_wakePipe[0], F_SETFL, O_NONBLOCK);
+        fcntl(_wakePipe[1], F_SETFL, O_NONBLOCK);
+    }
+}
+
+bool Loop::listen(AsyncWebServer *server, uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(fd, (sockaddr *)&addr, sizeof(addr)) != 0 || ::listen(fd, 64) != 0) {
+        close(fd);
+        return false;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+
+    std::lock_guard<AsyncMutex> lock(asyncLock());
+    _listeners.push_back({ fd, server });
+    start();
+    wake();
+    return true;
+}
+
+void Loop::start() {
+    if (_started) return;
+    _started = true;
+    std::thread(&Loop::run, this).detach();
+}
+
+void Loop::unlisten(AsyncWebServer *server) {
+    std::lock_guard<AsyncMutex> lock(asyncLock());
+    for (auto it = _listeners.begin(); it != _listeners.end(); ) {
+        if (it->server == server) {
+            close(it->fd);
+            it = _listeners.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (Connection *conn : _connections) {
+        if (conn->server == server) conn->closeWhenFlushed();
+    }
+    wake();
+}
+
+bool Loop::listen(AsyncServer *server, uint16_t port) {
+    std::lock_guard<AsyncMutex> lock(asyncLock());
+    for (AsyncServer *registered : _localServers) {
+        if (registered->_getPort() == port) return registered == server;
+    }
+    _localServers.push_back(server);
+    return true;
+}
+
+void Loop::unlisten(AsyncServer *server) {
+    std::lock_guard<AsyncMutex> lock(asyncLock());
+    for (auto it = _localServers.begin(); it != _localServers.end(); ) {
+        if (*it == server) it = _localServers.erase(it);
+        else ++it;
+    }
+}
+
+int Loop::connectLocal(uint16_t port) {
+    std::lock_guard<AsyncMutex> lock(asyncLock());
+    AsyncServer *server = nullptr;
+    for (AsyncServer *registered : _localServers) {
+        if (registered->_getPort() == port) server = registered;
+    }
+    int fds[2];
+    if (!server || socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) return -1;
+    fcntl(fds[1], F_SETFL, O_NONBLOCK);
+
+    Connection *conn = new Connection(fds[1], nullptr, IPAddress(127, 0, 0, 1), 0);
+    conn->state = Connection::Raw;
+    conn->tcp = new AsyncClient(conn);
+    _connections.push_back(conn);
+    server->_onClient(conn->tcp);
+    start();
+    wake();
+    return fds[0];
+}
+
+void Loop::wake() {
+    if (std::this_thread::get_id() == _threadId) return;
+    char c = 0;
+    ssize_t ignored = write(_wakePipe[1], &c, 1);
+    (void)ignored;
+}
+
+void Loop::run() {
+    std::vector<pollfd> fds;
+    std::vector<Connection *> polled;
+    std::vector<Listener> listeners;
+    _threadId = std::this_thread::get_id();
+
+    for (;;) {
+        fds.clear();
+        polled.clear();
+        listeners.clear();
+        fds.push_back({ _wakePipe[0], POLLIN, 0 });
+        {
+            std::lock_guard<AsyncMutex> lock(asyncLock());
+            for (const Listener &listener : _listeners) {
+                fds.push_back({ listener.fd, POLLIN, 0 });
+                listeners.push_back(listener);
+            }
+            for (Connection *conn : _connections) {
+                pump(conn);
+                short events = POLLIN;
+                if (conn->hasPendingOutput()) events |= POLLOUT;
+                fds.push_back({ conn->fd, events, 0 });
+                polled.push_back(conn);
+            }
+        }
+
+        if (poll(fds.data(), fds.size(), POLL_TIMEOUT_MS) < 0 && errno != EINTR) continue;
+
+        std::lock_guard<AsyncMutex> lock(asyncLock());
+
+        char drain[64];
+        while (read(_wakePipe[0], drain, sizeof(drain)) > 0) {}
+
+        for (size_t i = 0; i < listeners.size(); i++) {
+            if (fds[1 + i].revents & POLLIN) acceptFrom(listeners[i]);
+        }
+
+        size_t index = 1 + listeners.size();
+        for (size_t i = 0; i < polled.size(); i++) {
+            Connection *conn = polled[i];
+            short revents = fds[index + i].revents;
+            bool alive = true;
+            if (revents & POLLIN) alive = readFrom(conn);
+            else if (revents & (POLLERR | POLLHUP | POLLNVAL)) alive = false;
+            if (alive) {
+                pump(conn);
+                if (conn->hasPendingOutput()) alive = writeTo(conn);
+            }
+            if (alive && conn->closing && !conn->hasPendingOutput()) alive = false;
+            if (!alive) drop(conn);
+        }
+    }
+}
+
+void Loop::acceptFrom(const Listener &listener) {
+    for (;;) {
+        sockaddr_in addr;
+        socklen_t len = sizeof(addr);
+        int fd = accept(listener.fd, (sockaddr *)&addr, &len);
+        if (fd < 0) return;
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        int yes = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        uint32_t ip = ntohl(addr.sin_addr.s_addr);
+        _connections.push_back(new Connection(fd, listener.server,
+            IPAddress(ip >> 24, ip >> 16, ip >> 8, ip), ntohs(addr.sin_port)));
+    }
+}
+
+bool Loop::readFrom(Connection *conn) {
+    uint8_t buf[1460];
+    for (;;) {
+        ssize_t n = recv(conn->fd, buf, sizeof(buf), 0);
+        if (n == 0) return false;
+        if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+        if (conn->state == Connection::WebSocket) {
+            // every segment is its own data event, like an AsyncTCP packet
+            conn->client->_onData(buf, n);
+        } else if (conn->state == Connection::Raw) {
+            if (conn->tcp) conn->tcp->_onData(buf, n);
+        } else if (conn->state == Connection::Http) {
+            conn->in.append((const char *)buf, n);
+            handleHttp(conn);
+        }
+        if (conn->state == Connection::Closing) return true;
+    }
+}
+
+bool Loop::writeTo(Connection *conn) {
+    while (conn->hasPendingOutput()) {
+        ssize_t n = ::send(conn->fd, conn->out.data() + conn->outOffset, conn->out.size() - conn->outOffset, MSG_NOSIGNAL);
+        if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        conn->outOffset += n;
+    }
+    conn->out.clear();
+    conn->outOffset = 0;
+    return true;
+}
+
+void Loop::pump(Connection *conn) {
+    // one WebSocket message in flight at a time, the rest waits in the client
+    // queue so that queueLen() reflects a slow reader
+    if (conn->state == Connection::WebSocket && conn->client && !conn->hasPendingOutput()) {
+        conn->client->_runQueue(conn->out);
+        if (conn->client->status() == WS_DISCONNECTED) conn->closeWhenFlushed();
+    }
+}
+
+void Loop::handleHttp(Connection *conn) {
+    size_t headEnd = conn->in.find("\r\n\r\n");
+    if (headEnd == std::string::npos) {
+        if (conn->in.size() > MAX_REQUEST_HEAD) {
+            AsyncBasicResponse response(431);
+            std::string out;
+            response._assemble(out);
+            conn->send(out);
+            conn->state = Connection::Closing;
+            conn->closeWhenFlushed();
+        }
+        return;
+    }
+
+    AsyncWebServerRequest *request = new AsyncWebServerRequest(conn->server, conn);
+    bool valid = request->_parse(conn->in.substr(0, headEnd + 2));
+    size_t bodyStart = headEnd + 4;
+    if (valid && request->contentLength() > MAX_REQUEST_BODY) valid = false;
+    if (valid && conn->in.size() < bodyStart + request->contentLength()) {
+        // wait for the rest of the body
+        delete request;
+        return;
+    }
+
+    std::string out;
+    if (valid) {
+        std::string body = conn->in.substr(bodyStart, request->contentLength());
+        conn->in.erase(0, bodyStart + request->contentLength());
+        conn->server->_handleRequest(request, (uint8_t *)&body[0], body.size());
+        AsyncWebServerResponse *response = request->_takeResponse();
+        if (!response) response = new AsyncBasicResponse(500);
+        response->_assemble(out);
+        delete response;
+    } else {
+        AsyncBasicResponse response(400);
+        response._assemble(out);
+    }
+    delete request;
+    conn->send(out);
+
+    if (conn->client) {
+        conn->state = Connection::WebSocket;
+        if (!conn->in.empty()) {
+            std::string rest;
+            rest.swap(conn->in);
+            conn->client->_onData((uint8_t *)&rest[0], rest.size());
+        }
+    } else {
+        conn->state = Connection::Closing;
+        conn->closeWhenFlushed();
+    }
+}
+
+void Loop::drop(Connection *conn) {
+    _connections.remove(conn);
+    if (conn->client) conn->client->_onDisconnect();
+    if (conn->tcp) conn->tcp->_onDisconnect();
+    close(conn->fd);
+    delete conn;
+}
+
+// ----------------------------------------------------------------------------
+// SHA-1 for the WebSocket handshake
+// ----------------------------------------------------------------------------
+
+uint32_t rol(uint32_t value, unsigned bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+std::string sha1(const std::string &message) {
+    uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+
+    std::string data = message;
+    uint64_t bits = (uint64_t)message.size() * 8;
+    data.push_back((char)0x80);
+    while (data.size() % 64 != 56) data.push_back(0);
+    for (int i = 7; i >= 0; i--) data.push_back((char)(bits >> (i * 8)));
+
+    for (size_t chunk = 0; chunk < data.size(); chunk += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            const uint8_t *p = (const uint8_t *)data.data() + chunk + i * 4;
+            w[i] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+        }
+        for (int i = 16; i < 80; i++) w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+            else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+            else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+            uint32_t temp = rol(a, 5) + f + e + k + w[i];
+            e = d; d = c; c = rol(b, 30); b = a; a = temp;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+    }
+
+    std::string digest;
+    for (int i = 0; i < 5; i++) {
+        for (int j = 3; j >= 0; j--) digest.push_back((char)(h[i] >> (j * 8)));
+    }
+    return digest;
+}
+
+std::string base64(const std::string &data) {
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    size_t i = 0;
+    for (; i + 2 < data.size(); i += 3) {
+        uint32_t n = (uint8_t)data[i] << 16 | (uint8_t)data[i + 1] << 8 | (uint8_t)data[i + 2];
+        out += table[n >> 18]; out += table[(n >> 12) & 63]; out += table[(n >> 6) & 63]; out += table[n & 63];
+    }
+    if (i + 1 == data.size()) {
+        uint32_t n = (uint8_t)data[i] << 16;
+        out += table[n >> 18]; out += table[(n >> 12) & 63]; out += "==";
+    } else if (i + 2 == data.size()) {
+        uint32_t n = (uint8_t)data[i] << 16 | (uint8_t)data[i + 1] << 8;
+        out += table[n >> 18]; out += table[(n >> 12) & 63]; out += table[(n >> 6) & 63]; out += '=';
+    }
+    return out;
+}
+
+}
+
+void AsyncMutex::lock() {
+    if (owner.load() == std::this_thread::get_id()) {
+        depth++;
+        return;
+    }
+    mutex.lock();
+    owner.store(std::this_thread::get_id());
+    depth = 1;
+}
+
+void AsyncMutex::unlock() {
+    if (--depth) return;
+    owner.store(std::thread::id());
+    mutex.unlock();
+}
+
+unsigned AsyncMutex::releaseAll() {
+    if (owner.load() != std::this_thread::get_id()) return 0;
+    const unsigned held = depth;
+    depth = 0;
+    owner.store(std::thread::id());
+    mutex.unlock();
+    return held;
+}
+
+void AsyncMutex::reacquire(unsigned held) {
+    if (!held) return;
+    mutex.lock();
+    owner.store(std::this_thread::get_id());
+    depth = held;
+}
+
+AsyncMutex &asyncLock() {
+    static AsyncMutex lock;
+    return lock;
+}
+
+void Connection::send(const std::string &data) {
+    send((const uint8_t *)data.data(), data.size());
+}
+
+void Connection::send(const uint8_t *data, size_t len) {
+    if (outOffset && outOffset == out.size()) {
+        out.clear();
+        outOffset = 0;
+    }
+    out.append((const char *)data, len);
+    Loop::instance().wake();
+}
+
+bool listen(AsyncWebServer *server, uint16_t port) {
+    return Loop::instance().listen(server, port);
+}
+
+void unlisten(AsyncWebServer *server) {
+    Loop::instance().unlisten(server);
+}
+
+bool listen(AsyncServer *server, uint16_t port) {
+    return Loop::instance().listen(server, port);
+}
+
+void unlisten(AsyncServer *server) {
+    Loop::instance().unlisten(server);
+}
+
+int connectLocal(uint16_t port) {
+    return Loop::instance().connectLocal(port);
+}
+
+void wake() {
+    Loop::instance().wake();
+}
+
+std::string websocketAccept(const std::string &key) {
+    return base64(sha1(key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"));
+}
+
+}
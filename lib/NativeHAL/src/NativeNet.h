@@ -0,0 +1,100 @@
+/**
+ * ----------------------------------------------------------------------------
+ * Native HAL: loopback network core
+ * ----------------------------------------------------------------------------
+ * A poll() loop on its own thread accepts connections for every started
+ * AsyncWebServer, parses HTTP requests, and hands upgraded connections to
+ * their AsyncWebSocketClient. Outgoing data is buffered per connection and
+ * written as the socket drains. Raw AsyncServers are only reachable from
+ * within the process, through connectLocal().
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "IPAddress.h"
+
+class AsyncClient;
+class AsyncServer;
+class AsyncWebServer;
+class AsyncWebSocketClient;
+
+namespace native {
+
+// A recursive mutex that yield() and delay() give up while they wait, the
+// way a FreeRTOS task gives up the CPU: a handler waiting for loop() to act
+// would otherwise hold the lock loop() needs to get there.
+class AsyncMutex {
+    public:
+        void lock();
+        void unlock();
+
+        // releases every level the calling thread holds and returns how
+        // many, 0 when it holds none; reacquire() takes them back
+        unsigned releaseAll();
+        void reacquire(unsigned depth);
+
+    private:
+        std::mutex mutex;
+        std::atomic<std::thread::id> owner{std::thread::id()};
+        unsigned depth = 0;
+};
+
+// Serializes everything the AsyncTCP task would run: request handlers,
+// WebSocket events and queue updates. Code on the loop() side that touches
+// server or client state takes it as well.
+AsyncMutex &asyncLock();
+
+class Connection {
+    public:
+        // Raw: a connection of an AsyncServer, its data handed to tcp as is
+        enum State { Http, WebSocket, Raw, Closing };
+
+        Connection(int fd, AsyncWebServer *server, const IPAddress &ip, uint16_t port)
+            : fd(fd), server(server), remoteIP(ip), remotePort(port) {}
+
+        // queues bytes for the socket; safe from any thread holding asyncLock()
+        void send(const std::string &data);
+        void send(const uint8_t *data, size_t len);
+        // closes the socket once everything queued has been written
+        void closeWhenFlushed() { closing = true; }
+        bool hasPendingOutput() const { return outOffset < out.size(); }
+
+        int fd;
+        AsyncWebServer *server;
+        IPAddress remoteIP;
+        uint16_t remotePort;
+
+        State state = Http;
+        AsyncWebSocketClient *client = nullptr;
+        AsyncClient *tcp = nullptr;
+        std::string in;
+        std::string out;
+        size_t outOffset = 0;
+        bool closing = false;
+};
+
+// starts serving `server` on the given port, returns false if it is taken
+bool listen(AsyncWebServer *server, uint16_t port);
+void unlisten(AsyncWebServer *server);
+
+// registers an AsyncServer for connectLocal(), false if the port is taken
+bool listen(AsyncServer *server, uint16_t port);
+void unlisten(AsyncServer *server);
+// joins the AsyncServer registered on port through a socket pair and
+// returns the caller's blocking end, -1 when there is none
+int connectLocal(uint16_t port);
+
+// interrupts poll() so that newly queued output gets written
+void wake();
+
+// WebSocket handshake: base64(sha1(key + GUID))
+std::string websocketAccept(const std::string &key);
+
+}
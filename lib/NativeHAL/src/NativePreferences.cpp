@@ -0,0 +1,100 @@
+#include "Preferences.h"
+#include "NativeHAL.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+std::atomic<uint32_t> writes(0);
+
+std::string root() {
+    const char *env = getenv("NATIVE_NVS_DIR");
+    return env ? env : ".nvs";
+}
+
+}
+
+bool Preferences::begin(const char *name, bool readOnly) {
+    if (!name || !*name) return false;
+    _dir = root() + "/" + name;
+    mkdir(root().c_str(), 0755);
+    mkdir(_dir.c_str(), 0755);
+    _started = true;
+    _readOnly = readOnly;
+    return true;
+}
+
+void Preferences::end() {
+    _started = false;
+}
+
+std::string Preferences::path(const char *key) const {
+    return _dir + "/" + key;
+}
+
+bool Preferences::clear() {
+    if (!_started || _readOnly) return false;
+    DIR *dir = opendir(_dir.c_str());
+    if (!dir) return false;
+    while (dirent *entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') unlink(path(entry->d_name).c_str());
+    }
+    closedir(dir);
+    return true;
+}
+
+bool Preferences::remove(const char *key) {
+    if (!_started || _readOnly) return false;
+    return unlink(path(key).c_str()) == 0;
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t len) {
+    if (!_started || _readOnly || !key || !value || !len) return 0;
+    const std::string target = path(key);
+    const std::string temp = target + ".tmp";
+    FILE *file = fopen(temp.c_str(), "wb");
+    if (!file) return 0;
+    const size_t written = fwrite(value, 1, len, file);
+    fclose(file);
+    if (written != len || rename(temp.c_str(), target.c_str()) != 0) return 0;
+    writes++;
+    return len;
+}
+
+size_t Preferences::getBytesLength(const char *key) {
+    struct stat st;
+    if (!_started || stat(path(key).c_str(), &st) != 0) return 0;
+    return st.st_size;
+}
+
+size_t Preferences::getBytes(const char *key, void *buf, size_t maxLen) {
+    const size_t len = getBytesLength(key);
+    if (!len || !buf || len > maxLen) return 0;
+    FILE *file = fopen(path(key).c_str(), "rb");
+    if (!file) return 0;
+    const size_t read = fread(buf, 1, len, file);
+    fclose(file);
+    return read == len ? len : 0;
+}
+
+size_t Preferences::putUInt(const char *key, uint32_t value) {
+    return putBytes(key, &value, sizeof(value));
+}
+
+uint32_t Preferences::getUInt(const char *key, uint32_t defaultValue) {
+    uint32_t value;
+    return getBytes(key, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+}
+
+namespace native {
+
+uint32_t nvsWrites() {
+    return writes.load();
+}
+
+}
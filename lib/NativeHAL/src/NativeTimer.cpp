@@ -0,0 +1,199 @@
+#include "Arduino.h"
+#include "NativeHAL.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+typedef std::chrono::steady_clock Clock;
+
+struct hw_timer_s {
+    uint8_t num;
+    uint16_t divider;
+    uint64_t alarm = 0;
+    bool autoreload = true;
+    void (*fn)(void) = nullptr;
+    std::atomic<bool> enabled{false};
+    std::thread thread;
+};
+
+namespace {
+
+const uint8_t TIMER_COUNT = 4;
+const uint32_t APB_CLOCK_MHZ = 80;
+// lateness histogram with 1 us buckets, the last one open-ended
+const uint32_t LATE_BUCKETS = 1000;
+
+struct Histogram {
+    std::mutex mutex;
+    uint64_t interrupts = 0;
+    uint64_t overruns = 0;
+    uint64_t totalLateNs = 0;
+    uint32_t maxLateNs = 0;
+    uint32_t buckets[LATE_BUCKETS + 1] = {};
+};
+
+Histogram histograms[TIMER_COUNT];
+
+uint32_t envMicros(const char *name) {
+    const char *env = getenv(name);
+    return env ? strtoul(env, nullptr, 10) : 0;
+}
+
+void record(uint8_t num, uint32_t lateNs, uint32_t missed) {
+    Histogram &h = histograms[num];
+    std::lock_guard<std::mutex> lock(h.mutex);
+    h.interrupts++;
+    h.overruns += missed;
+    h.totalLateNs += lateNs;
+    if (lateNs > h.maxLateNs) h.maxLateNs = lateNs;
+    uint32_t bucket = lateNs / 1000;
+    h.buckets[bucket < LATE_BUCKETS ? bucket : LATE_BUCKETS]++;
+}
+
+uint32_t percentile(const Histogram &h, uint64_t rank) {
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i <= LATE_BUCKETS; i++) {
+        seen += h.buckets[i];
+        if (seen > rank) return i < LATE_BUCKETS ? i * 1000 : h.maxLateNs;
+    }
+    return h.maxLateNs;
+}
+
+void report(uint8_t num) {
+    native::TimerStats stats = native::timerStats(num);
+    Serial.printf("[native] timer %u: %llu interrupts, late mean %.1f p50 %.1f p99 %.1f max %.1f us, %llu overruns\n",
+                  num, (unsigned long long)stats.interrupts,
+                  stats.meanLateNs / 1000.0, stats.p50LateNs / 1000.0,
+                  stats.p99LateNs / 1000.0, stats.maxLateNs / 1000.0,
+                  (unsigned long long)stats.overruns);
+}
+
+// Sleeping alone wakes up tens of microseconds late on a desktop kernel;
+// NATIVE_TIMER_SPIN_US trades a busy core for the accuracy of the board.
+void run(hw_timer_t *timer) {
+    sched_param param;
+    param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+
+    const std::chrono::nanoseconds period(timer->alarm * timer->divider * 1000 / APB_CLOCK_MHZ);
+    const std::chrono::microseconds spin(envMicros("NATIVE_TIMER_SPIN_US"));
+    const std::chrono::seconds reportEvery(envMicros("NATIVE_TIMER_STATS_S"));
+    if (period.count() == 0) return;
+
+    Clock::time_point next = Clock::now() + period;
+    Clock::time_point nextReport = Clock::now() + reportEvery;
+    while (timer->enabled) {
+        std::this_thread::sleep_until(next - spin);
+        Clock::time_point now = Clock::now();
+        while (now < next) now = Clock::now();
+
+        // interrupts that fell due meanwhile are merged, like a pending flag
+        uint32_t missed = 0;
+        uint64_t lateNs = std::chrono::duration_cast<std::chrono::nanoseconds>(now - next).count();
+        while (next + period <= now) {
+            next += period;
+            missed++;
+        }
+        record(timer->num, lateNs > UINT32_MAX ? UINT32_MAX : (uint32_t)lateNs, missed);
+
+        if (timer->fn) timer->fn();
+        if (!timer->autoreload) {
+            timer->enabled = false;
+            break;
+        }
+        next += period;
+
+        if (reportEvery.count() && now >= nextReport) {
+            report(timer->num);
+            nextReport = now + reportEvery;
+        }
+    }
+}
+
+}
+
+hw_timer_t *timerBegin(uint8_t num, uint16_t divider, bool countUp) {
+    (void)countUp;
+    if (num >= TIMER_COUNT) return nullptr;
+    hw_timer_t *timer = new hw_timer_t();
+    timer->num = num;
+    timer->divider = divider ? divider : 1;
+    return timer;
+}
+
+void timerEnd(hw_timer_t *timer) {
+    if (!timer) return;
+    timerAlarmDisable(timer);
+    delete timer;
+}
+
+void timerAttachInterrupt(hw_timer_t *timer, void (*fn)(void), bool edge) {
+    (void)edge;
+    if (timer) timer->fn = fn;
+}
+
+void timerDetachInterrupt(hw_timer_t *timer) {
+    if (timer) timer->fn = nullptr;
+}
+
+void timerAlarmWrite(hw_timer_t *timer, uint64_t interruptAt, bool autoreload) {
+    if (!timer) return;
+    timer->alarm = interruptAt;
+    timer->autoreload = autoreload;
+}
+
+void timerAlarmEnable(hw_timer_t *timer) {
+    if (!timer || timer->enabled) return;
+    if (timer->thread.joinable()) timer->thread.join();
+    timer->enabled = true;
+    timer->thread = std::thread(run, timer);
+}
+
+void timerAlarmDisable(hw_timer_t *timer) {
+    if (!timer) return;
+    timer->enabled = false;
+    if (!timer->thread.joinable()) return;
+    // an interrupt disabling its own timer cannot wait for itself
+    if (timer->thread.get_id() == std::this_thread::get_id()) timer->thread.detach();
+    else timer->thread.join();
+}
+
+bool timerAlarmEnabled(hw_timer_t *timer) {
+    return timer && timer->enabled;
+}
+
+namespace native {
+
+TimerStats timerStats(uint8_t timer) {
+    TimerStats stats = {};
+    if (timer >= TIMER_COUNT) return stats;
+    Histogram &h = histograms[timer];
+    std::lock_guard<std::mutex> lock(h.mutex);
+    stats.interrupts = h.interrupts;
+    stats.overruns = h.overruns;
+    if (!h.interrupts) return stats;
+    stats.meanLateNs = h.totalLateNs / h.interrupts;
+    stats.p50LateNs = percentile(h, h.interrupts / 2);
+    stats.p99LateNs = percentile(h, h.interrupts * 99 / 100);
+    stats.maxLateNs = h.maxLateNs;
+    return stats;
+}
+
+void resetTimerStats(uint8_t timer) {
+    if (timer >= TIMER_COUNT) return;
+    Histogram &h = histograms[timer];
+    std::lock_guard<std::mutex> lock(h.mutex);
+    h.interrupts = 0;
+    h.overruns = 0;
+    h.totalLateNs = 0;
+    h.maxLateNs = 0;
+    for (uint32_t i = 0; i <= LATE_BUCKETS; i++) h.buckets[i] = 0;
+}
+
+}
@@ -0,0 +1,38 @@
+/**
+ * ----------------------------------------------------------------------------
+ * Native HAL: Preferences (NVS)
+ * ----------------------------------------------------------------------------
+ * Every namespace is a directory under NATIVE_NVS_DIR (default `.nvs`), every
+ * key a file in it, replaced atomically on write so a killed process leaves
+ * either the old or the new value, like a power cut on the board.
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class Preferences {
+    public:
+        bool begin(const char *name, bool readOnly = false);
+        void end();
+
+        bool clear();
+        bool remove(const char *key);
+
+        size_t putBytes(const char *key, const void *value, size_t len);
+        size_t getBytesLength(const char *key);
+        size_t getBytes(const char *key, void *buf, size_t maxLen);
+
+        size_t putUInt(const char *key, uint32_t value);
+        uint32_t getUInt(const char *key, uint32_t defaultValue = 0);
+
+    private:
+        std::string path(const char *key) const;
+
+        std::string _dir;
+        bool _started = false;
+        bool _readOnly = false;
+};
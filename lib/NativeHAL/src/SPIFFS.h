@@ -0,0 +1,32 @@
+/**
+ * ----------------------------------------------------------------------------
+ * Native HAL: SPIFFS
+ * ----------------------------------------------------------------------------
+ * The volume is mapped onto NATIVE_SPIFFS_DIR, or the project's `data/`
+ * directory when unset, so the web UI is served straight from the sources.
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include "FS.h"
+
+namespace fs {
+
+class SPIFFSFS : public FS {
+    public:
+        SPIFFSFS();
+
+        bool begin(bool formatOnFail = false, const char *basePath = "/spiffs", uint8_t maxOpenFiles = 10, const char *partitionLabel = nullptr);
+        void end() { _mounted = false; }
+        bool format() { return false; }
+        size_t totalBytes();
+        size_t usedBytes();
+
+    private:
+        bool _mounted = false;
+};
+
+}
+
+extern fs::SPIFFSFS SPIFFS;
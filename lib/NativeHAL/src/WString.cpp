@@ -0,0 +1,159 @@
+#include "WString.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+std::string toBase(unsigned long value, unsigned char base) {
+    if (base < 2 || base > 36) base = 10;
+    char digits[8 * sizeof(unsigned long) + 1];
+    size_t i = sizeof(digits);
+    do {
+        unsigned d = value % base;
+        digits[--i] = d < 10 ? '0' + d : 'a' + d - 10;
+        value /= base;
+    } while (value);
+    return std::string(digits + i, sizeof(digits) - i);
+}
+
+std::string toBase(long value, unsigned char base) {
+    if (value < 0 && base == 10) return "-" + toBase((unsigned long)-value, base);
+    return toBase((unsigned long)value, base);
+}
+
+std::string toDecimal(double value, unsigned char decimalPlaces) {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+    return buf;
+}
+
+}
+
+String::String(const char *cstr) : _buffer(cstr ? cstr : "") {}
+String::String(const char *cstr, size_t length) : _buffer(cstr ? std::string(cstr, length) : std::string()) {}
+String::String(const std::string &str) : _buffer(str) {}
+String::String(const __FlashStringHelper *str) : String(reinterpret_cast<const char *>(str)) {}
+String::String(char c) : _buffer(1, c) {}
+String::String(unsigned char value, unsigned char base) : _buffer(toBase((unsigned long)value, base)) {}
+String::String(int value, unsigned char base) : _buffer(toBase((long)value, base)) {}
+String::String(unsigned int value, unsigned char base) : _buffer(toBase((unsigned long)value, base)) {}
+String::String(long value, unsigned char base) : _buffer(toBase(value, base)) {}
+String::String(unsigned long value, unsigned char base) : _buffer(toBase(value, base)) {}
+String::String(float value, unsigned char decimalPlaces) : _buffer(toDecimal(value, decimalPlaces)) {}
+String::String(double value, unsigned char decimalPlaces) : _buffer(toDecimal(value, decimalPlaces)) {}
+
+bool String::concat(const char *cstr) {
+    if (!cstr) return false;
+    _buffer.append(cstr);
+    return true;
+}
+
+bool String::concat(const char *cstr, unsigned int length) {
+    if (!cstr) return false;
+    _buffer.append(cstr, length);
+    return true;
+}
+
+bool String::equals(const char *cstr) const {
+    return _buffer == (cstr ? cstr : "");
+}
+
+bool String::equalsIgnoreCase(const String &str) const {
+    if (length() != str.length()) return false;
+    for (size_t i = 0; i < _buffer.size(); i++) {
+        if (tolower((unsigned char)_buffer[i]) != tolower((unsigned char)str._buffer[i])) return false;
+    }
+    return true;
+}
+
+bool String::startsWith(const String &prefix) const {
+    return _buffer.compare(0, prefix._buffer.size(), prefix._buffer) == 0;
+}
+
+bool String::endsWith(const String &suffix) const {
+    return _buffer.size() >= suffix._buffer.size()
+        && _buffer.compare(_buffer.size() - suffix._buffer.size(), suffix._buffer.size(), suffix._buffer) == 0;
+}
+
+char String::charAt(unsigned int index) const {
+    return index < _buffer.size() ? _buffer[index] : 0;
+}
+
+int String::indexOf(char c, unsigned int from) const {
+    size_t pos = _buffer.find(c, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String &str, unsigned int from) const {
+    size_t pos = _buffer.find(str._buffer, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(char c) const {
+    size_t pos = _buffer.rfind(c);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int begin) const {
+    return substring(begin, length());
+}
+
+String String::substring(unsigned int begin, unsigned int end) const {
+    if (begin > end) std::swap(begin, end);
+    if (begin >= _buffer.size()) return String();
+    return String(_buffer.substr(begin, end - begin));
+}
+
+void String::replace(const String &find, const String &replace) {
+    if (find._buffer.empty()) return;
+    size_t pos = 0;
+    while ((pos = _buffer.find(find._buffer, pos)) != std::string::npos) {
+        _buffer.replace(pos, find._buffer.size(), replace._buffer);
+        pos += replace._buffer.size();
+    }
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+    if (index < _buffer.size()) _buffer.erase(index, count);
+}
+
+void String::toLowerCase() {
+    for (size_t i = 0; i < _buffer.size(); i++) _buffer[i] = tolower((unsigned char)_buffer[i]);
+}
+
+void String::toUpperCase() {
+    for (size_t i = 0; i < _buffer.size(); i++) _buffer[i] = toupper((unsigned char)_buffer[i]);
+}
+
+void String::trim() {
+    size_t begin = _buffer.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) { _buffer.clear(); return; }
+    size_t end = _buffer.find_last_not_of(" \t\r\n");
+    _buffer = _buffer.substr(begin, end - begin + 1);
+}
+
+long String::toInt() const { return strtol(_buffer.c_str(), nullptr, 10); }
+
+float String::toFloat() const { return strtof(_buffer.c_str(), nullptr); }
+
+String operator+(const String &lhs, const String &rhs) {
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String &lhs, const char *rhs) {
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const char *lhs, const String &rhs) {
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
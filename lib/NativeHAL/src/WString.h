@@ -0,0 +1,91 @@
+/**
+ * ----------------------------------------------------------------------------
+ * Native HAL: Arduino String
+ * ----------------------------------------------------------------------------
+ * Subset of the Arduino `String` API used by the firmware, ArduinoJson and
+ * ESP Async WebServer, backed by std::string.
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+class __FlashStringHelper;
+
+class String {
+    public:
+        String(const char *cstr = "");
+        String(const char *cstr, size_t length);
+        String(const std::string &str);
+        String(const __FlashStringHelper *str);
+        explicit String(char c);
+        explicit String(unsigned char value, unsigned char base = 10);
+        explicit String(int value, unsigned char base = 10);
+        explicit String(unsigned int value, unsigned char base = 10);
+        explicit String(long value, unsigned char base = 10);
+        explicit String(unsigned long value, unsigned char base = 10);
+        explicit String(float value, unsigned char decimalPlaces = 2);
+        explicit String(double value, unsigned char decimalPlaces = 2);
+
+        const char *c_str() const { return _buffer.c_str(); }
+        unsigned int length() const { return _buffer.length(); }
+        bool isEmpty() const { return _buffer.empty(); }
+        bool reserve(unsigned int size) { _buffer.reserve(size); return true; }
+
+        bool concat(const String &str) { _buffer.append(str._buffer); return true; }
+        bool concat(const char *cstr);
+        bool concat(const char *cstr, unsigned int length);
+        bool concat(char c) { _buffer.push_back(c); return true; }
+        bool concat(int value) { return concat(String(value)); }
+        bool concat(unsigned int value) { return concat(String(value)); }
+        bool concat(long value) { return concat(String(value)); }
+        bool concat(unsigned long value) { return concat(String(value)); }
+        bool concat(float value) { return concat(String(value)); }
+        bool concat(double value) { return concat(String(value)); }
+
+        template <typename T>
+        String &operator+=(const T &rhs) { concat(rhs); return *this; }
+
+        bool equals(const String &str) const { return _buffer == str._buffer; }
+        bool equals(const char *cstr) const;
+        bool equalsIgnoreCase(const String &str) const;
+        bool operator==(const String &rhs) const { return equals(rhs); }
+        bool operator==(const char *rhs) const { return equals(rhs); }
+        bool operator!=(const String &rhs) const { return !equals(rhs); }
+        bool operator!=(const char *rhs) const { return !equals(rhs); }
+        bool operator<(const String &rhs) const { return _buffer < rhs._buffer; }
+        int compareTo(const String &str) const { return _buffer.compare(str._buffer); }
+
+        bool startsWith(const String &prefix) const;
+        bool endsWith(const String &suffix) const;
+
+        char charAt(unsigned int index) const;
+        char operator[](unsigned int index) const { return charAt(index); }
+        char &operator[](unsigned int index) { return _buffer[index]; }
+
+        int indexOf(char c, unsigned int from = 0) const;
+        int indexOf(const String &str, unsigned int from = 0) const;
+        int lastIndexOf(char c) const;
+        String substring(unsigned int begin) const;
+        String substring(unsigned int begin, unsigned int end) const;
+
+        void replace(const String &find, const String &replace);
+        void remove(unsigned int index, unsigned int count = (unsigned int)-1);
+        void toLowerCase();
+        void toUpperCase();
+        void trim();
+
+        long toInt() const;
+        float toFloat() const;
+
+        const std::string &str() const { return _buffer; }
+
+    private:
+        std::string _buffer;
+};
+
+String operator+(const String &lhs, const String &rhs);
+String operator+(const String &lhs, const char *rhs);
+String operator+(const char *lhs, const String &rhs);
@@ -0,0 +1,50 @@
+/**
+ * ----------------------------------------------------------------------------
+ * Native HAL: ESP Async WebServer handlers
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include "ESPAsyncWebServer.h"
+
+class AsyncCallbackWebHandler : public AsyncWebHandler {
+    public:
+        void setUri(const String &uri) { _uri = uri; }
+        void setMethod(WebRequestMethodComposite method) { _method = method; }
+        void onRequest(ArRequestHandlerFunction fn) { _onRequest = fn; }
+        void onBody(ArBodyHandlerFunction fn) { _onBody = fn; }
+
+        bool canHandle(AsyncWebServerRequest *request) override;
+        void handleRequest(AsyncWebServerRequest *request) override;
+        void handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) override;
+        bool isRequestHandlerTrivial() override { return _onRequest == nullptr; }
+
+    private:
+        String _uri;
+        WebRequestMethodComposite _method = HTTP_ANY;
+        ArRequestHandlerFunction _onRequest;
+        ArBodyHandlerFunction _onBody;
+};
+
+class AsyncStaticWebHandler : public AsyncWebHandler {
+    public:
+        AsyncStaticWebHandler(const char *uri, FS &fs, const char *path, const char *cache_control);
+
+        AsyncStaticWebHandler &setCacheControl(const char *cache_control) { _cache_control = cache_control; return *this; }
+        AsyncStaticWebHandler &setDefaultFile(const char *filename) { _default_file = filename; return *this; }
+        AsyncStaticWebHandler &setTemplateProcessor(AwsTemplateProcessor callback) { _callback = callback; return *this; }
+
+        bool canHandle(AsyncWebServerRequest *request) override;
+        void handleRequest(AsyncWebServerRequest *request) override;
+
+    private:
+        bool _getFile(AsyncWebServerRequest *request, String &found, bool &gzipped);
+
+        FS _fs;
+        String _uri;
+        String _path;
+        String _default_file = "index.htm";
+        String _cache_control;
+        AwsTemplateProcessor _callback;
+};
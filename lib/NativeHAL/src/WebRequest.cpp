@@ -0,0 +1,241 @@
+#include "ESPAsyncWebServer.h"
+#include "NativeNet.h"
+
+#include <cstdlib>
+
+namespace {
+
+String urlDecode(const String &text) {
+    std::string out;
+    const std::string &in = text.str();
+    for (size_t i = 0; i < in.size(); i++) {
+        if (in[i] == '%' && i + 2 < in.size()) {
+            char hex[3] = { in[i + 1], in[i + 2], 0 };
+            out.push_back((char)strtol(hex, nullptr, 16));
+            i += 2;
+        } else {
+            out.push_back(in[i] == '+' ? ' ' : in[i]);
+        }
+    }
+    return String(out);
+}
+
+WebRequestMethodComposite parseMethod(const String &name) {
+    if (name == "GET")     return HTTP_GET;
+    if (name == "POST")    return HTTP_POST;
+    if (name == "DELETE")  return HTTP_DELETE;
+    if (name == "PUT")     return HTTP_PUT;
+    if (name == "PATCH")   return HTTP_PATCH;
+    if (name == "HEAD")    return HTTP_HEAD;
+    if (name == "OPTIONS") return HTTP_OPTIONS;
+    return 0;
+}
+
+const String emptyString;
+
+}
+
+AsyncWebServerRequest::AsyncWebServerRequest(AsyncWebServer *server, native::Connection *conn)
+    : _server(server), _conn(conn) {}
+
+AsyncWebServerRequest::~AsyncWebServerRequest() {
+    for (AsyncWebHeader *header : _headers) delete header;
+    for (AsyncWebParameter *param : _params) delete param;
+    delete _response;
+    if (_tempObject) free(_tempObject);
+    if (_onDisconnectFn) _onDisconnectFn();
+}
+
+bool AsyncWebServerRequest::_parse(const std::string &head) {
+    size_t lineEnd = head.find("\r\n");
+    String requestLine(head.substr(0, lineEnd));
+    int firstSpace = requestLine.indexOf(' ');
+    int secondSpace = requestLine.indexOf(' ', firstSpace + 1);
+    if (firstSpace < 0 || secondSpace < 0) return false;
+
+    _method = parseMethod(requestLine.substring(0, firstSpace));
+    if (!_method) return false;
+
+    String target = requestLine.substring(firstSpace + 1, secondSpace);
+    int query = target.indexOf('?');
+    if (query >= 0) {
+        _addGetParams(target.substring(query + 1));
+        target = target.substring(0, query);
+    }
+    _url = urlDecode(target);
+
+    size_t pos = lineEnd + 2;
+    while (pos < head.size()) {
+        size_t end = head.find("\r\n", pos);
+        if (end == std::string::npos) end = head.size();
+        String line(head.substr(pos, end - pos));
+        pos = end + 2;
+
+        int colon = line.indexOf(':');
+        if (colon <= 0) continue;
+        String name = line.substring(0, colon);
+        String value = line.substring(colon + 1);
+        value.trim();
+        _headers.push_back(new AsyncWebHeader(name, value));
+
+        if (name.equalsIgnoreCase("Host")) {
+            _host = value;
+        } else if (name.equalsIgnoreCase("Content-Type")) {
+            int semicolon = value.indexOf(';');
+            _contentType = semicolon >= 0 ? value.substring(0, semicolon) : value;
+        } else if (name.equalsIgnoreCase("Content-Length")) {
+            _contentLength = strtoul(value.c_str(), nullptr, 10);
+        }
+    }
+    return true;
+}
+
+void AsyncWebServerRequest::_addGetParams(const String &query) {
+    unsigned int start = 0;
+    while (start < query.length()) {
+        int end = query.indexOf('&', start);
+        if (end < 0) end = query.length();
+        String pair = query.substring(start, end);
+        int equal = pair.indexOf('=');
+        String name = equal >= 0 ? pair.substring(0, equal) : pair;
+        String value = equal >= 0 ? pair.substring(equal + 1) : String();
+        if (name.length()) _params.push_back(new AsyncWebParameter(urlDecode(name), urlDecode(value)));
+        start = end + 1;
+    }
+}
+
+const char *AsyncWebServerRequest::methodToString() const {
+    switch (_method) {
+        case HTTP_GET:     return "GET";
+        case HTTP_POST:    return "POST";
+        case HTTP_DELETE:  return "DELETE";
+        case HTTP_PUT:     return "PUT";
+        case HTTP_PATCH:   return "PATCH";
+        case HTTP_HEAD:    return "HEAD";
+        case HTTP_OPTIONS: return "OPTIONS";
+        default:           return "UNKNOWN";
+    }
+}
+
+IPAddress AsyncWebServerRequest::remoteIP() const {
+    return _conn ? _conn->remoteIP : IPAddress();
+}
+
+bool AsyncWebServerRequest::hasHeader(const String &name) const {
+    return getHeader(name) != nullptr;
+}
+
+AsyncWebHeader *AsyncWebServerRequest::getHeader(const String &name) const {
+    for (AsyncWebHeader *header : _headers) {
+        if (header->name().equalsIgnoreCase(name)) return header;
+    }
+    return nullptr;
+}
+
+AsyncWebHeader *AsyncWebServerRequest::getHeader(size_t num) const {
+    return num < _headers.size() ? _headers[num] : nullptr;
+}
+
+bool AsyncWebServerRequest::hasParam(const String &name, bool post, bool file) const {
+    return getParam(name, post, file) != nullptr;
+}
+
+AsyncWebParameter *AsyncWebServerRequest::getParam(const String &name, bool post, bool file) const {
+    for (AsyncWebParameter *param : _params) {
+        if (param->name() == name && param->isPost() == post && param->isFile() == file) return param;
+    }
+    return nullptr;
+}
+
+AsyncWebParameter *AsyncWebServerRequest::getParam(size_t num) const {
+    return num < _params.size() ? _params[num] : nullptr;
+}
+
+const String &AsyncWebServerRequest::arg(const String &name) const {
+    for (AsyncWebParameter *param : _params) {
+        if (param->name() == name) return param->value();
+    }
+    return emptyString;
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::_takeResponse() {
+    AsyncWebServerResponse *response = _response;
+    _response = nullptr;
+    return response;
+}
+
+void AsyncWebServerRequest::send(AsyncWebServerResponse *response) {
+    if (_response) {
+        delete response;
+        return;
+    }
+    _response = response;
+    if (_response && !_response->_sourceValid()) {
+        delete _response;
+        _response = nullptr;
+        send(500);
+    }
+}
+
+void AsyncWebServerRequest::send(int code, const String &contentType, const String &content) {
+    send(beginResponse(code, contentType, content));
+}
+
+void AsyncWebServerRequest::send(FS &fs, const String &path, const String &contentType, bool download, AwsTemplateProcessor callback) {
+    if (fs.exists(path) || (!download && fs.exists(path + ".gz"))) {
+        send(beginResponse(fs, path, contentType, download, callback));
+    } else {
+        send(404);
+    }
+}
+
+void AsyncWebServerRequest::send(const String &contentType, size_t len, AwsResponseFiller callback, AwsTemplateProcessor templateCallback) {
+    send(beginResponse(contentType, len, callback, templateCallback));
+}
+
+void AsyncWebServerRequest::sendChunked(const String &contentType, AwsResponseFiller callback, AwsTemplateProcessor templateCallback) {
+    send(beginChunkedResponse(contentType, callback, templateCallback));
+}
+
+void AsyncWebServerRequest::send_P(int code, const String &contentType, const uint8_t *content, size_t len, AwsTemplateProcessor callback) {
+    send(beginResponse_P(code, contentType, content, len, callback));
+}
+
+void AsyncWebServerRequest::send_P(int code, const String &contentType, const char *content, AwsTemplateProcessor callback) {
+    send(beginResponse_P(code, contentType, content, callback));
+}
+
+void AsyncWebServerRequest::redirect(const String &url) {
+    AsyncWebServerResponse *response = beginResponse(302);
+    response->addHeader("Location", url);
+    send(response);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse(int code, const String &contentType, const String &content) {
+    return new AsyncBasicResponse(code, contentType, content);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse(FS &fs, const String &path, const String &contentType, bool download, AwsTemplateProcessor callback) {
+    return new AsyncFileResponse(fs, path, contentType, download, callback);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse(const String &contentType, size_t len, AwsResponseFiller callback, AwsTemplateProcessor templateCallback) {
+    if (callback == nullptr) return nullptr;
+    return new AsyncCallbackResponse(contentType, len, callback, templateCallback);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginChunkedResponse(const String &contentType, AwsResponseFiller callback, AwsTemplateProcessor templateCallback) {
+    return new AsyncChunkedResponse(contentType, callback, templateCallback);
+}
+
+AsyncResponseStream *AsyncWebServerRequest::beginResponseStream(const String &contentType, size_t bufferSize) {
+    return new AsyncResponseStream(contentType, bufferSize);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse_P(int code, const String &contentType, const uint8_t *content, size_t len, AwsTemplateProcessor callback) {
+    return new AsyncProgmemResponse(code, contentType, content, len, callback);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse_P(int code, const String &contentType, const char *content, AwsTemplateProcessor callback) {
+    return beginResponse_P(code, contentType, (const uint8_t *)content, strlen(content), callback);
+}
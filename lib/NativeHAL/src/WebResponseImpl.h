@@ -0,0 +1,86 @@
+/**
+ * ----------------------------------------------------------------------------
+ * Native HAL: ESP Async WebServer responses
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include "ESPAsyncWebServer.h"
+
+class AsyncBasicResponse : public AsyncWebServerResponse {
+    public:
+        AsyncBasicResponse(int code, const String &contentType = String(), const String &content = String());
+        bool _sourceValid() const override { return true; }
+
+    protected:
+        void _assembleBody(std::string &out) override;
+
+    private:
+        String _content;
+};
+
+// Base for responses whose body is produced in TCP-sized pieces, expanding
+// %PLACEHOLDER% templates on the way when a processor is attached.
+class AsyncAbstractResponse : public AsyncWebServerResponse {
+    public:
+        explicit AsyncAbstractResponse(AwsTemplateProcessor callback = nullptr);
+
+    protected:
+        void _assembleBody(std::string &out) override;
+        // fills at most maxLen bytes of body starting at `index`
+        virtual size_t _fillBuffer(uint8_t *buf, size_t maxLen, size_t index) = 0;
+
+        AwsTemplateProcessor _callback;
+};
+
+class AsyncProgmemResponse : public AsyncAbstractResponse {
+    public:
+        AsyncProgmemResponse(int code, const String &contentType, const uint8_t *content, size_t len, AwsTemplateProcessor callback = nullptr);
+        bool _sourceValid() const override { return true; }
+
+    protected:
+        size_t _fillBuffer(uint8_t *buf, size_t maxLen, size_t index) override;
+
+    private:
+        const uint8_t *_content;
+};
+
+class AsyncCallbackResponse : public AsyncAbstractResponse {
+    public:
+        AsyncCallbackResponse(const String &contentType, size_t len, AwsResponseFiller callback, AwsTemplateProcessor templateCallback = nullptr);
+        bool _sourceValid() const override { return _content != nullptr; }
+
+    protected:
+        size_t _fillBuffer(uint8_t *buf, size_t maxLen, size_t index) override;
+
+    private:
+        AwsResponseFiller _content;
+};
+
+class AsyncChunkedResponse : public AsyncAbstractResponse {
+    public:
+        AsyncChunkedResponse(const String &contentType, AwsResponseFiller callback, AwsTemplateProcessor templateCallback = nullptr);
+        bool _sourceValid() const override { return _content != nullptr; }
+
+    protected:
+        void _assembleBody(std::string &out) override;
+        size_t _fillBuffer(uint8_t *buf, size_t maxLen, size_t index) override;
+
+    private:
+        AwsResponseFiller _content;
+};
+
+class AsyncFileResponse : public AsyncAbstractResponse {
+    public:
+        AsyncFileResponse(FS &fs, const String &path, const String &contentType = String(), bool download = false, AwsTemplateProcessor callback = nullptr);
+        AsyncFileResponse(File content, const String &path, const String &contentType = String(), bool download = false, AwsTemplateProcessor callback = nullptr);
+        bool _sourceValid() const override { return (bool)_content; }
+
+    protected:
+        size_t _fillBuffer(uint8_t *buf, size_t maxLen, size_t index) override;
+
+    private:
+        void _setContentType(const String &path);
+        File _content;
+};
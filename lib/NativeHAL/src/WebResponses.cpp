@@ -0,0 +1,308 @@
+#include "ESPAsyncWebServer.h"
+
+#include <cstdio>
+
+namespace {
+
+// payload size the board hands to each TCP write
+const size_t TCP_CHUNK = 1436;
+const size_t TEMPLATE_PLACEHOLDER_MAX = 32;
+
+void appendText(std::string &out, const char *text) {
+    out.append(text);
+}
+
+}
+
+// ----------------------------------------------------------------------------
+// AsyncWebServerResponse
+// ----------------------------------------------------------------------------
+
+AsyncWebServerResponse::AsyncWebServerResponse() {}
+
+void AsyncWebServerResponse::addHeader(const String &name, const String &value) {
+    _headers.push_back(AsyncWebHeader(name, value));
+}
+
+const char *AsyncWebServerResponse::responseCodeToString(int code) {
+    switch (code) {
+        case 101: return "Switching Protocols";
+        case 200: return "OK";
+        case 201: return "Created";
+        case 202: return "Accepted";
+        case 204: return "No Content";
+        case 206: return "Partial Content";
+        case 301: return "Moved Permanently";
+        case 302: return "Found";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 409: return "Conflict";
+        case 413: return "Request Entity Too Large";
+        case 415: return "Unsupported Media Type";
+        case 429: return "Too Many Requests";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        default:  return "";
+    }
+}
+
+void AsyncWebServerResponse::_assembleHead(std::string &out) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "HTTP/1.1 %d ", _code);
+    appendText(out, buf);
+    appendText(out, responseCodeToString(_code));
+    appendText(out, "\r\n");
+
+    if (_sendContentLength) {
+        snprintf(buf, sizeof(buf), "Content-Length: %u\r\n", (unsigned)_contentLength);
+        appendText(out, buf);
+    }
+    if (_contentType.length()) {
+        appendText(out, "Content-Type: ");
+        appendText(out, _contentType.c_str());
+        appendText(out, "\r\n");
+    }
+    for (const AsyncWebHeader &header : _headers) {
+        appendText(out, header.name().c_str());
+        appendText(out, ": ");
+        appendText(out, header.value().c_str());
+        appendText(out, "\r\n");
+    }
+    appendText(out, "Accept-Ranges: none\r\n");
+    if (_chunked) appendText(out, "Transfer-Encoding: chunked\r\n");
+    appendText(out, "\r\n");
+}
+
+void AsyncWebServerResponse::_assemble(std::string &out) {
+    _assembleHead(out);
+    _assembleBody(out);
+}
+
+// ----------------------------------------------------------------------------
+// AsyncBasicResponse
+// ----------------------------------------------------------------------------
+
+AsyncBasicResponse::AsyncBasicResponse(int code, const String &contentType, const String &content)
+    : _content(content) {
+    _code = code;
+    _contentType = contentType;
+    _contentLength = _content.length();
+    if (_contentLength && !_contentType.length()) _contentType = "text/plain";
+}
+
+void AsyncBasicResponse::_assembleBody(std::string &out) {
+    out.append(_content.c_str(), _content.length());
+}
+
+// ----------------------------------------------------------------------------
+// AsyncAbstractResponse
+// ----------------------------------------------------------------------------
+
+AsyncAbstractResponse::AsyncAbstractResponse(AwsTemplateProcessor callback) : _callback(callback) {
+    // templated output has an unknown length: the end of the body is marked
+    // by closing the connection
+    if (callback) {
+        _contentLength = 0;
+        _sendContentLength = false;
+        _chunked = false;
+    }
+}
+
+void AsyncAbstractResponse::_assembleBody(std::string &out) {
+    size_t bodyStart = out.size();
+    size_t index = 0;
+    for (;;) {
+        // the filler writes straight into the outgoing buffer
+        size_t maxLen = TCP_CHUNK;
+        if (_sendContentLength) {
+            if (index >= _contentLength) break;
+            if (_contentLength - index < maxLen) maxLen = _contentLength - index;
+        }
+        size_t offset = out.size();
+        out.resize(offset + maxLen);
+        size_t len = _fillBuffer((uint8_t *)&out[offset], maxLen, index);
+        if (len == RESPONSE_TRY_AGAIN) len = 0;
+        out.resize(offset + len);
+        if (len == 0) break;
+        index += len;
+    }
+
+    if (!_callback) return;
+
+    std::string body = out.substr(bodyStart);
+    out.resize(bodyStart);
+    for (size_t i = 0; i < body.size(); i++) {
+        if (body[i] != '%') {
+            out.push_back(body[i]);
+            continue;
+        }
+        if (i + 1 < body.size() && body[i + 1] == '%') {
+            out.push_back('%');
+            i++;
+            continue;
+        }
+        size_t end = body.find('%', i + 1);
+        if (end == std::string::npos || end - i - 1 > TEMPLATE_PLACEHOLDER_MAX) {
+            out.push_back('%');
+            continue;
+        }
+        String value = _callback(String(body.substr(i + 1, end - i - 1)));
+        out.append(value.c_str(), value.length());
+        i = end;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// AsyncProgmemResponse
+// ----------------------------------------------------------------------------
+
+AsyncProgmemResponse::AsyncProgmemResponse(int code, const String &contentType, const uint8_t *content, size_t len, AwsTemplateProcessor callback)
+    : AsyncAbstractResponse(callback), _content(content) {
+    _code = code;
+    _contentType = contentType;
+    _contentLength = len;
+    if (callback) _sendContentLength = false;
+}
+
+size_t AsyncProgmemResponse::_fillBuffer(uint8_t *buf, size_t maxLen, size_t index) {
+    if (index >= _contentLength) return 0;
+    size_t left = _contentLength - index;
+    size_t len = left > maxLen ? maxLen : left;
+    memcpy(buf, _content + index, len);
+    return len;
+}
+
+// ----------------------------------------------------------------------------
+// AsyncCallbackResponse
+// ----------------------------------------------------------------------------
+
+AsyncCallbackResponse::AsyncCallbackResponse(const String &contentType, size_t len, AwsResponseFiller callback, AwsTemplateProcessor templateCallback)
+    : AsyncAbstractResponse(templateCallback), _content(callback) {
+    _code = 200;
+    _contentType = contentType;
+    _contentLength = len;
+    if (!len) _sendContentLength = false;
+}
+
+size_t AsyncCallbackResponse::_fillBuffer(uint8_t *buf, size_t maxLen, size_t index) {
+    return _content(buf, maxLen, index);
+}
+
+// ----------------------------------------------------------------------------
+// AsyncChunkedResponse
+// ----------------------------------------------------------------------------
+
+AsyncChunkedResponse::AsyncChunkedResponse(const String &contentType, AwsResponseFiller callback, AwsTemplateProcessor templateCallback)
+    : AsyncAbstractResponse(templateCallback), _content(callback) {
+    _code = 200;
+    _contentType = contentType;
+    _sendContentLength = false;
+    _chunked = true;
+}
+
+void AsyncChunkedResponse::_assembleBody(std::string &out) {
+    std::string body;
+    AsyncAbstractResponse::_assembleBody(body);
+    char size[16];
+    for (size_t i = 0; i < body.size(); i += TCP_CHUNK) {
+        size_t len = body.size() - i < TCP_CHUNK ? body.size() - i : TCP_CHUNK;
+        snprintf(size, sizeof(size), "%x\r\n", (unsigned)len);
+        out.append(size);
+        out.append(body, i, len);
+        out.append("\r\n");
+    }
+    out.append("0\r\n\r\n");
+}
+
+size_t AsyncChunkedResponse::_fillBuffer(uint8_t *buf, size_t maxLen, size_t index) {
+    return _content(buf, maxLen, index);
+}
+
+// ----------------------------------------------------------------------------
+// AsyncFileResponse
+// ----------------------------------------------------------------------------
+
+AsyncFileResponse::AsyncFileResponse(FS &fs, const String &path, const String &contentType, bool download, AwsTemplateProcessor callback)
+    : AsyncAbstractResponse(callback) {
+    _code = 200;
+    if (!download && !fs.exists(path) && fs.exists(path + ".gz")) {
+        _content = fs.open(path + ".gz");
+        addHeader("Content-Encoding", "gzip");
+        _callback = nullptr;
+        _sendContentLength = true;
+    } else {
+        _content = fs.open(path);
+    }
+    _contentLength = _content.size();
+    if (contentType.length()) _contentType = contentType;
+    else _setContentType(path);
+    if (download) addHeader("Content-Disposition", "attachment");
+}
+
+AsyncFileResponse::AsyncFileResponse(File content, const String &path, const String &contentType, bool download, AwsTemplateProcessor callback)
+    : AsyncAbstractResponse(callback), _content(content) {
+    _code = 200;
+    if (String(content.name()).endsWith(".gz") && !path.endsWith(".gz")) {
+        addHeader("Content-Encoding", "gzip");
+        _callback = nullptr;
+        _sendContentLength = true;
+    }
+    _contentLength = _content.size();
+    if (contentType.length()) _contentType = contentType;
+    else _setContentType(path);
+    if (download) addHeader("Content-Disposition", "attachment");
+}
+
+void AsyncFileResponse::_setContentType(const String &path) {
+    if (path.endsWith(".html") || path.endsWith(".htm")) _contentType = "text/html";
+    else if (path.endsWith(".css")) _contentType = "text/css";
+    else if (path.endsWith(".json")) _contentType = "application/json";
+    else if (path.endsWith(".js")) _contentType = "application/javascript";
+    else if (path.endsWith(".png")) _contentType = "image/png";
+    else if (path.endsWith(".gif")) _contentType = "image/gif";
+    else if (path.endsWith(".jpg")) _contentType = "image/jpeg";
+    else if (path.endsWith(".ico")) _contentType = "image/x-icon";
+    else if (path.endsWith(".svg")) _contentType = "image/svg+xml";
+    else if (path.endsWith(".gz")) _contentType = "application/x-gzip";
+    else _contentType = "text/plain";
+}
+
+size_t AsyncFileResponse::_fillBuffer(uint8_t *buf, size_t maxLen, size_t index) {
+    (void)index;
+    return _content.read(buf, maxLen);
+}
+
+// ----------------------------------------------------------------------------
+// AsyncResponseStream
+// ----------------------------------------------------------------------------
+
+AsyncResponseStream::AsyncResponseStream(const String &contentType, size_t bufferSize) {
+    _code = 200;
+    _contentType = contentType;
+    _content.reserve(bufferSize);
+}
+
+size_t AsyncResponseStream::write(uint8_t data) {
+    _content.push_back((char)data);
+    return 1;
+}
+
+size_t AsyncResponseStream::write(const uint8_t *data, size_t len) {
+    _content.append((const char *)data, len);
+    return len;
+}
+
+void AsyncResponseStream::_assemble(std::string &out) {
+    _contentLength = _content.size();
+    AsyncWebServerResponse::_assemble(out);
+}
+
+void AsyncResponseStream::_assembleBody(std::string &out) {
+    out.append(_content);
+}
@@ -0,0 +1,195 @@
+#include "ESPAsyncWebServer.h"
+#include "NativeNet.h"
+
+#include <cstdlib>
+
+namespace {
+
+// Privileged ports need root on the host, so port 80 is served on 8080
+// unless NATIVE_HTTP_PORT says otherwise.
+uint16_t hostPort(uint16_t port) {
+    const char *env = getenv("NATIVE_HTTP_PORT");
+    if (env) return (uint16_t)strtoul(env, nullptr, 10);
+    return port < 1024 ? port + 8000 : port;
+}
+
+}
+
+// ----------------------------------------------------------------------------
+// AsyncWebServer
+// ----------------------------------------------------------------------------
+
+AsyncWebServer::AsyncWebServer(uint16_t port) : _port(hostPort(port)) {}
+
+AsyncWebServer::~AsyncWebServer() {
+    end();
+    reset();
+}
+
+void AsyncWebServer::begin() {
+    if (!native::listen(this, _port)) {
+        Serial.printf("[native] cannot listen on port %u\n", _port);
+        return;
+    }
+    Serial.printf("[native] serving on http://127.0.0.1:%u/\n", _port);
+}
+
+void AsyncWebServer::end() {
+    native::unlisten(this);
+}
+
+AsyncWebHandler &AsyncWebServer::addHandler(AsyncWebHandler *handler) {
+    std::lock_guard<native::AsyncMutex> lock(native::asyncLock());
+    _handlers.push_back(handler);
+    return *handler;
+}
+
+bool AsyncWebServer::removeHandler(AsyncWebHandler *handler) {
+    std::lock_guard<native::AsyncMutex> lock(native::asyncLock());
+    size_t before = _handlers.size();
+    _handlers.remove(handler);
+    return _handlers.size() != before;
+}
+
+AsyncCallbackWebHandler &AsyncWebServer::on(const char *uri, ArRequestHandlerFunction onRequest) {
+    return on(uri, HTTP_ANY, onRequest);
+}
+
+AsyncCallbackWebHandler &AsyncWebServer::on(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest) {
+    return on(uri, method, onRequest, nullptr, nullptr);
+}
+
+AsyncCallbackWebHandler &AsyncWebServer::on(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest, ArRequestHandlerFunction onUpload, ArBodyHandlerFunction onBody) {
+    (void)onUpload;
+    AsyncCallbackWebHandler *handler = new AsyncCallbackWebHandler();
+    handler->setUri(uri);
+    handler->setMethod(method);
+    handler->onRequest(onRequest);
+    handler->onBody(onBody);
+    addHandler(handler);
+    return *handler;
+}
+
+AsyncStaticWebHandler &AsyncWebServer::serveStatic(const char *uri, fs::FS &fs, const char *path, const char *cache_control) {
+    AsyncStaticWebHandler *handler = new AsyncStaticWebHandler(uri, fs, path, cache_control);
+    addHandler(handler);
+    return *handler;
+}
+
+void AsyncWebServer::reset() {
+    std::lock_guard<native::AsyncMutex> lock(native::asyncLock());
+    _handlers.clear();
+    _notFound = nullptr;
+}
+
+void AsyncWebServer::_handleRequest(AsyncWebServerRequest *request, uint8_t *body, size_t len) {
+    for (AsyncWebHandler *handler : _handlers) {
+        if (handler->filter(request) && handler->canHandle(request)) {
+            request->_handler = handler;
+            break;
+        }
+    }
+
+    if (!request->_handler) {
+        if (_notFound) _notFound(request);
+        else request->send(404);
+        return;
+    }
+
+    if (len) request->_handler->handleBody(request, body, len, 0, len);
+    request->_handler->handleRequest(request);
+}
+
+// ----------------------------------------------------------------------------
+// AsyncCallbackWebHandler
+// ----------------------------------------------------------------------------
+
+bool AsyncCallbackWebHandler::canHandle(AsyncWebServerRequest *request) {
+    if (!_onRequest) return false;
+    if (!(_method & request->method())) return false;
+
+    if (_uri.length() && _uri.startsWith("/*.")) {
+        String suffix = _uri.substring(_uri.lastIndexOf('.'));
+        return request->url().endsWith(suffix);
+    }
+    if (_uri.length() && _uri.endsWith("*")) {
+        return request->url().startsWith(_uri.substring(0, _uri.length() - 1));
+    }
+    return !_uri.length() || _uri == request->url() || request->url().startsWith(_uri + "/");
+}
+
+void AsyncCallbackWebHandler::handleRequest(AsyncWebServerRequest *request) {
+    if (_onRequest) _onRequest(request);
+    else request->send(500);
+}
+
+void AsyncCallbackWebHandler::handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    if (_onBody) _onBody(request, data, len, index, total);
+}
+
+// ----------------------------------------------------------------------------
+// AsyncStaticWebHandler
+// ----------------------------------------------------------------------------
+
+AsyncStaticWebHandler::AsyncStaticWebHandler(const char *uri, FS &fs, const char *path, const char *cache_control)
+    : _fs(fs), _uri(uri), _path(path), _cache_control(cache_control) {
+    // ensure leading '/', and no trailing one on the uri
+    if (_uri.length() == 0 || _uri[0] != '/') _uri = "/" + _uri;
+    if (_path.length() == 0 || _path[0] != '/') _path = "/" + _path;
+    if (_uri.endsWith("/")) _uri = _uri.substring(0, _uri.length() - 1);
+    if (_path.endsWith("/") && _path.length() > 1) _path = _path.substring(0, _path.length() - 1);
+}
+
+bool AsyncStaticWebHandler::canHandle(AsyncWebServerRequest *request) {
+    if (request->method() != HTTP_GET) return false;
+    if (!request->url().startsWith(_uri)) return false;
+    String found;
+    bool gzipped;
+    return _getFile(request, found, gzipped);
+}
+
+bool AsyncStaticWebHandler::_getFile(AsyncWebServerRequest *request, String &found, bool &gzipped) {
+    String path = request->url().substring(_uri.length());
+    if (path.length() == 0 || path.endsWith("/")) path += _default_file;
+    if (path[0] != '/') path = "/" + path;
+    if (_path != "/") path = _path + path;
+
+    gzipped = false;
+    if (_fs.exists(path + ".gz")) {
+        found = path;
+        gzipped = true;
+        return true;
+    }
+    if (_fs.exists(path)) {
+        found = path;
+        return true;
+    }
+    return false;
+}
+
+void AsyncStaticWebHandler::handleRequest(AsyncWebServerRequest *request) {
+    String path;
+    bool gzipped;
+    if (!_getFile(request, path, gzipped)) {
+        request->send(404);
+        return;
+    }
+
+    File file = _fs.open(gzipped ? path + ".gz" : path);
+    String etag(file.size());
+    if (_cache_control.length() && request->hasHeader("If-None-Match")
+        && request->getHeader("If-None-Match")->value() == etag) {
+        AsyncWebServerResponse *response = new AsyncBasicResponse(304);
+        response->addHeader("Cache-Control", _cache_control);
+        response->addHeader("ETag", etag);
+        request->send(response);
+        return;
+    }
+
+    AsyncWebServerResponse *response = new AsyncFileResponse(file, path, String(), false, _callback);
+    if (_cache_control.length()) {
+        response->addHeader("Cache-Control", _cache_control);
+        response->addHeader("ETag", etag);
+    }
+    request->send(response);
+}
@@ -0,0 +1,175 @@
+#include "WiFi.h"
+#include "Arduino.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+WiFiClass WiFi;
+
+namespace {
+
+unsigned long envMillis(const char *name) {
+    const char *env = getenv(name);
+    return env ? strtoul(env, nullptr, 10) : 0;
+}
+
+struct Listener {
+    WiFiEventFuncCb callback;
+    system_event_id_t event;
+};
+
+struct Pending {
+    unsigned long due;
+    system_event_id_t event;
+    uint8_t reason;
+    // events of an attempt that was given up on are dropped
+    uint32_t attempt;
+};
+
+std::mutex mutex;
+std::condition_variable wakeup;
+std::vector<Listener> listeners;
+std::vector<Pending> pending;
+bool running = false;
+
+std::atomic<bool> started(false);
+std::atomic<bool> linkUp(false);
+uint32_t attempt = 0;
+uint32_t failedAttempts = 0;
+bool dropped = false;
+
+void post(unsigned long due, system_event_id_t event, uint8_t reason, uint32_t forAttempt) {
+    Pending p = { due, event, reason, forAttempt };
+    pending.push_back(p);
+    wakeup.notify_one();
+}
+
+void startAttempt() {
+    attempt++;
+    started = true;
+    const unsigned long at = millis() + envMillis("NATIVE_WIFI_CONNECT_MS");
+    if (failedAttempts < envMillis("NATIVE_WIFI_FAIL_ATTEMPTS")) {
+        failedAttempts++;
+        post(at, SYSTEM_EVENT_STA_DISCONNECTED, WIFI_REASON_NO_AP_FOUND, attempt);
+        return;
+    }
+    post(at, SYSTEM_EVENT_STA_CONNECTED, 0, attempt);
+    post(at, SYSTEM_EVENT_STA_GOT_IP, 0, attempt);
+    const unsigned long drop = envMillis("NATIVE_WIFI_DROP_MS");
+    if (drop && !dropped) {
+        dropped = true;
+        post(at + drop, SYSTEM_EVENT_STA_DISCONNECTED, WIFI_REASON_BEACON_TIMEOUT, attempt);
+    }
+}
+
+void deliver(const Pending &p) {
+    system_event_info_t info;
+    memset(&info, 0, sizeof(info));
+    info.disconnected.reason = p.reason;
+
+    std::vector<Listener> targets;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        targets = listeners;
+    }
+    for (const Listener &listener : targets) {
+        if (listener.event == SYSTEM_EVENT_MAX || listener.event == p.event) listener.callback(p.event, info);
+    }
+}
+
+// the event task of the board
+void run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        if (pending.empty()) {
+            wakeup.wait(lock);
+            continue;
+        }
+        size_t next = 0;
+        for (size_t i = 1; i < pending.size(); i++) {
+            if (pending[i].due < pending[next].due) next = i;
+        }
+        const unsigned long now = millis();
+        if (pending[next].due > now) {
+            wakeup.wait_for(lock, std::chrono::milliseconds(pending[next].due - now));
+            continue;
+        }
+        Pending p = pending[next];
+        pending.erase(pending.begin() + next);
+        if (p.attempt != attempt) continue;
+
+        if (p.event == SYSTEM_EVENT_STA_GOT_IP) linkUp = true;
+        if (p.event == SYSTEM_EVENT_STA_DISCONNECTED) {
+            linkUp = false;
+            started = false;
+            if (WiFi.getAutoReconnect() && p.reason != WIFI_REASON_ASSOC_LEAVE) startAttempt();
+        }
+        lock.unlock();
+        deliver(p);
+        lock.lock();
+    }
+}
+
+void ensureRunning() {
+    if (running) return;
+    running = true;
+    std::thread(run).detach();
+}
+
+}
+
+wifi_event_id_t WiFiClass::onEvent(WiFiEventCb callback, system_event_id_t event) {
+    return onEvent([callback](system_event_id_t e, system_event_info_t) { callback(e); }, event);
+}
+
+wifi_event_id_t WiFiClass::onEvent(WiFiEventFuncCb callback, system_event_id_t event) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Listener listener = { callback, event };
+    listeners.push_back(listener);
+    return listeners.size();
+}
+
+wl_status_t WiFiClass::begin(const char *ssid, const char *passphrase) {
+    (void)passphrase;
+    _ssid = ssid;
+    std::lock_guard<std::mutex> lock(mutex);
+    ensureRunning();
+    linkUp = false;
+    startAttempt();
+    return WL_DISCONNECTED;
+}
+
+bool WiFiClass::disconnect(bool wifioff) {
+    if (wifioff) _mode = WIFI_MODE_NULL;
+    std::lock_guard<std::mutex> lock(mutex);
+    const bool wasUp = linkUp;
+    attempt++;
+    started = false;
+    linkUp = false;
+    if (wasUp) post(millis(), SYSTEM_EVENT_STA_DISCONNECTED, WIFI_REASON_ASSOC_LEAVE, attempt);
+    return true;
+}
+
+bool WiFiClass::reconnect() {
+    if (_ssid.isEmpty()) return false;
+    begin(_ssid.c_str());
+    return true;
+}
+
+wl_status_t WiFiClass::status() {
+    if (linkUp) return WL_CONNECTED;
+    return started ? WL_IDLE_STATUS : WL_DISCONNECTED;
+}
+
+String WiFiClass::macAddress() {
+    return String("24:0A:C4:00:00:01");
+}
+
+IPAddress WiFiClass::localIP() {
+    return status() == WL_CONNECTED ? IPAddress(127, 0, 0, 1) : IPAddress();
+}
@@ -0,0 +1,105 @@
+/**
+ * ----------------------------------------------------------------------------
+ * Native HAL: WiFi
+ * ----------------------------------------------------------------------------
+ * Station mode only. The host network is always there, so begin() simply
+ * reports WL_CONNECTED once NATIVE_WIFI_CONNECT_MS (default 0) has elapsed.
+ *
+ * Events registered with onEvent() are delivered from a thread of their own,
+ * like the event task of the board. Link trouble can be simulated:
+ * NATIVE_WIFI_FAIL_ATTEMPTS makes the first attempts fail with NO_AP_FOUND,
+ * and NATIVE_WIFI_DROP_MS drops the link once, that long after it came up.
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "IPAddress.h"
+#include "WString.h"
+#include "WiFiClient.h"
+
+typedef enum {
+    WL_NO_SHIELD       = 255,
+    WL_IDLE_STATUS     = 0,
+    WL_NO_SSID_AVAIL   = 1,
+    WL_SCAN_COMPLETED  = 2,
+    WL_CONNECTED       = 3,
+    WL_CONNECT_FAILED  = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED    = 6
+} wl_status_t;
+
+typedef enum {
+    WIFI_MODE_NULL = 0,
+    WIFI_MODE_STA,
+    WIFI_MODE_AP,
+    WIFI_MODE_APSTA
+} wifi_mode_t;
+
+#define WIFI_OFF   WIFI_MODE_NULL
+#define WIFI_STA   WIFI_MODE_STA
+#define WIFI_AP    WIFI_MODE_AP
+#define WIFI_AP_STA WIFI_MODE_APSTA
+
+typedef enum {
+    SYSTEM_EVENT_WIFI_READY = 0,
+    SYSTEM_EVENT_SCAN_DONE,
+    SYSTEM_EVENT_STA_START,
+    SYSTEM_EVENT_STA_STOP,
+    SYSTEM_EVENT_STA_CONNECTED,
+    SYSTEM_EVENT_STA_DISCONNECTED,
+    SYSTEM_EVENT_STA_AUTHMODE_CHANGE,
+    SYSTEM_EVENT_STA_GOT_IP,
+    SYSTEM_EVENT_STA_LOST_IP,
+    SYSTEM_EVENT_MAX
+} system_event_id_t;
+
+typedef enum {
+    WIFI_REASON_ASSOC_LEAVE    = 8,
+    WIFI_REASON_BEACON_TIMEOUT = 200,
+    WIFI_REASON_NO_AP_FOUND    = 201,
+    WIFI_REASON_AUTH_FAIL      = 202,
+} wifi_err_reason_t;
+
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t reason;
+} system_event_sta_disconnected_t;
+
+typedef union {
+    system_event_sta_disconnected_t disconnected;
+} system_event_info_t;
+
+typedef uint16_t wifi_event_id_t;
+typedef void (*WiFiEventCb)(system_event_id_t event);
+typedef std::function<void(system_event_id_t event, system_event_info_t info)> WiFiEventFuncCb;
+
+class WiFiClass {
+    public:
+        bool mode(wifi_mode_t mode) { _mode = mode; return true; }
+        bool setAutoReconnect(bool autoReconnect) { _autoReconnect = autoReconnect; return true; }
+        bool getAutoReconnect() const { return _autoReconnect; }
+        // event SYSTEM_EVENT_MAX subscribes to every event
+        wifi_event_id_t onEvent(WiFiEventCb callback, system_event_id_t event = SYSTEM_EVENT_MAX);
+        wifi_event_id_t onEvent(WiFiEventFuncCb callback, system_event_id_t event = SYSTEM_EVENT_MAX);
+        wl_status_t begin(const char *ssid, const char *passphrase = nullptr);
+        bool disconnect(bool wifioff = false);
+        bool reconnect();
+        wl_status_t status();
+
+        String macAddress();
+        IPAddress localIP();
+        String SSID() const { return _ssid; }
+
+    private:
+        wifi_mode_t _mode = WIFI_MODE_NULL;
+        String _ssid;
+        bool _autoReconnect = true;
+};
+
+extern WiFiClass WiFi;
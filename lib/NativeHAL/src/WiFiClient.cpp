@@ -0,0 +1,60 @@
+#include "WiFiClient.h"
+#include "NativeNet.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+    stop();
+    if (ip == IPAddress(127, 0, 0, 1)) {
+        _fd = native::connectLocal(port);
+        if (_fd >= 0) return 1;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return 0;
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl((uint32_t)ip[0] << 24 | (uint32_t)ip[1] << 16 | (uint32_t)ip[2] << 8 | ip[3]);
+    addr.sin_port = htons(port);
+    if (::connect(fd, (sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return 0;
+    }
+    _fd = fd;
+    return 1;
+}
+
+uint8_t WiFiClient::connected() {
+    if (_fd < 0) return 0;
+    char c;
+    ssize_t n = recv(_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) stop();
+    return _fd >= 0;
+}
+
+void WiFiClient::stop() {
+    if (_fd < 0) return;
+    close(_fd);
+    _fd = -1;
+}
+
+size_t WiFiClient::write(const uint8_t *buffer, size_t size) {
+    if (_fd < 0) return 0;
+    size_t sent = 0;
+    while (sent < size) {
+        ssize_t n = ::send(_fd, buffer + sent, size - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            stop();
+            break;
+        }
+        sent += n;
+    }
+    return sent;
+}
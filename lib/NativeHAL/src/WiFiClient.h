@@ -0,0 +1,36 @@
+/**
+ * ----------------------------------------------------------------------------
+ * Native HAL: WiFiClient
+ * ----------------------------------------------------------------------------
+ * A blocking TCP client. Connecting to 127.0.0.1 on the port of an
+ * AsyncServer of this process joins that server through a socket pair;
+ * anything else is a host TCP connection.
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "IPAddress.h"
+#include "Print.h"
+
+class WiFiClient : public Print {
+    public:
+        WiFiClient() {}
+        ~WiFiClient() { stop(); }
+        WiFiClient(const WiFiClient &) = delete;
+        WiFiClient &operator=(const WiFiClient &) = delete;
+
+        // 1 once connected, 0 on failure
+        int connect(IPAddress ip, uint16_t port);
+        uint8_t connected();
+        void stop();
+
+        size_t write(uint8_t c) override { return write(&c, 1); }
+        size_t write(const uint8_t *buffer, size_t size) override;
+        using Print::write;
+
+    private:
+        int _fd = -1;
+};
@@ -0,0 +1,29 @@
+/**
+ * ----------------------------------------------------------------------------
+ * Native HAL: hardware timers
+ * ----------------------------------------------------------------------------
+ * The arduino-esp32 timer API on top of a host thread per timer. Counts are
+ * taken against the board's 80 MHz APB clock, so the same divider and alarm
+ * values give the same period as on the ESP32. The interrupt runs on the
+ * timer thread, concurrently with loop() and the network thread, and how late
+ * each one fires is recorded (see native::timerStats()).
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstdint>
+
+struct hw_timer_s;
+typedef struct hw_timer_s hw_timer_t;
+
+hw_timer_t *timerBegin(uint8_t timer, uint16_t divider, bool countUp);
+void timerEnd(hw_timer_t *timer);
+
+void timerAttachInterrupt(hw_timer_t *timer, void (*fn)(void), bool edge);
+void timerDetachInterrupt(hw_timer_t *timer);
+
+void timerAlarmWrite(hw_timer_t *timer, uint64_t interruptAt, bool autoreload);
+void timerAlarmEnable(hw_timer_t *timer);
+void timerAlarmDisable(hw_timer_t *timer);
+bool timerAlarmEnabled(hw_timer_t *timer);
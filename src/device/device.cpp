@@ -1,32 +1,195 @@
 #include "./device.h"
 
-Device::Device() {
-    homed = false;
-    limit = 1000;
-    currentPosition = 0.0;
-    ratio = 1.0;
-    accel = 1.0;
+#include <math.h>
+
+Device::Device(uint8_t numberOfAxes, float limit) : sequence(0) {
+    if (numberOfAxes < 1) numberOfAxes = 1;
+    if (numberOfAxes > DEVICE_MAX_AXES) numberOfAxes = DEVICE_MAX_AXES;
+    this->numberOfAxes = numberOfAxes;
+
+    for (uint8_t i = 0; i < DEVICE_MAX_AXES; i++) {
+        homed[i] = false;
+        limits[i] = limit;
+        targets[i] = 0.0;
+        steps[i] = 0;
+        ratios[i] = 1.0;
+        accels[i] = 1.0;
+    }
+    publish();
 }
 Device::~Device() {
 }
 
-void Device::homeAxis(){
-    currentPosition = 0.0;
-    homed = true;
-}
+uint8_t Device::getNumberOfAxes() const {return numberOfAxes;}
 
-void Device::setPosition(float newPosition) { 
+float Device::clamp(uint8_t axis, float newPosition) const {
     if (newPosition < 0.0) {
-        currentPosition = 0.0;
-    } else if (newPosition <= limit && newPosition >= 0.0 ) {
-        currentPosition = newPosition;
-    } else if (newPosition > limit) {
-        currentPosition = limit;
+        return 0.0;
+    } else if (newPosition > limits[axis]) {
+        return limits[axis];
+    }
+    return newPosition;
+}
+
+void Device::homeAxis(uint8_t axis){
+    if (axis >= numberOfAxes) return;
+    targets[axis] = 0.0;
+    steps[axis] = 0;
+    homed[axis] = true;
+}
+
+void Device::homeAxes(){
+    for (uint8_t i = 0; i < numberOfAxes; i++) {
+        targets[i] = 0.0;
+        steps[i] = 0;
+        homed[i] = true;
+    }
+}
+
+void Device::setPosition(uint8_t axis, float newPosition) {
+    if (axis >= numberOfAxes) return;
+    targets[axis] = clamp(axis, newPosition);
+}
+
+void Device::setPositions(const float *newPositions, uint8_t mask) {
+    for (uint8_t i = 0; i < numberOfAxes; i++) {
+        if (mask & (1 << i)) targets[i] = clamp(i, newPositions[i]);
+    }
+}
+
+float Device::getTarget(uint8_t axis) const {return axis < numberOfAxes ? targets[axis] : 0.0;}
+
+const float *Device::getTargets() const {return targets;}
+
+void Device::getTargetSteps(int32_t *out) const {
+    for (uint8_t i = 0; i < numberOfAxes; i++) {
+        out[i] = (int32_t)lroundf(targets[i] * ratios[i]);
+    }
+}
+
+bool Device::isHomed(uint8_t axis) const {return axis < numberOfAxes && homed[axis];}
+
+float Device::getPosition(uint8_t axis) const {return axis < numberOfAxes ? steps[axis] / ratios[axis] : 0.0;}
+
+void Device::getPositions(float *out) const {
+    for (uint8_t i = 0; i < numberOfAxes; i++) {
+        out[i] = steps[i] / ratios[i];
+    }
+}
+
+const int32_t *Device::getSteps() const {return steps;}
+
+void Device::setSteps(const int32_t *newSteps) {
+    for (uint8_t i = 0; i < numberOfAxes; i++) {
+        steps[i] = newSteps[i];
     }
 }
 
-bool Device::isHomed() {return homed;}
+uint32_t Device::getConfigVersion() const {return configVersion;}
 
-float Device::getPosition() {return currentPosition;}
+float Device::getLimit(uint8_t axis) const {return axis < numberOfAxes ? limits[axis] : 0.0;}
 
-float Device::getLimit() {return limit;}
\ No newline at end of file
+const float *Device::getLimits() const {return limits;}
+
+// written so that NaN fails every test
+bool Device::isValidConfig(float limit, float ratio, float accel) {
+    if (!(limit > 0.0 && limit <= DEVICE_MAX_LIMIT)) return false;
+    if (!(ratio > 0.0 && ratio <= DEVICE_MAX_RATIO)) return false;
+    if (!(accel > 0.0 && accel <= DEVICE_MAX_ACCEL)) return false;
+    return limit * ratio <= DEVICE_MAX_STEPS && accel * ratio >= DEVICE_MIN_STEP_ACCEL;
+}
+
+bool Device::setLimit(uint8_t axis, float newLimit) {
+    if (axis >= numberOfAxes || !isValidConfig(newLimit, ratios[axis], accels[axis])) return false;
+    limits[axis] = newLimit;
+    targets[axis] = clamp(axis, targets[axis]);
+    configVersion++;
+    return true;
+}
+
+float Device::getRatio(uint8_t axis) const {return axis < numberOfAxes ? ratios[axis] : 1.0;}
+
+const float *Device::getRatios() const {return ratios;}
+
+bool Device::setRatio(uint8_t axis, float newRatio) {
+    if (axis >= numberOfAxes || !isValidConfig(limits[axis], newRatio, accels[axis])) return false;
+    ratios[axis] = newRatio;
+    targets[axis] = clamp(axis, steps[axis] / newRatio);
+    configVersion++;
+    return true;
+}
+
+float Device::getAccel(uint8_t axis) const {return axis < numberOfAxes ? accels[axis] : 1.0;}
+
+const float *Device::getAccels() const {return accels;}
+
+bool Device::setAccel(uint8_t axis, float newAccel) {
+    if (axis >= numberOfAxes || !isValidConfig(limits[axis], ratios[axis], newAccel)) return false;
+    accels[axis] = newAccel;
+    configVersion++;
+    return true;
+}
+
+bool Device::setAxisConfig(uint8_t axis, float newLimit, float newRatio, float newAccel) {
+    if (axis >= numberOfAxes || !isValidConfig(newLimit, newRatio, newAccel)) return false;
+    if (newRatio != ratios[axis]) targets[axis] = steps[axis] / newRatio;
+    limits[axis] = newLimit;
+    ratios[axis] = newRatio;
+    accels[axis] = newAccel;
+    targets[axis] = clamp(axis, targets[axis]);
+    configVersion++;
+    return true;
+}
+
+void Device::restoreConfig(const float *newLimits, const float *newRatios, const float *newAccels) {
+    for (uint8_t i = 0; i < numberOfAxes; i++) {
+        if (!isValidConfig(newLimits[i], newRatios[i], newAccels[i])) continue;
+        limits[i] = newLimits[i];
+        ratios[i] = newRatios[i];
+        accels[i] = newAccels[i];
+        targets[i] = clamp(i, targets[i]);
+    }
+    configVersion++;
+}
+
+void Device::restoreState(const int32_t *newSteps, const bool *newHomed) {
+    for (uint8_t i = 0; i < numberOfAxes; i++) {
+        steps[i] = newSteps[i];
+        homed[i] = newHomed[i];
+        targets[i] = steps[i] / ratios[i];
+    }
+}
+
+void Device::publish() {
+    const uint32_t seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    DeviceSnapshot &next = buffers[(seq / 2 + 1) & 1];
+    next.sequence = seq / 2 + 1;
+    next.configVersion = configVersion;
+    next.numberOfAxes = numberOfAxes;
+    next.homedMask = 0;
+    for (uint8_t i = 0; i < numberOfAxes; i++) {
+        if (homed[i]) next.homedMask |= 1 << i;
+        next.steps[i] = steps[i];
+        next.positions[i] = steps[i] / ratios[i];
+        next.targets[i] = targets[i];
+        next.limits[i] = limits[i];
+        next.ratios[i] = ratios[i];
+        next.accels[i] = accels[i];
+    }
+
+    sequence.store(seq + 2, std::memory_order_release);
+}
+
+void Device::getSnapshot(DeviceSnapshot &out) const {
+    while (true) {
+        const uint32_t seq = sequence.load(std::memory_order_acquire);
+        const uint32_t stable = seq & ~1u;
+        out = buffers[(stable / 2) & 1];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // the buffer is only rewritten by the publish after next
+        if (sequence.load(std::memory_order_relaxed) - stable <= 2) return;
+    }
+}
@@ -1,24 +1,124 @@
+#pragma once
 
+#include <stdint.h>
+
+#include <atomic>
+
+// Upper bound on the axes a single controller drives; per-axis state is
+// stored in fixed arrays of this size so the Device never allocates.
+#define DEVICE_MAX_AXES 6
+
+// Accepted ranges of the per-axis configuration: limits in mm, ratios in
+// steps/mm and accelerations in mm/s^2. A limit times its ratio must also
+// fit the step counters, and an acceleration times its ratio (steps/s^2)
+// must reach DEVICE_MIN_STEP_ACCEL, so that ramping up to the fastest step
+// rate fits the planner's 32-bit tick counts.
+#define DEVICE_DEFAULT_LIMIT 1000.0
+#define DEVICE_MAX_LIMIT     10000.0
+#define DEVICE_MAX_RATIO     10000.0
+#define DEVICE_MAX_ACCEL     10000.0
+#define DEVICE_MAX_STEPS     1000000000.0
+#define DEVICE_MIN_STEP_ACCEL 1.0
+
+// A consistent view of every axis at one instant, for readers on other tasks.
+struct DeviceSnapshot {
+    // publishes since boot
+    uint32_t sequence;
+    uint32_t configVersion;
+    uint8_t  numberOfAxes;
+    // one bit per axis
+    uint32_t homedMask;
+    int32_t  steps[DEVICE_MAX_AXES];
+    float    positions[DEVICE_MAX_AXES];
+    float    targets[DEVICE_MAX_AXES];
+    float    limits[DEVICE_MAX_AXES];
+    float    ratios[DEVICE_MAX_AXES];
+    float    accels[DEVICE_MAX_AXES];
+};
 
 class Device {
     public:
-        Device();
+        Device(uint8_t numberOfAxes = 1, float limit = DEVICE_DEFAULT_LIMIT);
         ~Device();
 
-        void setPosition(float newPosition);
-        void homeAxis();
-        bool isHomed();
-        float getPosition();
-        
-        float getLimit();
-        float setLimit();
-        
+        uint8_t getNumberOfAxes() const;
+
+        // commanded positions: clamped to [0, limit] and handed to the motion
+        // planner, the axes only get there once the trajectory has run
+        void setPosition(uint8_t axis, float newPosition);
+        // moves every axis whose bit is set in mask, in a single call
+        void setPositions(const float *newPositions, uint8_t mask = 0xff);
+        float getTarget(uint8_t axis) const;
+        const float *getTargets() const;
+        void getTargetSteps(int32_t *out) const;
+
+        void homeAxis(uint8_t axis);
+        void homeAxes();
+        bool isHomed(uint8_t axis) const;
+
+        // actual positions, derived from the step counts of the motion engine
+        float getPosition(uint8_t axis) const;
+        void getPositions(float *out) const;
+        const int32_t *getSteps() const;
+        void setSteps(const int32_t *newSteps);
+
+        // bumped by every change to limits, ratios or accelerations, so that
+        // anything derived from them can tell it is stale
+        uint32_t getConfigVersion() const;
 
+        // Each setter returns false, changing nothing, for an axis that does
+        // not exist or a value out of range. A limit below the target pulls
+        // the target in; a new ratio keeps the axis where it is, its target
+        // following the position in the new unit. From loop() only, which
+        // plans with them: other tasks go through Motion::configure().
+        static bool isValidConfig(float limit, float ratio, float accel);
+
+        float getLimit(uint8_t axis) const;
+        const float *getLimits() const;
+        bool setLimit(uint8_t axis, float newLimit);
+
+        // steps per mm
+        float getRatio(uint8_t axis) const;
+        const float *getRatios() const;
+        bool setRatio(uint8_t axis, float newRatio);
+        // mm/s^2
+        float getAccel(uint8_t axis) const;
+        const float *getAccels() const;
+        bool setAccel(uint8_t axis, float newAccel);
+        // all three at once, checked together
+        bool setAxisConfig(uint8_t axis, float newLimit, float newRatio, float newAccel);
+
+        // state saved by a DeviceStore, put back before motion starts: the
+        // configuration of every axis, and where the axes rest with their
+        // homed flags (the targets follow, so nothing moves)
+        void restoreConfig(const float *newLimits, const float *newRatios, const float *newAccels);
+        void restoreState(const int32_t *newSteps, const bool *newHomed);
+
+        // Double-buffered snapshot. publish(), from the one task that owns
+        // the step counts (loop()), fills the buffer readers are not on and
+        // then flips to it; getSnapshot() copies the latest complete one and
+        // only retries if two publishes overtook the copy. A reader never
+        // waits for a writer it preempted, and never sees axes from
+        // different instants.
+        void publish();
+        void getSnapshot(DeviceSnapshot &out) const;
 
     private:
-        bool homed = false;
-        float limit = 1000;
-        float currentPosition = 0.0;
-        float ratio = 1.0;
-        float accel = 1.0;
-};
\ No newline at end of file
+        float clamp(uint8_t axis, float newPosition) const;
+
+        uint8_t numberOfAxes = 1;
+        uint32_t configVersion = 1;
+
+        // structure of arrays: one contiguous array per field, indexed by axis
+        bool    homed[DEVICE_MAX_AXES];
+        float   limits[DEVICE_MAX_AXES];
+        float   targets[DEVICE_MAX_AXES];
+        int32_t steps[DEVICE_MAX_AXES];
+        float   ratios[DEVICE_MAX_AXES];
+        float   accels[DEVICE_MAX_AXES];
+
+        // even while idle, odd while publish() fills the next buffer; the
+        // latest complete snapshot is buffers[(sequence / 2) & 1]
+        std::atomic<uint32_t> sequence;
+        DeviceSnapshot buffers[2];
+};
@@ -0,0 +1,102 @@
+#include "./device_store.h"
+
+#include <Arduino.h>
+
+#include <string.h>
+
+static const char NAMESPACE[] = "device";
+static const char CONFIG_KEY[] = "config";
+static const char STATE_KEY[] = "state";
+
+DeviceStore::DeviceStore(Device &device) : device(device) {
+}
+
+void DeviceStore::begin() {
+    started = prefs.begin(NAMESPACE, false);
+    if (!started) {
+        Serial.println("DeviceStore: NVS unavailable, state is not persisted");
+        return;
+    }
+    const uint8_t n = device.getNumberOfAxes();
+
+    ConfigRecord config;
+    if (prefs.getBytes(CONFIG_KEY, &config, sizeof(config)) == sizeof(config)
+            && config.version == DEVICE_STORE_VERSION && config.numberOfAxes == n) {
+        device.restoreConfig(config.limits, config.ratios, config.accels);
+    }
+    savedConfigVersion = seenConfigVersion = device.getConfigVersion();
+
+    StateRecord state;
+    if (prefs.getBytes(STATE_KEY, &state, sizeof(state)) == sizeof(state)
+            && state.version == DEVICE_STORE_VERSION && state.numberOfAxes == n) {
+        storedAtRest = state.atRest;
+        if (state.atRest) {
+            device.restoreState(state.steps, state.homed);
+            Serial.println("DeviceStore: restored the rest position");
+        } else {
+            Serial.println("DeviceStore: stopped mid-move, axes need homing");
+        }
+    }
+}
+
+void DeviceStore::saveConfig() {
+    ConfigRecord config;
+    memset(&config, 0, sizeof(config));
+    config.version = DEVICE_STORE_VERSION;
+    config.numberOfAxes = device.getNumberOfAxes();
+    for (uint8_t i = 0; i < config.numberOfAxes; i++) {
+        config.limits[i] = device.getLimit(i);
+        config.ratios[i] = device.getRatio(i);
+        config.accels[i] = device.getAccel(i);
+    }
+    if (prefs.putBytes(CONFIG_KEY, &config, sizeof(config)) == sizeof(config)) writes++;
+    savedConfigVersion = seenConfigVersion;
+}
+
+void DeviceStore::saveState(bool atRest) {
+    StateRecord state;
+    memset(&state, 0, sizeof(state));
+    state.version = DEVICE_STORE_VERSION;
+    state.numberOfAxes = device.getNumberOfAxes();
+    state.atRest = atRest;
+    for (uint8_t i = 0; i < state.numberOfAxes; i++) {
+        state.homed[i] = device.isHomed(i);
+        state.steps[i] = device.getSteps()[i];
+    }
+    if (prefs.putBytes(STATE_KEY, &state, sizeof(state)) == sizeof(state)) {
+        writes++;
+    } else if (!atRest) {
+        // the claim has to go one way or the other, or nothing could move
+        prefs.remove(STATE_KEY);
+        Serial.println("DeviceStore: write failed, checkpoint dropped");
+    } else {
+        return;
+    }
+    storedAtRest = atRest;
+}
+
+void DeviceStore::service(uint32_t nowMillis, bool settled) {
+    if (!started) return;
+
+    const uint32_t version = device.getConfigVersion();
+    if (version != seenConfigVersion) {
+        seenConfigVersion = version;
+        configChanged = nowMillis;
+    }
+    if (seenConfigVersion != savedConfigVersion && nowMillis - configChanged >= DEVICE_STORE_SETTLE_MS) saveConfig();
+
+    if (!settled) {
+        settledSince = nowMillis;
+        if (storedAtRest) saveState(false);
+        return;
+    }
+    if (storedAtRest || nowMillis - settledSince < DEVICE_STORE_SETTLE_MS) return;
+    if (checkpointed && nowMillis - lastCheckpoint < DEVICE_STORE_INTERVAL_MS) return;
+    saveState(true);
+    lastCheckpoint = nowMillis;
+    checkpointed = true;
+}
+
+bool DeviceStore::mayMove() const {return !storedAtRest;}
+
+uint32_t DeviceStore::getWrites() const {return writes;}
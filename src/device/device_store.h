@@ -0,0 +1,80 @@
+#pragma once
+
+#include <Preferences.h>
+
+#include "./device.h"
+
+// A rest checkpoint is written once the axes have been still this long, and
+// at most once per interval; a configuration change is saved once it has
+// been left alone for the settle time. Both bound the flash wear of a busy
+// machine to a few writes per minute.
+#ifndef DEVICE_STORE_SETTLE_MS
+#define DEVICE_STORE_SETTLE_MS 2000
+#endif
+#ifndef DEVICE_STORE_INTERVAL_MS
+#define DEVICE_STORE_INTERVAL_MS 10000
+#endif
+
+// Layout of the stored records; a record of another version is ignored.
+#define DEVICE_STORE_VERSION 1
+
+// Checkpoints the Device to NVS so that a power cut does not cost a re-home.
+//
+// The configuration (limits, ratios, accelerations) is kept in one record,
+// the axis state (steps and homed flags) in another, which also says whether
+// the axes were at rest when it was written. Only a rest checkpoint is
+// restored: before the first move after one, the record is marked as moving,
+// and loop() holds that move back until it is, so the stored position can
+// never claim the axes are somewhere they have left. After a cut mid-move
+// the axes come up unhomed at zero, as they did before.
+class DeviceStore {
+    public:
+        explicit DeviceStore(Device &device);
+
+        // restores what is safe to, before Motion::begin()
+        void begin();
+
+        // from loop(), before Motion::service(); settled says nothing moves
+        // or is about to
+        void service(uint32_t nowMillis, bool settled);
+        // false while the stored state claims the axes are at rest; no move
+        // may start until service() has withdrawn that claim
+        bool mayMove() const;
+
+        uint32_t getWrites() const;
+
+    private:
+        struct ConfigRecord {
+            uint8_t version;
+            uint8_t numberOfAxes;
+            float   limits[DEVICE_MAX_AXES];
+            float   ratios[DEVICE_MAX_AXES];
+            float   accels[DEVICE_MAX_AXES];
+        };
+
+        struct StateRecord {
+            uint8_t version;
+            uint8_t numberOfAxes;
+            bool    atRest;
+            bool    homed[DEVICE_MAX_AXES];
+            int32_t steps[DEVICE_MAX_AXES];
+        };
+
+        void saveConfig();
+        void saveState(bool atRest);
+
+        Device &device;
+        Preferences prefs;
+        bool started = false;
+
+        bool storedAtRest = false;
+        uint32_t settledSince = 0;
+        uint32_t lastCheckpoint = 0;
+        bool checkpointed = false;
+
+        uint32_t savedConfigVersion = 0;
+        uint32_t seenConfigVersion = 0;
+        uint32_t configChanged = 0;
+
+        uint32_t writes = 0;
+};
@@ -0,0 +1,77 @@
+#include "./json_arena.h"
+
+#include <string.h>
+
+static uint8_t serverArenaBuffer[JSON_ARENA_SERVER_SIZE] __attribute__((aligned(8)));
+
+JsonArena serverJsonArena(serverArenaBuffer, sizeof(serverArenaBuffer));
+
+JsonArena::JsonArena(uint8_t *buffer, size_t size) : buffer(buffer), size(size) {
+}
+
+// every block starts on an 8 byte boundary, enough for any JSON value
+size_t JsonArena::align(size_t size) {
+    return (size + 7) & ~(size_t)7;
+}
+
+JsonArena::Header *JsonArena::header(void *ptr) const {
+    return (Header *)ptr - 1;
+}
+
+bool JsonArena::isTop(void *ptr) const {
+    return (uint8_t *)ptr + align(header(ptr)->size) == buffer + top;
+}
+
+void *JsonArena::allocate(size_t size) {
+    const size_t needed = sizeof(Header) + align(size);
+    if (needed > this->size - top) {
+        failures++;
+        return nullptr;
+    }
+
+    Header *block = (Header *)(buffer + top);
+    block->size = size;
+    top += needed;
+    if (top > peak) peak = top;
+    live++;
+    return block + 1;
+}
+
+void JsonArena::deallocate(void *ptr) {
+    if (!ptr) return;
+    if (isTop(ptr)) top = (uint8_t *)header(ptr) - buffer;
+    if (--live == 0) top = 0;
+}
+
+void *JsonArena::reallocate(void *ptr, size_t newSize) {
+    if (!ptr) return allocate(newSize);
+
+    Header *block = header(ptr);
+    if (isTop(ptr)) {
+        const size_t start = (uint8_t *)ptr - buffer;
+        if (align(newSize) > size - start) {
+            failures++;
+            return nullptr;
+        }
+        block->size = newSize;
+        top = start + align(newSize);
+        if (top > peak) peak = top;
+        return ptr;
+    }
+
+    // a block below the top keeps its room when it shrinks
+    if (newSize <= block->size) return ptr;
+    void *moved = allocate(newSize);
+    if (!moved) return nullptr;
+    memcpy(moved, ptr, block->size);
+    deallocate(ptr);
+    return moved;
+}
+
+size_t JsonArena::getUsed() const {return top;}
+
+size_t JsonArena::getPeak() const {return peak;}
+
+size_t JsonArena::getSize() const {return size;}
+
+uint32_t JsonArena::getFailures() const {return failures;}
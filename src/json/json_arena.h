@@ -0,0 +1,54 @@
+#pragma once
+
+#include <ArduinoJson.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Arena size of the task that builds JSON: the async server task, for the
+// HTTP and WebSocket handlers and telemetry.
+#ifndef JSON_ARENA_SERVER_SIZE
+#define JSON_ARENA_SERVER_SIZE 8192
+#endif
+
+// ArduinoJson allocator over a fixed buffer, so that documents never touch
+// the heap. Blocks are carved off the top of the buffer; freeing the topmost
+// block or growing it happens in place, and the whole arena rewinds as soon
+// as no block is live, which is the case whenever every JsonDocument that
+// uses it has gone out of scope.
+//
+// An arena belongs to one task: documents are created on the stack of that
+// task's handlers and never shared with another. When it runs out, the
+// allocation fails and the document reports overflowed().
+class JsonArena : public ArduinoJson::Allocator {
+    public:
+        JsonArena(uint8_t *buffer, size_t size);
+
+        void *allocate(size_t size) override;
+        void deallocate(void *ptr) override;
+        void *reallocate(void *ptr, size_t newSize) override;
+
+        size_t getUsed() const;
+        size_t getPeak() const;
+        size_t getSize() const;
+        uint32_t getFailures() const;
+
+    private:
+        struct Header {
+            size_t size;
+            size_t reserved;
+        };
+
+        static size_t align(size_t size);
+        Header *header(void *ptr) const;
+        bool isTop(void *ptr) const;
+
+        uint8_t *buffer;
+        size_t size;
+        size_t top = 0;
+        size_t peak = 0;
+        uint32_t live = 0;
+        uint32_t failures = 0;
+};
+
+extern JsonArena serverJsonArena;
@@ -11,9 +11,24 @@
 #include <WiFi.h>
 #include <ESPAsyncWebServer.h>
 #include <ArduinoJson.h>
-#include "AsyncJson.h"
 #include <array>
+#include <cmath>
 #include "device/device.h"
+#include "device/device_store.h"
+#include "json/json_arena.h"
+#include "metrics/metrics.h"
+#include "motion/motion.h"
+#include "network/wifi_connection.h"
+#include "protocol/message_assembler.h"
+#include "protocol/protocol.h"
+#include "telemetry/telemetry.h"
+#include "web/asset_cache.h"
+#include "web/json_cache.h"
+#include "web/json_handler.h"
+#include "web/json_response.h"
+#include "web/page_template.h"
+#include "web/server_doorbell.h"
+#include "web/static_assets.h"
 
 
 // ----------------------------------------------------------------------------
@@ -23,10 +38,16 @@
 #define LED_PIN   26
 #define BTN_PIN   22
 #define HTTP_PORT 80
-#define DEVICE_TYPE "1d"
-#define NUMBER_OF_AXES 1
 #define AXIS_LIMIT 80
 
+// a rig with more axes is built with e.g. -D NUMBER_OF_AXES=3 -D DEVICE_TYPE='"3d"'
+#ifndef NUMBER_OF_AXES
+#define NUMBER_OF_AXES 1
+#endif
+#ifndef DEVICE_TYPE
+#define DEVICE_TYPE "1d"
+#endif
+
 
 // ----------------------------------------------------------------------------
 // Definition of global constants
@@ -35,6 +56,10 @@
 // Button debouncing
 const uint8_t DEBOUNCE_DELAY = 10; // in milliseconds
 
+// Step/dir outputs of the stepper drivers, one pair per axis
+const uint8_t STEP_PINS[DEVICE_MAX_AXES] = { 32, 25, 27, 13, 16, 18 };
+const uint8_t DIR_PINS[DEVICE_MAX_AXES]  = { 33, 14,  4, 15, 17, 19 };
+
 // WiFi credentials
 const char *WIFI_SSID = "Orange_Swiatlowod_D850";
 const char *WIFI_PASS = "Gamblersdice";
@@ -112,7 +137,57 @@ Button button      = { BTN_PIN, HIGH, 0, 0 };
 
 AsyncWebServer server(HTTP_PORT);
 AsyncWebSocket ws("/ws");
-Device device;
+Device device(NUMBER_OF_AXES, AXIS_LIMIT);
+Motion motion(device, STEP_PINS, DIR_PINS);
+Telemetry telemetry(ws, device, motion, serverJsonArena);
+// runs Telemetry::send() on the server task once loop() took a sample
+ServerDoorbell doorbell(SERVER_DOORBELL_PORT, []() { telemetry.send(); });
+DeviceStore deviceStore(device);
+MessageAssembler assembler;
+
+
+// ----------------------------------------------------------------------------
+// Performance counters
+// ----------------------------------------------------------------------------
+
+HandlerMetrics loopMetrics("loop", TRACK_LOOP, TRACE_LOOP_MIN_US);
+HandlerMetrics motionMetrics("motion_service", TRACK_LOOP, TRACE_LOOP_MIN_US);
+HandlerMetrics telemetryMetrics("telemetry_service", TRACK_LOOP, TRACE_LOOP_MIN_US);
+HandlerMetrics wsMessageMetrics("ws_message");
+RateMeter loopRate;
+
+// Wraps a route handler so that its calls are counted and timed. The
+// counters are created once, while the routes are registered.
+ArRequestHandlerFunction timed(const char *name, ArRequestHandlerFunction handler) {
+    HandlerMetrics *metrics = new HandlerMetrics(name);
+    return [metrics, handler](AsyncWebServerRequest *request) {
+        MetricsTimer timer(*metrics);
+        handler(request);
+    };
+}
+
+JsonRequestCallback timedJson(const char *name, JsonRequestCallback handler) {
+    HandlerMetrics *metrics = new HandlerMetrics(name);
+    return [metrics, handler](AsyncWebServerRequest *request, JsonVariant &json) {
+        MetricsTimer timer(*metrics);
+        handler(request, json);
+    };
+}
+
+// Ids of the connected WebSocket clients, kept from the connect and
+// disconnect events for their send queue depths: the library's client list
+// is not safe to copy. Twice the clients the server keeps, to also hold the
+// ones cleanupClients() has yet to close. Server task only.
+uint32_t wsClientIds[2 * DEFAULT_MAX_WS_CLIENTS];
+
+void trackClient(uint32_t id, bool connected) {
+    for (uint32_t &slot : wsClientIds) {
+        if (slot == (connected ? 0 : id)) {
+            slot = connected ? id : 0;
+            return;
+        }
+    }
+}
 
 
 // ----------------------------------------------------------------------------
@@ -133,33 +208,186 @@ void initSPIFFS() {
 // Connecting to the WiFi network
 // ----------------------------------------------------------------------------
 
+WifiConnection wifi(WIFI_SSID, WIFI_PASS);
+
+// Returns at once; loop() brings the link up and keeps it up.
 void initWiFi() {
-  WiFi.mode(WIFI_STA);
-  WiFi.begin(WIFI_SSID, WIFI_PASS);
-  Serial.printf("Trying to connect [%s] ", WiFi.macAddress().c_str());
-  while (WiFi.status() != WL_CONNECTED) {
-      Serial.print(".");
-      delay(500);
-  }
-  Serial.printf(" %s\n", WiFi.localIP().toString().c_str());
+    wifi.begin();
+}
+
+const char *linkStateName(LinkState state) {
+    switch (state) {
+        case LINK_CONNECTING: return "connecting";
+        case LINK_UP:         return "up";
+        case LINK_BACKOFF:    return "backoff";
+        default:              return "down";
+    }
 }
 
 // ----------------------------------------------------------------------------
 // Web server initialization
 // ----------------------------------------------------------------------------
 
-String processor(const String &var) {
-    return String(var == "STATE" && led.on ? "on" : "off");
+const char *getLedState() {
+    return led.on ? "on" : "off";
 }
 
+const char *getDeviceTypeName() {
+    return DEVICE_TYPE;
+}
+
+int32_t getAxisCount() {
+    return device.getNumberOfAxes();
+}
+
+const TemplateVar PAGE_VARS[] = {
+    TemplateVar("STATE",          getLedState),
+    TemplateVar("DEVICE_TYPE",    getDeviceTypeName),
+    TemplateVar("NUMBER_OF_AXES", getAxisCount),
+};
+
+AssetCache assetCache;
+PageTemplate indexPage(PAGE_VARS, sizeof(PAGE_VARS) / sizeof(PAGE_VARS[0]));
+
+// Of the page variables only the LED state changes at run time, so each
+// variant is rendered once and kept in the cache under its own key.
 void onRootRequest(AsyncWebServerRequest *request) {
-  request->send(SPIFFS, "/index.html", "text/html", false, processor);
+    const char *key = led.on ? "/index.html#on" : "/index.html#off";
+    AssetRef page = assetCache.get(key);
+    if (!page) {
+        page = indexPage.render();
+        assetCache.put(key, page);
+    }
+    if (!page) {
+        request->send(404);
+        return;
+    }
+    sendAsset(request, page, "text/html", "no-cache");
 }
 
+// index.html is a template and goes through onRootRequest instead
+const StaticAsset ASSETS[] = {
+    { "/index.js",    "application/javascript" },
+    { "/index.css",   "text/css" },
+    { "/favicon.ico", "image/x-icon" },
+};
+
+StaticAssets assets(SPIFFS, assetCache, ASSETS, sizeof(ASSETS) / sizeof(ASSETS[0]));
+
 void initWebServer() {
-    server.on("/", onRootRequest);
+    assets.begin();
+    indexPage.load(SPIFFS, "/index.html");
+    server.on("/", timed("root", onRootRequest));
+    server.addHandler(&assets);
     server.serveStatic("/", SPIFFS, "/");
     server.begin();
+    doorbell.begin();
+}
+
+
+// ----------------------------------------------------------------------------
+// Motion programs
+// ----------------------------------------------------------------------------
+
+// {"position": [x1, x2, ...], "feedrate": f}: null positions leave an axis
+// where the previous waypoint put it, the feedrate (mm/s) is optional
+bool parseWaypoint(JsonObject json, Waypoint &waypoint) {
+    JsonArray position = json["position"];
+    if (position.isNull()) return false;
+
+    waypoint.mask = 0;
+    for (uint8_t i = 0; i < device.getNumberOfAxes() && i < position.size(); i++) {
+        if (position[i].isNull()) continue;
+        if (!position[i].is<float>()) return false;
+        waypoint.positions[i] = position[i];
+        waypoint.mask |= 1 << i;
+    }
+    waypoint.feedrate = json["feedrate"] | 0.0;
+    return true;
+}
+
+// Queues every waypoint or none of them: 400 when one is malformed, 409 when
+// the program queue has no room for all of them, 200 otherwise.
+int queueProgram(JsonArray waypoints) {
+    if (waypoints.isNull()) return 400;
+    if (waypoints.size() > motion.getProgramSpace()) return 409;
+
+    Waypoint waypoint;
+    for (JsonObject json : waypoints) {
+        if (!parseWaypoint(json, waypoint)) return 400;
+    }
+    for (JsonObject json : waypoints) {
+        parseWaypoint(json, waypoint);
+        motion.queueWaypoint(waypoint);
+    }
+    return 200;
+}
+
+const char *motionStateName(MotionState state) {
+    switch (state) {
+        case MOTION_RUNNING: return "running";
+        case MOTION_PAUSED:  return "paused";
+        default:             return "idle";
+    }
+}
+
+void programStatusJson(JsonDocument &json) {
+    ProgramStatus status;
+    motion.getProgramStatus(status);
+    json["state"] = motionStateName(status.state);
+    json["pending"] = status.pending;
+    json["capacity"] = status.capacity;
+    json["started"] = status.started;
+}
+
+
+// ----------------------------------------------------------------------------
+// Axis configuration
+// ----------------------------------------------------------------------------
+
+// {"limits": [l1, ...], "ratios": [r1, ...], "accels": [a1, ...]}: every
+// array is optional and a null entry leaves that axis alone. The whole
+// request is checked before anything changes: 400 when a value is not a
+// number or out of range (see Device::isValidConfig), 409 when a ratio
+// would change while a move or a program is under way or a target waits to
+// be planned (see Motion::configure). Changes are persisted by the
+// DeviceStore.
+int applyAxesConfig(JsonObject config) {
+    JsonArray fields[3] = { config["limits"], config["ratios"], config["accels"] };
+    if (fields[0].isNull() && fields[1].isNull() && fields[2].isNull()) return 400;
+
+    DeviceSnapshot state;
+    device.getSnapshot(state);
+    AxesConfig axes;
+    float *values[3] = { axes.limits, axes.ratios, axes.accels };
+    for (uint8_t i = 0; i < state.numberOfAxes; i++) {
+        values[0][i] = state.limits[i];
+        values[1][i] = state.ratios[i];
+        values[2][i] = state.accels[i];
+        for (uint8_t f = 0; f < 3; f++) {
+            if (fields[f].isNull() || i >= fields[f].size() || fields[f][i].isNull()) continue;
+            if (!fields[f][i].is<float>()) return 400;
+            values[f][i] = fields[f][i];
+        }
+        if (!Device::isValidConfig(values[0][i], values[1][i], values[2][i])) return 400;
+    }
+
+    // loop() applies it, or turns a ratio change down while anything moves
+    return motion.configure(axes) ? 200 : 409;
+}
+
+void axesConfigJson(JsonDocument &json, const DeviceSnapshot &state) {
+    json["version"] = state.configVersion;
+    JsonArray axes = json["axes"].to<JsonArray>();
+    JsonArray limits = json["limits"].to<JsonArray>();
+    JsonArray ratios = json["ratios"].to<JsonArray>();
+    JsonArray accels = json["accels"].to<JsonArray>();
+    for (uint8_t i = 0; i < state.numberOfAxes; i++) {
+        axes.add(i + 1);
+        limits.add(state.limits[i]);
+        ratios.add(state.ratios[i]);
+        accels.add(state.accels[i]);
+    }
 }
 
 
@@ -168,30 +396,187 @@ void initWebServer() {
 // ----------------------------------------------------------------------------
 
 void notifyClients() {
-    JsonDocument json;
+    JsonDocument json(&serverJsonArena);
     json["status"] = led.on ? "on" : "off";
 
-    char data[17];
-    size_t len = serializeJson(json, data);
-    ws.textAll(data, len);
+    AsyncWebSocketMessageBuffer *buffer = makeJsonBuffer(ws, json);
+    if (buffer) ws.textAll(buffer);
 }
 
-void handleWebSocketMessage(void *arg, uint8_t *data, size_t len) {
-    AwsFrameInfo *info = (AwsFrameInfo*)arg;
-    if (info->final && info->index == 0 && info->len == len && info->opcode == WS_TEXT) {
-        JsonDocument json;
-        DeserializationError err = deserializeJson(json, data);
-        if (err) {
-            Serial.print(F("deserializeJson() failed with code "));
-            Serial.println(err.c_str());
-            return;
+// Binary messages follow protocol.h; every command is answered with an Ack
+// that echoes its seq.
+void handleBinaryMessage(AsyncWebSocketClient *client, uint8_t *data, size_t len) {
+    Command command;
+    AckStatus status = decodeCommand(data, len, command);
+    const uint8_t n = command.header.numberOfAxes;
+
+    if (status == ACK_OK) {
+        switch (command.header.type) {
+            case MSG_SET_POSITION: {
+                Waypoint move;
+                move.mask = command.header.flags & ((1 << n) - 1);
+                for (uint8_t i = 0; i < n; i++) {
+                    if ((move.mask & (1 << i)) && !std::isfinite(command.positions[i])) status = ACK_REJECTED;
+                    move.positions[i] = command.positions[i];
+                }
+                if (status != ACK_OK) break;
+                move.feedrate = command.feedrate;
+                motion.moveTo(move);
+                break;
+            }
+            case MSG_HOME:
+                motion.home();
+                break;
+            case MSG_SUBSCRIBE:
+                if (!telemetry.subscribe(client->id(), command.rate, TELEMETRY_BINARY, command.header.flags)) status = ACK_REJECTED;
+                break;
+            case MSG_TOGGLE:
+                led.on = !led.on;
+                notifyClients();
+                break;
+            case MSG_PROGRAM: {
+                if (command.waypointCount > motion.getProgramSpace()) {
+                    status = ACK_FULL;
+                    break;
+                }
+                Waypoint waypoint;
+                waypoint.mask = command.header.flags & ((1 << n) - 1);
+                for (uint16_t w = 0; w < command.waypointCount && status == ACK_OK; w++) {
+                    getWaypoint(command, w, waypoint.positions, waypoint.feedrate);
+                    for (uint8_t i = 0; i < n; i++) {
+                        if (!std::isfinite(waypoint.positions[i])) status = ACK_REJECTED;
+                    }
+                }
+                for (uint16_t w = 0; w < command.waypointCount && status == ACK_OK; w++) {
+                    getWaypoint(command, w, waypoint.positions, waypoint.feedrate);
+                    motion.queueWaypoint(waypoint);
+                }
+                break;
+            }
+            case MSG_PAUSE:
+                motion.pause();
+                break;
+            case MSG_RESUME:
+                motion.resume();
+                break;
+            case MSG_ABORT:
+                motion.abort();
+                break;
+            case MSG_STATUS: {
+                ProgramStatus program;
+                motion.getProgramStatus(program);
+                uint8_t reply[PROTOCOL_HEADER_SIZE + 8];
+                client->binary(reply, encodeProgramStatus(command.header.seq, program.state, program.pending,
+                                                          program.capacity, program.started, reply, sizeof(reply)));
+                return;
+            }
         }
+    }
+
+    uint8_t ack[PROTOCOL_HEADER_SIZE];
+    client->binary(ack, encodeAck(command.header.seq, status, ack, sizeof(ack)));
+}
 
-        const char *action = json["action"];
-        if (strcmp(action, "toggle") == 0) {
-            led.on = !led.on;
-            notifyClients();
+// Text messages are JSON objects with an "action":
+//   {"action": "toggle"}
+//   {"action": "subscribe", "rate": 20}   telemetry at 20 Hz (see Telemetry)
+//   {"action": "subscribe", "axes": [1, 3]}   of axes 1 and 3 only
+//   {"action": "unsubscribe"}
+//   {"action": "program", "waypoints": [...]}   see queueProgram()
+//   {"action": "pause" | "resume" | "abort" | "status"}
+//   {"action": "getConfig"}
+//   {"action": "setConfig", "limits": [...], ...}   see applyAxesConfig()
+// Program actions are answered with
+//   {"type": "programStatus", "result": 200, "state": "running", ...}
+// and config actions with
+//   {"type": "config", "result": 200, "version": 3, "limits": [...], ...}
+// where result is the HTTP status the matching endpoint would reply with.
+// A subscribe finding every telemetry slot taken is answered with
+//   {"type": "error", "action": "subscribe", "result": 503}
+void handleTextMessage(AsyncWebSocketClient *client, uint8_t *data, size_t len) {
+    JsonDocument json(&serverJsonArena);
+    DeserializationError err = deserializeJson(json, data, len);
+    if (err) {
+        Serial.print(F("deserializeJson() failed with code "));
+        Serial.println(err.c_str());
+        return;
+    }
+
+    const char *action = json["action"];
+    if (!action) return;
+    if (strcmp(action, "toggle") == 0) {
+        led.on = !led.on;
+        notifyClients();
+    } else if (strcmp(action, "subscribe") == 0) {
+        // axes count from 1; unknown ones are ignored, none left subscribes
+        // to all of them
+        JsonArray axes = json["axes"];
+        uint8_t axisMask = 0;
+        for (size_t i = 0; i < axes.size(); i++) {
+            const int axis = axes[i] | 0;
+            if (axis >= 1 && axis <= DEVICE_MAX_AXES) axisMask |= 1 << (axis - 1);
         }
+        const uint32_t rate = json["rate"] | (uint32_t)TELEMETRY_DEFAULT_RATE;
+        if (telemetry.subscribe(client->id(), rate, TELEMETRY_JSON, axisMask)) return;
+
+        JsonDocument reply(&serverJsonArena);
+        reply["type"] = "error";
+        reply["action"] = "subscribe";
+        reply["result"] = 503;
+        AsyncWebSocketMessageBuffer *buffer = makeJsonBuffer(ws, reply);
+        if (buffer) client->text(buffer);
+    } else if (strcmp(action, "unsubscribe") == 0) {
+        telemetry.unsubscribe(client->id());
+    } else if (strcmp(action, "getConfig") == 0 || strcmp(action, "setConfig") == 0) {
+        int result = strcmp(action, "setConfig") == 0 ? applyAxesConfig(json.as<JsonObject>()) : 200;
+        JsonDocument reply(&serverJsonArena);
+        reply["type"] = "config";
+        reply["result"] = result;
+        DeviceSnapshot state;
+        device.getSnapshot(state);
+        axesConfigJson(reply, state);
+        AsyncWebSocketMessageBuffer *buffer = makeJsonBuffer(ws, reply);
+        if (buffer) client->text(buffer);
+    } else {
+        int result = 200;
+        if (strcmp(action, "program") == 0) result = queueProgram(json["waypoints"]);
+        else if (strcmp(action, "pause") == 0) motion.pause();
+        else if (strcmp(action, "resume") == 0) motion.resume();
+        else if (strcmp(action, "abort") == 0) motion.abort();
+        else if (strcmp(action, "status") != 0) return;
+
+        JsonDocument reply(&serverJsonArena);
+        reply["type"] = "programStatus";
+        reply["result"] = result;
+        programStatusJson(reply);
+        AsyncWebSocketMessageBuffer *buffer = makeJsonBuffer(ws, reply);
+        if (buffer) client->text(buffer);
+    }
+}
+
+// Messages may arrive fragmented and in pieces; they are dispatched once
+// whole. One that cannot be buffered closes the client with 1009 (too big)
+// or 1013 (try again later), rather than being half executed.
+void handleWebSocketMessage(AsyncWebSocketClient *client, void *arg, uint8_t *data, size_t len) {
+    AwsFrameInfo *info = (AwsFrameInfo*)arg;
+    AssembledMessage message;
+    switch (assembler.feed(client->id(), *info, data, len, message)) {
+        case ASSEMBLER_COMPLETE:
+            break;
+        case ASSEMBLER_TOO_BIG:
+            client->close(1009);
+            return;
+        case ASSEMBLER_NO_BUFFER:
+            client->close(1013);
+            return;
+        default:
+            return;
+    }
+
+    if (message.opcode == WS_BINARY) {
+        handleBinaryMessage(client, message.data, message.len);
+    } else if (message.opcode == WS_TEXT) {
+        handleTextMessage(client, message.data, message.len);
     }
 }
 
@@ -205,13 +590,19 @@ void onEvent(AsyncWebSocket       *server,  //
     switch (type) {
         case WS_EVT_CONNECT:
             Serial.printf("WebSocket client #%u connected from %s\n", client->id(), client->remoteIP().toString().c_str());
+            trackClient(client->id(), true);
             break;
         case WS_EVT_DISCONNECT:
             Serial.printf("WebSocket client #%u disconnected\n", client->id());
+            trackClient(client->id(), false);
+            telemetry.unsubscribe(client->id());
+            assembler.release(client->id());
             break;
-        case WS_EVT_DATA:
-            handleWebSocketMessage(arg, data, len);
+        case WS_EVT_DATA: {
+            MetricsTimer timer(wsMessageMetrics);
+            handleWebSocketMessage(client, arg, data, len);
             break;
+        }
         case WS_EVT_PONG:
         case WS_EVT_ERROR:
             break;
@@ -224,81 +615,233 @@ void initWebSocket() {
 }
 
 
+// Bodies that only change with the Device configuration are built once and
+// served from a JsonCache, with an ETag.
+void buildDeviceType(JsonDocument &json, const DeviceSnapshot &state){
+    json["type"] = DEVICE_TYPE;
+}
+
+void buildNumberOfAxes(JsonDocument &json, const DeviceSnapshot &state){
+    json["numberOfAxes"] = state.numberOfAxes;
+}
+
+void buildAxesLimits(JsonDocument &json, const DeviceSnapshot &state){
+    JsonArray axes = json["axes"].to<JsonArray>();
+    JsonArray limit = json["limits"].to<JsonArray>();
+    JsonArray units = json["units"].to<JsonArray>();
+    for (uint8_t i = 0; i < state.numberOfAxes; i++) {
+        axes.add(i + 1);
+        limit.add(state.limits[i]);
+        units.add("mm");
+    }
+}
+
+JsonCache deviceTypeResponse(device, serverJsonArena, buildDeviceType);
+JsonCache numberOfAxesResponse(device, serverJsonArena, buildNumberOfAxes);
+JsonCache axesLimitsResponse(device, serverJsonArena, buildAxesLimits);
+JsonCache axesConfigResponse(device, serverJsonArena, axesConfigJson);
+
 void getDeviceType(AsyncWebServerRequest *request){
-    JsonDocument json;
-    json["type"] = "1d";
-    char data[17];
-    serializeJson(json, data);
-    request->send(200, "application/json", data);
+    deviceTypeResponse.send(request);
 }
 
 void getNumberOfAxes(AsyncWebServerRequest *request){
-    JsonDocument json;
-    json["numberOfAxes"] = NUMBER_OF_AXES;
-    char data[21];
-    serializeJson(json, data);
-    request->send(200, "application/json", data);
+    numberOfAxesResponse.send(request);
 }
 
 void getPosition(AsyncWebServerRequest *request){
-    JsonDocument json;
+    DeviceSnapshot state;
+    device.getSnapshot(state);
 
+    JsonDocument json(&serverJsonArena);
     JsonArray axes = json["axes"].to<JsonArray>();
-    axes.add(NUMBER_OF_AXES);
-
     JsonArray units = json["units"].to<JsonArray>();
-    units.add("mm");
-
     JsonArray position = json["position"].to<JsonArray>();
-    position.add(device.getPosition());
-
-    char data[128];
-    serializeJson(json, data);
-    request->send(200, "application/json", data);
+    for (uint8_t i = 0; i < state.numberOfAxes; i++) {
+        axes.add(i + 1);
+        units.add("mm");
+        position.add(state.positions[i]);
+    }
+    sendJson(request, json);
 }
 
 void homeAxis(AsyncWebServerRequest *request){
-    device.homeAxis(); //TODO actually home device
+    motion.home(); //TODO actually home device
     request->send(200);
 }
 
 void axisHomeCheck(AsyncWebServerRequest *request){
-    JsonDocument json;
+    DeviceSnapshot state;
+    device.getSnapshot(state);
+    JsonDocument json(&serverJsonArena);
 
     JsonArray axes = json["axesChecked"].to<JsonArray>();
-    axes.add(NUMBER_OF_AXES);
-
     JsonArray status = json["homeStatus"].to<JsonArray>();
-    status.add(device.isHomed());
+    for (uint8_t i = 0; i < state.numberOfAxes; i++) {
+        axes.add(i + 1);
+        status.add((state.homedMask >> i & 1) != 0);
+    }
 
-    char data[128];
-    serializeJson(json, data);
-    request->send(200, "application/json", data);
+    sendJson(request, json);
 }
 
+// Body: {"position": [x1, x2, ...], "mask": [true, false, ...], "feedrate": f}
+// Every axis with a numeric position (and a true mask entry, when a mask is
+// given) is retargeted in the same request to loop(); null entries leave an
+// axis alone. The optional feedrate (mm/s) applies to this and later moves.
+// Replies with the clamped targets of all axes, like /getPosition.
 void setPosition(AsyncWebServerRequest *request, JsonObject jsonObj){
-    if (jsonObj.containsKey("position")) {
-        float position = jsonObj["position"][0] ;
-        device.setPosition(position);
+    JsonArray position = jsonObj["position"];
+    JsonArray axisMask = jsonObj["mask"];
+    if (position.isNull()) {
+        request->send(400);
+        return;
     }
-    request->send(200);
+
+    DeviceSnapshot state;
+    device.getSnapshot(state);
+
+    Waypoint move;
+    move.mask = 0;
+    move.feedrate = jsonObj["feedrate"].is<float>() ? jsonObj["feedrate"].as<float>() : 0.0f;
+    for (uint8_t i = 0; i < state.numberOfAxes && i < position.size(); i++) {
+        if (!position[i].is<float>()) continue;
+        if (!axisMask.isNull() && !axisMask[i].as<bool>()) continue;
+        move.positions[i] = position[i];
+        move.mask |= 1 << i;
+    }
+    motion.moveTo(move);
+
+    JsonDocument json(&serverJsonArena);
+    JsonArray axes = json["axes"].to<JsonArray>();
+    JsonArray units = json["units"].to<JsonArray>();
+    JsonArray targets = json["position"].to<JsonArray>();
+    for (uint8_t i = 0; i < state.numberOfAxes; i++) {
+        float target = state.targets[i];
+        if (move.mask & (1 << i)) target = constrain(move.positions[i], 0.0f, state.limits[i]);
+        axes.add(i + 1);
+        units.add("mm");
+        targets.add(target);
+    }
+    sendJson(request, json);
 }
 
 void getAxesLimits(AsyncWebServerRequest *request){
-    JsonDocument json;
+    axesLimitsResponse.send(request);
+}
 
-    JsonArray axes = json["axes"].to<JsonArray>();
-    axes.add(NUMBER_OF_AXES);
+void getAxesConfig(AsyncWebServerRequest *request){
+    axesConfigResponse.send(request);
+}
 
-    JsonArray limit = json["limits"].to<JsonArray>();
-    limit.add(device.getLimit());
+// Body: see applyAxesConfig(). Replies with the configuration now in effect,
+// like /getAxesConfig, or with the status of a rejected request.
+void setAxesConfig(AsyncWebServerRequest *request, JsonObject jsonObj){
+    const int result = applyAxesConfig(jsonObj);
+    if (result != 200) {
+        request->send(result);
+        return;
+    }
+    getAxesConfig(request);
+}
 
-    JsonArray units = json["units"].to<JsonArray>();
-    units.add("mm");
+void getProgramStatus(AsyncWebServerRequest *request, int code = 200){
+    JsonDocument json(&serverJsonArena);
+    programStatusJson(json);
+    sendJson(request, json, code);
+}
+
+// {"state": "up", "attempts": 1, "connects": 1, "disconnects": 0,
+//  "connectMs": 2150, "readyMs": 2650, "lastReason": 0}
+void getWifiStatus(AsyncWebServerRequest *request){
+    LinkStats stats;
+    wifi.getStats(stats);
+
+    JsonDocument json(&serverJsonArena);
+    json["state"] = linkStateName(stats.state);
+    json["attempts"] = stats.attempts;
+    json["connects"] = stats.connects;
+    json["disconnects"] = stats.disconnects;
+    json["connectMs"] = stats.connectMillis;
+    json["readyMs"] = stats.readyMillis;
+    json["lastReason"] = stats.lastReason;
+    sendJson(request, json);
+}
+
+// Prometheus text format: handler calls and timings, loop() rate, heap,
+// WebSocket send queues, JSON arenas, the asset cache, the WiFi link and
+// the NVS writes.
+void getMetrics(AsyncWebServerRequest *request){
+    AsyncResponseStream *response = request->beginResponseStream(METRICS_CONTENT_TYPE);
+    MetricsWriter metrics(*response);
+
+    writeHandlerMetrics(metrics);
+    metrics.header("loop_rate_hz", "gauge", "loop() iterations in the last second.");
+    metrics.value("loop_rate_hz", loopRate.getRate());
+    metrics.header("uptime_seconds", "counter", "Time since boot.");
+    metrics.value("uptime_seconds", millis() / 1000.0);
+
+    metrics.header("heap_free_bytes", "gauge", "Free heap.");
+    metrics.value("heap_free_bytes", ESP.getFreeHeap());
+    metrics.header("heap_min_free_bytes", "gauge", "Lowest free heap since boot.");
+    metrics.value("heap_min_free_bytes", ESP.getMinFreeHeap());
+    metrics.header("heap_max_alloc_bytes", "gauge", "Largest block the heap can allocate.");
+    metrics.value("heap_max_alloc_bytes", ESP.getMaxAllocHeap());
+
+    metrics.header("ws_clients", "gauge", "Connected WebSocket clients.");
+    metrics.value("ws_clients", ws.count());
+    metrics.header("ws_queue_depth", "gauge", "Messages waiting in the send queue of each WebSocket client.");
+    for (uint32_t id : wsClientIds) {
+        AsyncWebSocketClient *client = id ? ws.client(id) : nullptr;
+        if (client) metrics.value("ws_queue_depth", "client", id, client->queueLen());
+    }
+
+    metrics.header("json_arena_peak_bytes", "gauge", "Most bytes a JSON arena has held at once.");
+    metrics.value("json_arena_peak_bytes", "arena", "server", serverJsonArena.getPeak());
+    metrics.header("json_arena_size_bytes", "gauge", "Size of each JSON arena.");
+    metrics.value("json_arena_size_bytes", "arena", "server", serverJsonArena.getSize());
+    metrics.header("json_arena_failures_total", "counter", "Allocations a JSON arena could not serve.");
+    metrics.value("json_arena_failures_total", "arena", "server", serverJsonArena.getFailures());
+
+    metrics.header("asset_cache_bytes", "gauge", "Asset bodies held in RAM.");
+    metrics.value("asset_cache_bytes", assetCache.getUsed());
+    metrics.header("asset_cache_hits_total", "counter", "Asset requests served from RAM.");
+    metrics.value("asset_cache_hits_total", assetCache.getHits());
+    metrics.header("asset_cache_misses_total", "counter", "Asset requests that went to the filesystem.");
+    metrics.value("asset_cache_misses_total", assetCache.getMisses());
+    metrics.header("asset_cache_evictions_total", "counter", "Asset bodies evicted to make room.");
+    metrics.value("asset_cache_evictions_total", assetCache.getEvictions());
+
+    LinkStats link;
+    wifi.getStats(link);
+    metrics.header("wifi_up", "gauge", "1 while the WiFi link has an address.");
+    metrics.value("wifi_up", link.state == LINK_UP ? 1 : 0);
+    metrics.header("wifi_connects_total", "counter", "Successful WiFi connection attempts.");
+    metrics.value("wifi_connects_total", link.connects);
+    metrics.header("wifi_disconnects_total", "counter", "WiFi link losses.");
+    metrics.value("wifi_disconnects_total", link.disconnects);
+
+    metrics.header("nvs_writes_total", "counter", "Device state and configuration writes to NVS.");
+    metrics.value("nvs_writes_total", deviceStore.getWrites());
+
+    request->send(response);
+}
+
+// The trace ring as a binary dump, see trace.h; tools/trace2chrome.py turns
+// it into a Chrome trace.
+void getTrace(AsyncWebServerRequest *request){
+    AsyncResponseStream *response = request->beginResponseStream("application/octet-stream");
+    writeTrace(*response);
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+}
 
-    char data[128];
-    serializeJson(json, data);
-    request->send(200, "application/json", data);
+// Body: {"waypoints": [{"position": [x1, x2, ...], "feedrate": f}, ...]}
+// Appends the whole list to the program queue, or none of it (400 when a
+// waypoint is malformed, 409 when it does not fit). Replies with the program
+// status in either case.
+void uploadProgram(AsyncWebServerRequest *request, JsonObject jsonObj){
+    getProgramStatus(request, queueProgram(jsonObj["waypoints"]));
 }
 
 // ----------------------------------------------------------------------------
@@ -312,23 +855,37 @@ void setup() {
 
     Serial.begin(115200); delay(500);
 
+    deviceStore.begin();
+    motion.begin();
+
     initSPIFFS();
     initWiFi();
     initWebSocket();
     initWebServer();
-    server.on("/getDeviceType", HTTP_GET, [](AsyncWebServerRequest *request){ getDeviceType(request); });
-    server.on("/getNumberOfAxes", HTTP_GET, [](AsyncWebServerRequest *request){ getNumberOfAxes(request); });
-    server.on("/getPosition", HTTP_GET, [](AsyncWebServerRequest *request){ getPosition(request); });
-    server.on("/homeAxis", HTTP_POST, [](AsyncWebServerRequest *request){ homeAxis(request); });
-    server.on("/axisHomeCheck", HTTP_GET, [](AsyncWebServerRequest *request){ axisHomeCheck(request); });
-    server.on("/getAxesLimits", HTTP_GET, [](AsyncWebServerRequest *request){ getAxesLimits(request); });
-
-    AsyncCallbackJsonWebHandler* handler = new AsyncCallbackJsonWebHandler("/setPosition", [](AsyncWebServerRequest *request, JsonVariant &json) {
-        JsonObject jsonObj = json.as<JsonObject>();
-        setPosition(request, jsonObj);
-        //JsonDocument json;
-    }); 
-    server.addHandler(handler); 
+    server.on("/getDeviceType", HTTP_GET, timed("getDeviceType", [](AsyncWebServerRequest *request){ getDeviceType(request); }));
+    server.on("/getNumberOfAxes", HTTP_GET, timed("getNumberOfAxes", [](AsyncWebServerRequest *request){ getNumberOfAxes(request); }));
+    server.on("/getPosition", HTTP_GET, timed("getPosition", [](AsyncWebServerRequest *request){ getPosition(request); }));
+    server.on("/homeAxis", HTTP_POST, timed("homeAxis", [](AsyncWebServerRequest *request){ homeAxis(request); }));
+    server.on("/axisHomeCheck", HTTP_GET, timed("axisHomeCheck", [](AsyncWebServerRequest *request){ axisHomeCheck(request); }));
+    server.on("/getAxesLimits", HTTP_GET, timed("getAxesLimits", [](AsyncWebServerRequest *request){ getAxesLimits(request); }));
+    server.on("/getAxesConfig", HTTP_GET, timed("getAxesConfig", [](AsyncWebServerRequest *request){ getAxesConfig(request); }));
+    server.on("/getProgramStatus", HTTP_GET, timed("getProgramStatus", [](AsyncWebServerRequest *request){ getProgramStatus(request); }));
+    server.on("/pauseProgram", HTTP_POST, timed("pauseProgram", [](AsyncWebServerRequest *request){ motion.pause(); getProgramStatus(request); }));
+    server.on("/resumeProgram", HTTP_POST, timed("resumeProgram", [](AsyncWebServerRequest *request){ motion.resume(); getProgramStatus(request); }));
+    server.on("/getWifiStatus", HTTP_GET, timed("getWifiStatus", [](AsyncWebServerRequest *request){ getWifiStatus(request); }));
+    server.on("/abortProgram", HTTP_POST, timed("abortProgram", [](AsyncWebServerRequest *request){ motion.abort(); getProgramStatus(request); }));
+    server.on("/metrics", HTTP_GET, timed("metrics", [](AsyncWebServerRequest *request){ getMetrics(request); }));
+    server.on("/trace", HTTP_GET, [](AsyncWebServerRequest *request){ getTrace(request); });
+
+    server.addHandler(new JsonBodyHandler("/setPosition", serverJsonArena, timedJson("setPosition", [](AsyncWebServerRequest *request, JsonVariant &json) {
+        setPosition(request, json.as<JsonObject>());
+    })));
+    server.addHandler(new JsonBodyHandler("/setAxesConfig", serverJsonArena, timedJson("setAxesConfig", [](AsyncWebServerRequest *request, JsonVariant &json) {
+        setAxesConfig(request, json.as<JsonObject>());
+    })));
+    server.addHandler(new JsonBodyHandler("/uploadProgram", serverJsonArena, timedJson("uploadProgram", [](AsyncWebServerRequest *request, JsonVariant &json) {
+        uploadProgram(request, json.as<JsonObject>());
+    })));
 }
 
 
@@ -337,6 +894,18 @@ void setup() {
 // ----------------------------------------------------------------------------
 
 void loop() {
+    MetricsTimer loopTimer(loopMetrics);
+    loopRate.tick(millis());
+
+    wifi.service(millis());
     ws.cleanupClients();
-    
+    deviceStore.service(millis(), motion.isSettled());
+    {
+        MetricsTimer timer(motionMetrics);
+        motion.service(deviceStore.mayMove());
+    }
+    {
+        MetricsTimer timer(telemetryMetrics);
+        if (telemetry.service(millis())) doorbell.ring();
+    }
 }
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include "./metrics.h"
+
+HandlerMetrics *HandlerMetrics::first = nullptr;
+
+// --- HandlerMetrics ----------------------------------------------------------
+
+HandlerMetrics::HandlerMetrics(const char *name, TraceTrack track, uint32_t traceMinMicros)
+    : name(name), traceId(traceName(name)), track(track), traceMinMicros(traceMinMicros),
+      calls(0), totalMillis(0), maxMicros(0), next(first) {
+    first = this;
+}
+
+void HandlerMetrics::record(uint32_t elapsed) {
+    calls.fetch_add(1, std::memory_order_relaxed);
+    totalMicros += elapsed;
+    totalMillis.store(totalMicros / 1000, std::memory_order_relaxed);
+    // takeMaxMicros() may reset it in between
+    uint32_t max = maxMicros.load(std::memory_order_relaxed);
+    while (elapsed > max && !maxMicros.compare_exchange_weak(max, elapsed, std::memory_order_relaxed)) {}
+}
+
+const char *HandlerMetrics::getName() const {
+    return name;
+}
+
+uint16_t HandlerMetrics::getTraceId() const {
+    return traceId;
+}
+
+TraceTrack HandlerMetrics::getTrack() const {
+    return track;
+}
+
+uint32_t HandlerMetrics::getTraceMinMicros() const {
+    return traceMinMicros;
+}
+
+uint32_t HandlerMetrics::getCalls() const {
+    return calls.load(std::memory_order_relaxed);
+}
+
+uint32_t HandlerMetrics::getMillis() const {
+    return totalMillis.load(std::memory_order_relaxed);
+}
+
+uint32_t HandlerMetrics::takeMaxMicros() {
+    return maxMicros.exchange(0, std::memory_order_relaxed);
+}
+
+HandlerMetrics *HandlerMetrics::getNext() const {
+    return next;
+}
+
+HandlerMetrics *HandlerMetrics::getFirst() {
+    return first;
+}
+
+// --- RateMeter ---------------------------------------------------------------
+
+void RateMeter::tick(uint32_t nowMillis) {
+    ticks++;
+    if (nowMillis - windowStart < 1000) return;
+    // a window longer than a second (a stalled loop) still reports per second
+    rate = (uint64_t)ticks * 1000 / (nowMillis - windowStart);
+    windowStart = nowMillis;
+    ticks = 0;
+}
+
+uint32_t RateMeter::getRate() const {
+    return rate;
+}
+
+// --- MetricsWriter -----------------------------------------------------------
+
+MetricsWriter::MetricsWriter(Print &out) : out(out) {}
+
+void MetricsWriter::header(const char *name, const char *type, const char *help) {
+    out.printf("# HELP " METRICS_PREFIX "%s %s\n# TYPE " METRICS_PREFIX "%s %s\n", name, help, name, type);
+}
+
+void MetricsWriter::value(const char *name, double value) {
+    out.printf(METRICS_PREFIX "%s %.10g\n", name, value);
+}
+
+void MetricsWriter::value(const char *name, const char *label, const char *labelValue, double value) {
+    out.printf(METRICS_PREFIX "%s{%s=\"%s\"} %.10g\n", name, label, labelValue, value);
+}
+
+void MetricsWriter::value(const char *name, const char *label, uint32_t labelValue, double value) {
+    out.printf(METRICS_PREFIX "%s{%s=\"%lu\"} %.10g\n", name, label, (unsigned long)labelValue, value);
+}
+
+void writeHandlerMetrics(MetricsWriter &writer) {
+    writer.header("handler_calls_total", "counter", "Calls of each handler.");
+    for (HandlerMetrics *m = HandlerMetrics::getFirst(); m; m = m->getNext()) {
+        writer.value("handler_calls_total", "handler", m->getName(), m->getCalls());
+    }
+    writer.header("handler_seconds_total", "counter", "Time spent in each handler.");
+    for (HandlerMetrics *m = HandlerMetrics::getFirst(); m; m = m->getNext()) {
+        writer.value("handler_seconds_total", "handler", m->getName(), m->getMillis() / 1e3);
+    }
+    writer.header("handler_max_seconds", "gauge", "Longest call of each handler since the previous scrape.");
+    for (HandlerMetrics *m = HandlerMetrics::getFirst(); m; m = m->getNext()) {
+        writer.value("handler_max_seconds", "handler", m->getName(), m->takeMaxMicros() / 1e6);
+    }
+}
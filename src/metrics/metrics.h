@@ -0,0 +1,110 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "./trace.h"
+
+// Prepended to every metric name.
+#define METRICS_PREFIX "controller_"
+
+// Prometheus text exposition format.
+#define METRICS_CONTENT_TYPE "text/plain; version=0.0.4"
+
+// Calls of one handler and the time they took, from micros(): the cycle
+// counter is per core, and the server and loop tasks are not pinned to the
+// same one. Each instance is recorded from a single task and read by
+// /metrics on the server task, so every field it shares is a 32-bit atomic;
+// the total is kept exact by the recording task and published in
+// milliseconds (wrapping after 49 days, like millis()).
+//
+// Instances register themselves in a list that writeHandlerMetrics() walks,
+// and their name with the trace, and so have to live as long as the program.
+// track is the timeline of the task that runs the handler; calls shorter
+// than traceMinMicros are left out of the trace.
+class HandlerMetrics {
+    public:
+        explicit HandlerMetrics(const char *name, TraceTrack track = TRACK_SERVER, uint32_t traceMinMicros = 0);
+
+        // from the task that runs the handler only
+        void record(uint32_t elapsed);
+
+        const char *getName() const;
+        uint16_t getTraceId() const;
+        TraceTrack getTrack() const;
+        uint32_t getTraceMinMicros() const;
+        uint32_t getCalls() const;
+        uint32_t getMillis() const;
+        // longest call since the previous takeMaxMicros()
+        uint32_t takeMaxMicros();
+
+        HandlerMetrics *getNext() const;
+        static HandlerMetrics *getFirst();
+
+    private:
+        const char *name;
+        const uint16_t traceId;
+        const TraceTrack track;
+        const uint32_t traceMinMicros;
+        uint64_t totalMicros = 0;
+        std::atomic<uint32_t> calls;
+        std::atomic<uint32_t> totalMillis;
+        std::atomic<uint32_t> maxMicros;
+
+        HandlerMetrics *next;
+        static HandlerMetrics *first;
+};
+
+// Times the scope it lives in into a HandlerMetrics, and records it in the
+// trace as a span.
+class MetricsTimer {
+    public:
+        explicit MetricsTimer(HandlerMetrics &metrics)
+            : metrics(metrics), startMicros(micros()) {}
+        ~MetricsTimer() {
+            const uint32_t elapsed = micros() - startMicros;
+            metrics.record(elapsed);
+            if (elapsed >= metrics.getTraceMinMicros()) {
+                traceSpan(metrics.getTraceId(), metrics.getTrack(), startMicros);
+            }
+        }
+
+    private:
+        HandlerMetrics &metrics;
+        const uint32_t startMicros;
+};
+
+// Counts the ticks of a loop and reports how many fell in the last whole
+// second. From one task only.
+class RateMeter {
+    public:
+        void tick(uint32_t nowMillis);
+        uint32_t getRate() const;
+
+    private:
+        uint32_t windowStart = 0;
+        uint32_t ticks = 0;
+        uint32_t rate = 0;
+};
+
+// Writes metrics in the Prometheus text format. Names are given without
+// METRICS_PREFIX; every family starts with a header().
+class MetricsWriter {
+    public:
+        explicit MetricsWriter(Print &out);
+
+        void header(const char *name, const char *type, const char *help);
+        void value(const char *name, double value);
+        void value(const char *name, const char *label, const char *labelValue, double value);
+        void value(const char *name, const char *label, uint32_t labelValue, double value);
+
+    private:
+        Print &out;
+};
+
+// Calls, seconds spent and longest call (since the previous scrape) of every
+// HandlerMetrics, labelled by handler name.
+void writeHandlerMetrics(MetricsWriter &writer);
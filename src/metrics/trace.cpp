@@ -0,0 +1,96 @@
+#include "./trace.h"
+
+#include <atomic>
+#include <string.h>
+
+static_assert((TRACE_EVENTS & (TRACE_EVENTS - 1)) == 0, "TRACE_EVENTS must be a power of two");
+
+struct TraceEvent {
+    uint32_t time;
+    uint16_t name;
+    uint8_t  type;
+    uint8_t  track;
+    uint32_t arg;
+};
+
+static const char *names[TRACE_MAX_NAMES];
+static uint16_t nameCount = 0;
+
+// Writers claim a slot with the index, fill it, then set its stamp to the
+// index + 1; a reader trusts a slot whose stamp reads the same before and
+// after copying it.
+static TraceEvent events[TRACE_EVENTS];
+static std::atomic<uint32_t> stamps[TRACE_EVENTS];
+static std::atomic<uint32_t> nextIndex(0);
+
+uint16_t traceName(const char *name) {
+    if (nameCount == TRACE_MAX_NAMES) return TRACE_NO_NAME;
+    names[nameCount] = name;
+    return nameCount++;
+}
+
+static void IRAM_ATTR record(uint32_t time, uint16_t name, TraceType type, TraceTrack track, uint32_t arg) {
+    const uint32_t index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+    const uint32_t slot = index & (TRACE_EVENTS - 1);
+
+    stamps[slot].store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    TraceEvent &event = events[slot];
+    event.time = time;
+    event.name = name;
+    event.type = type;
+    event.track = track;
+    event.arg = arg;
+    stamps[slot].store(index + 1, std::memory_order_release);
+}
+
+void IRAM_ATTR trace(uint16_t name, TraceType type, TraceTrack track, uint32_t arg) {
+    if (name != TRACE_NO_NAME) record(micros(), name, type, track, arg);
+}
+
+void traceSpan(uint16_t name, TraceTrack track, uint32_t startMicros) {
+    if (name != TRACE_NO_NAME) record(startMicros, name, TRACE_SPAN, track, micros() - startMicros);
+}
+
+static void putU32(uint8_t *out, uint32_t value) {
+    out[0] = value;
+    out[1] = value >> 8;
+    out[2] = value >> 16;
+    out[3] = value >> 24;
+}
+
+void writeTrace(Print &out) {
+    uint8_t buffer[12];
+
+    out.write((const uint8_t*)"RCTR", 4);
+    buffer[0] = TRACE_FORMAT_VERSION;
+    buffer[1] = nameCount;
+    out.write(buffer, 2);
+    for (uint16_t i = 0; i < nameCount; i++) {
+        const size_t len = strnlen(names[i], 255);
+        out.write((uint8_t)len);
+        out.write((const uint8_t*)names[i], len);
+    }
+
+    const uint32_t end = nextIndex.load(std::memory_order_acquire);
+    const uint32_t start = end > TRACE_EVENTS ? end - TRACE_EVENTS : 0;
+    putU32(buffer, end);
+    putU32(buffer + 4, micros());
+    out.write(buffer, 8);
+
+    for (uint32_t index = start; index != end; index++) {
+        const uint32_t slot = index & (TRACE_EVENTS - 1);
+        if (stamps[slot].load(std::memory_order_acquire) != index + 1) continue;
+        TraceEvent event = events[slot];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (stamps[slot].load(std::memory_order_relaxed) != index + 1) continue;
+
+        putU32(buffer, event.time);
+        buffer[4] = event.name;
+        buffer[5] = event.name >> 8;
+        buffer[6] = event.type;
+        buffer[7] = event.track;
+        putU32(buffer + 8, event.arg);
+        out.write(buffer, 12);
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <stdint.h>
+
+// Events the ring holds, a power of two; 12 bytes each plus a 4 byte stamp.
+#ifndef TRACE_EVENTS
+#define TRACE_EVENTS 1024
+#endif
+
+// Loop stages faster than this are not traced: at a thousand iterations a
+// second they would flush the ring within a fraction of one.
+#ifndef TRACE_LOOP_MIN_US
+#define TRACE_LOOP_MIN_US 500
+#endif
+
+// Names traceName() can register.
+#define TRACE_MAX_NAMES 64
+#define TRACE_NO_NAME   0xffff
+
+// ----------------------------------------------------------------------------
+// Trace dump format
+// ----------------------------------------------------------------------------
+//
+// Written by writeTrace(), read by tools/trace2chrome.py. Little-endian.
+//
+//   size
+//   4      magic         "RCTR"
+//   1      version       TRACE_FORMAT_VERSION
+//   1      name count
+//   then per name:       uint8 length, the characters (no terminator)
+//   4      recorded      events recorded since boot; more than follow
+//                        means the oldest were overwritten
+//   4      now           micros() when the dump was taken
+//   then, oldest first, until the end of the body, 12 bytes per event:
+//   4      time          micros() of the event, wraps every 71 minutes;
+//                        the start of a TRACE_SPAN
+//   2      name          index into the names
+//   1      type          TraceType
+//   1      track         TraceTrack
+//   4      arg           the duration of a TRACE_SPAN in microseconds,
+//                        otherwise depends on the event
+// ----------------------------------------------------------------------------
+
+#define TRACE_FORMAT_VERSION 1
+
+enum TraceType {
+    TRACE_BEGIN   = 0,
+    TRACE_END     = 1,
+    TRACE_INSTANT = 2,
+    // begin and end in one event, recorded at the end
+    TRACE_SPAN    = 3,
+};
+
+// Timeline of an event: one per task or interrupt recording, so the begin
+// and end events of a track always nest.
+enum TraceTrack {
+    TRACK_SERVER  = 0,
+    TRACK_LOOP    = 1,
+    TRACK_STEPPER = 2,
+    TRACK_WIFI    = 3,
+};
+
+// Registers name, which must outlive the program, and returns its id, or
+// TRACE_NO_NAME once the table is full. During static initialization and
+// setup() only.
+uint16_t traceName(const char *name);
+
+// Appends an event, overwriting the oldest once the ring is full. Lock free,
+// from any task or interrupt.
+void trace(uint16_t name, TraceType type, TraceTrack track, uint32_t arg = 0);
+// a TRACE_SPAN from startMicros to now
+void traceSpan(uint16_t name, TraceTrack track, uint32_t startMicros);
+
+// Writes the events in the ring, skipping any overwritten while being
+// copied; recording goes on meanwhile.
+void writeTrace(Print &out);
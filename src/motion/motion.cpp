@@ -0,0 +1,185 @@
+#include "./motion.h"
+
+// the slowest ramp Device::isValidConfig() lets through, in ticks
+static_assert(MOTION_MAX_STEPS_PER_TICK * MOTION_TICK_HZ * MOTION_TICK_HZ / DEVICE_MIN_STEP_ACCEL <= 4294967295.0,
+              "MOTION_TICK_HZ too high for DEVICE_MIN_STEP_ACCEL");
+
+Motion::Motion(Device &device, const uint8_t *stepPins, const uint8_t *dirPins)
+    : device(device), planner(device, MOTION_TICK_HZ), stepper(stepPins, dirPins, MOTION_TICK_HZ),
+      abortPending(false), paused(false), started(0), configState(ConfigIdle) {
+    for (uint8_t i = 0; i < DEVICE_MAX_AXES; i++) {
+        plannedSteps[i] = 0;
+    }
+}
+
+void Motion::begin() {
+    const int32_t *steps = device.getSteps();
+    for (uint8_t i = 0; i < device.getNumberOfAxes(); i++) {
+        plannedSteps[i] = steps[i];
+    }
+    stepper.begin(device.getNumberOfAxes(), plannedSteps);
+    device.publish();
+}
+
+void Motion::setFeedrate(float feedrate) {
+    if (feedrate > 0.0) this->feedrate = feedrate;
+}
+
+float Motion::getFeedrate() const {return feedrate;}
+
+void Motion::moveTo(const Waypoint &move) {
+    TargetRequest change;
+    change.move = move;
+    change.home = false;
+    request(change);
+}
+
+void Motion::home() {
+    TargetRequest change;
+    change.home = true;
+    request(change);
+}
+
+void Motion::request(const TargetRequest &request) {
+    // delay(), not yield(): loop() runs at a lower priority than the server task
+    while (!targets.push(request)) delay(1);
+}
+
+bool Motion::isMoving() const {return stepper.isBusy();}
+
+float Motion::getVelocity(uint8_t axis) const {
+    const float stepsPerTick = (float)stepper.getVelocity(axis) / ((int32_t)1 << 24);
+    return stepsPerTick * MOTION_TICK_HZ / device.getRatio(axis);
+}
+
+size_t Motion::getProgramSpace() const {
+    return abortPending.load() ? 0 : MOTION_PROGRAM_LENGTH - program.size();
+}
+
+bool Motion::queueWaypoint(const Waypoint &waypoint) {
+    if (abortPending.load()) return false;
+    return program.push(waypoint);
+}
+
+void Motion::pause() {paused.store(true);}
+
+void Motion::resume() {paused.store(false);}
+
+void Motion::abort() {
+    abortPending.store(true);
+}
+
+void Motion::getProgramStatus(ProgramStatus &status) const {
+    status.pending = program.size();
+    status.capacity = MOTION_PROGRAM_LENGTH;
+    status.started = started.load();
+    if (paused.load()) status.state = MOTION_PAUSED;
+    else if (status.pending || stepper.isBusy()) status.state = MOTION_RUNNING;
+    else status.state = MOTION_IDLE;
+}
+
+bool Motion::isSettled() const {
+    if (stepper.isBusy() || !program.isEmpty() || !targets.isEmpty() || abortPending.load()) return false;
+    int32_t targetSteps[DEVICE_MAX_AXES];
+    device.getTargetSteps(targetSteps);
+    for (uint8_t i = 0; i < device.getNumberOfAxes(); i++) {
+        if (targetSteps[i] != plannedSteps[i]) return false;
+    }
+    return true;
+}
+
+bool Motion::configure(const AxesConfig &config) {
+    pendingConfig = config;
+    configState.store(ConfigPending);
+    // delay(), not yield(): loop() runs at a lower priority than the server task
+    while (configState.load() == ConfigPending) delay(1);
+    return configState.exchange(ConfigIdle) == ConfigApplied;
+}
+
+Motion::ConfigState Motion::applyConfig() {
+    const uint8_t n = device.getNumberOfAxes();
+    const AxesConfig &config = pendingConfig;
+    bool ratioChanged = false;
+    for (uint8_t i = 0; i < n; i++) {
+        if (config.ratios[i] != device.getRatio(i)) ratioChanged = true;
+    }
+    if (ratioChanged && !isSettled()) return ConfigRejected;
+
+    for (uint8_t i = 0; i < n; i++) {
+        if (config.limits[i] == device.getLimit(i) && config.ratios[i] == device.getRatio(i) && config.accels[i] == device.getAccel(i)) continue;
+        device.setAxisConfig(i, config.limits[i], config.ratios[i], config.accels[i]);
+    }
+    return ConfigApplied;
+}
+
+void Motion::service(bool mayStart) {
+    const bool configuring = configState.load() == ConfigPending;
+    const ConfigState result = configuring ? applyConfig() : ConfigIdle;
+    update(mayStart);
+    device.publish();
+    if (configuring) configState.store(result);
+}
+
+void Motion::update(bool mayStart) {
+    if (abortPending.load()) {
+        stepper.stop();
+        Waypoint waypoint;
+        while (program.pop(waypoint)) {}
+        started.store(0);
+        paused.store(false);
+
+        // hold the axes where they stopped
+        float positions[DEVICE_MAX_AXES];
+        stepper.getSteps(plannedSteps);
+        device.setSteps(plannedSteps);
+        device.getPositions(positions);
+        device.setPositions(positions);
+        abortPending.store(false);
+        return;
+    }
+
+    // target changes up to the first home, which ends this update
+    TargetRequest request;
+    while (targets.pop(request)) {
+        if (request.home) {
+            applyHome();
+            return;
+        }
+        device.setPositions(request.move.positions, request.move.mask);
+        setFeedrate(request.move.feedrate);
+    }
+
+    int32_t steps[DEVICE_MAX_AXES];
+    stepper.getSteps(steps);
+    device.setSteps(steps);
+
+    if (mayStart && !paused.load() && stepper.queued() < MOTION_LOOKAHEAD) planNext();
+}
+
+void Motion::applyHome() {
+    stepper.home();
+    for (uint8_t i = 0; i < DEVICE_MAX_AXES; i++) {
+        plannedSteps[i] = 0;
+    }
+    device.homeAxes();
+}
+
+void Motion::planNext() {
+    float rate = feedrate;
+    Waypoint waypoint;
+    if (program.pop(waypoint)) {
+        device.setPositions(waypoint.positions, waypoint.mask);
+        if (waypoint.feedrate > 0.0) rate = waypoint.feedrate;
+        started++;
+    }
+
+    int32_t targetSteps[DEVICE_MAX_AXES];
+    device.getTargetSteps(targetSteps);
+
+    Segment segment;
+    if (!planner.plan(plannedSteps, targetSteps, rate, segment)) return;
+    if (!stepper.push(segment)) return;
+    for (uint8_t i = 0; i < device.getNumberOfAxes(); i++) {
+        plannedSteps[i] = targetSteps[i];
+    }
+}
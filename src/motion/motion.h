@@ -0,0 +1,159 @@
+#pragma once
+
+#include <atomic>
+
+#include "./planner.h"
+#include "./stepper.h"
+
+// Fixed tick rate of the step interrupt; an axis steps at up to half of it.
+#ifndef MOTION_TICK_HZ
+#define MOTION_TICK_HZ 10000
+#endif
+
+// Path speed in mm/s used when a move does not ask for one.
+#define MOTION_DEFAULT_FEEDRATE 20.0
+
+// Waypoints of an uploaded program waiting to run.
+#ifndef MOTION_PROGRAM_LENGTH
+#define MOTION_PROGRAM_LENGTH 64
+#endif
+
+// Target changes from the server task waiting for the next service().
+#ifndef MOTION_TARGET_QUEUE_LENGTH
+#define MOTION_TARGET_QUEUE_LENGTH 8
+#endif
+
+// Segments handed to the Stepper ahead of the one it executes: enough to
+// chain moves without a gap, few enough for pause and abort to act quickly.
+#define MOTION_LOOKAHEAD 2
+
+// One target of an uploaded motion program.
+struct Waypoint {
+    float   positions[DEVICE_MAX_AXES];
+    // axes this waypoint moves, one bit per axis
+    uint8_t mask;
+    // path speed in mm/s for this move; <= 0 uses the current feedrate
+    float   feedrate;
+};
+
+// A change of the commanded targets, handed to loop() by Motion::moveTo()
+// and home() in the order they were asked for.
+struct TargetRequest {
+    // positions, mask and feedrate as for a Waypoint, except that a
+    // feedrate > 0 stays in effect for later moves
+    Waypoint move;
+    // zero every axis instead of moving
+    bool     home;
+};
+
+// A configuration for every axis, handed to Motion::configure().
+struct AxesConfig {
+    float limits[DEVICE_MAX_AXES];
+    float ratios[DEVICE_MAX_AXES];
+    float accels[DEVICE_MAX_AXES];
+};
+
+enum MotionState {
+    MOTION_IDLE,
+    MOTION_RUNNING,
+    MOTION_PAUSED,
+};
+
+struct ProgramStatus {
+    MotionState state;
+    // waypoints waiting in the program queue, out of capacity
+    uint16_t pending;
+    uint16_t capacity;
+    // waypoints started since boot or the last abort
+    uint32_t started;
+};
+
+// Drives the Device's axes towards their commanded targets. Planning runs in
+// loop(): whenever the targets differ from where the last planned move ends
+// and the Stepper has room, a new segment is queued from there, so a target
+// changed mid-move is picked up once the moves already queued have run.
+//
+// Uploaded programs are kept in a ring buffer of waypoints; each one becomes
+// the commanded target in turn as soon as the Stepper has room, so a whole
+// program runs without a round trip per waypoint.
+class Motion {
+    public:
+        Motion(Device &device, const uint8_t *stepPins, const uint8_t *dirPins);
+
+        // starts the step interrupt, from where the Device says the axes are
+        void begin();
+
+        // from loop() only
+        void setFeedrate(float feedrate);
+        float getFeedrate() const;
+
+        // Commanded target changes, from the server task only. Each is
+        // applied whole by the next service(), so loop() never plans from a
+        // target vector half written; while MOTION_TARGET_QUEUE_LENGTH of
+        // them are still waiting, these wait for loop() like configure().
+        // moveTo() retargets the axes set in move.mask, clamped like
+        // Device::setPositions(); home() stops any move and zeroes every axis.
+        void moveTo(const Waypoint &move);
+        void home();
+
+        // plans queued moves, hands the step counts to the Device and
+        // publishes its snapshot, from loop() only; with mayStart false no
+        // new move is planned
+        void service(bool mayStart = true);
+        // nothing moving, queued or waiting to be planned, from loop() only
+        bool isSettled() const;
+
+        // Sets the limit, ratio and acceleration of every axis, each already
+        // checked with Device::isValidConfig(). From the server task: the
+        // next service() applies it between two plans, so loop() never sees
+        // a configuration half written, and this waits until a snapshot
+        // with it is published. Returns
+        // false, changing nothing, when a ratio would change while the axes
+        // are not settled, since the step counts in flight would then mean
+        // something else.
+        bool configure(const AxesConfig &config);
+
+        // Program queue, fed from the server task only. Callers check
+        // getProgramSpace() first to accept a batch whole or not at all.
+        size_t getProgramSpace() const;
+        bool queueWaypoint(const Waypoint &waypoint);
+
+        // pause holds planning: the moves already handed to the Stepper
+        // (at most MOTION_LOOKAHEAD + 1) finish, then the axes wait
+        void pause();
+        void resume();
+        // stops the axes where they are and drops the rest of the program;
+        // the queue refuses waypoints until the next service()
+        void abort();
+        void getProgramStatus(ProgramStatus &status) const;
+
+        bool isMoving() const;
+        // current velocity of an axis in mm/s
+        float getVelocity(uint8_t axis) const;
+
+    private:
+        enum ConfigState { ConfigIdle, ConfigPending, ConfigApplied, ConfigRejected };
+
+        void request(const TargetRequest &request);
+        ConfigState applyConfig();
+        void applyHome();
+        void update(bool mayStart);
+        void planNext();
+
+        Device &device;
+        Planner planner;
+        Stepper stepper;
+
+        SpscQueue<Waypoint, MOTION_PROGRAM_LENGTH> program;
+        SpscQueue<TargetRequest, MOTION_TARGET_QUEUE_LENGTH> targets;
+        std::atomic<bool> abortPending;
+        std::atomic<bool> paused;
+        std::atomic<uint32_t> started;
+
+        // handed from configure() to service()
+        AxesConfig pendingConfig;
+        std::atomic<uint8_t> configState;
+
+        int32_t plannedSteps[DEVICE_MAX_AXES];
+        float feedrate = MOTION_DEFAULT_FEEDRATE;
+};
@@ -0,0 +1,72 @@
+#include "./planner.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+Planner::Planner(const Device &device, uint32_t tickRate) : device(device), tickRate(tickRate) {
+}
+
+uint32_t Planner::getTickRate() const {return tickRate;}
+
+bool Planner::plan(const int32_t *fromSteps, const int32_t *toSteps, float feedrate, Segment &segment) const {
+    const uint8_t n = device.getNumberOfAxes();
+    const float *ratios = device.getRatios();
+    const float *accels = device.getAccels();
+
+    // path length in mm and the largest step count of any axis
+    float distance = 0.0;
+    int32_t maxSteps = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        int32_t delta = toSteps[i] - fromSteps[i];
+        float mm = delta / ratios[i];
+        distance += mm * mm;
+        if (abs(delta) > maxSteps) maxSteps = abs(delta);
+    }
+    if (maxSteps == 0) return false;
+    distance = sqrtf(distance);
+
+    // path acceleration and speed that keep every axis within its own limits
+    float accel = INFINITY;
+    float speed = feedrate > 0.0 ? feedrate : INFINITY;
+    for (uint8_t i = 0; i < n; i++) {
+        int32_t delta = toSteps[i] - fromSteps[i];
+        if (delta == 0) continue;
+        float share = fabsf(delta / ratios[i]) / distance;
+        if (accels[i] / share < accel) accel = accels[i] / share;
+        const float maxSpeed = MOTION_MAX_STEPS_PER_TICK * tickRate / ratios[i] / share;
+        if (maxSpeed < speed) speed = maxSpeed;
+    }
+
+    // trapezoid, or triangle when the move is too short to reach full speed
+    float accelTime = speed / accel;
+    float accelDistance = speed * accelTime / 2;
+    if (2 * accelDistance > distance) {
+        speed = sqrtf(accel * distance);
+        accelTime = speed / accel;
+        accelDistance = distance / 2;
+    }
+    float cruiseTime = (distance - 2 * accelDistance) / speed;
+
+    uint32_t accelTicks = (uint32_t)(accelTime * tickRate + 0.5);
+    uint32_t cruiseTicks = (uint32_t)(cruiseTime * tickRate + 0.5);
+    if (accelTicks == 0) accelTicks = 1;
+    // rounding must not push any axis past MOTION_MAX_STEPS_PER_TICK
+    const uint32_t minTicks = (uint32_t)ceilf(maxSteps / MOTION_MAX_STEPS_PER_TICK);
+    if (accelTicks + cruiseTicks < minTicks) cruiseTicks = minTicks - accelTicks;
+
+    // with v += a while accelerating and p += v every tick, the profile covers
+    // a * accelTicks * (accelTicks + cruiseTicks): solve that for a per axis
+    // (a is Q16.48, split in two divisions so no intermediate overflows)
+    const int extraShift = MOTION_VELOCITY_SHIFT - MOTION_FIXED_SHIFT;
+    int64_t area = (int64_t)accelTicks * (accelTicks + cruiseTicks);
+    segment.accelTicks = accelTicks;
+    segment.cruiseTicks = cruiseTicks;
+    for (uint8_t i = 0; i < n; i++) {
+        int64_t scaled = ((int64_t)toSteps[i] - fromSteps[i]) << MOTION_FIXED_SHIFT;
+        segment.startSteps[i] = fromSteps[i];
+        segment.endSteps[i] = toSteps[i];
+        segment.accel[i] = (scaled / area) * ((int64_t)1 << extraShift)
+                         + (scaled % area) * ((int64_t)1 << extraShift) / area;
+    }
+    return true;
+}
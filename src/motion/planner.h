@@ -0,0 +1,26 @@
+#pragma once
+
+#include "./segment.h"
+
+// Fastest step rate the planner asks of an axis. A step pulse is high for
+// a tick and its pin has to stay low for at least another one before the
+// next (A4988 drivers need 1 us, DRV8825 1.9 us), so every other tick.
+#define MOTION_MAX_STEPS_PER_TICK 0.5
+
+// Turns a move between two step positions into a Segment, using the
+// Device's per-axis ratio (steps/mm) and acceleration (mm/s^2).
+class Planner {
+    public:
+        Planner(const Device &device, uint32_t tickRate);
+
+        // feedrate is the path speed in mm/s; it is lowered when an axis
+        // would need more than MOTION_MAX_STEPS_PER_TICK or the move is too
+        // short to reach it. Returns false when there is nothing to move.
+        bool plan(const int32_t *fromSteps, const int32_t *toSteps, float feedrate, Segment &segment) const;
+
+        uint32_t getTickRate() const;
+
+    private:
+        const Device &device;
+        uint32_t tickRate;
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "../device/device.h"
+
+// Step positions are Q32.32 fixed point: whole steps in the upper word, the
+// fraction of a step in the lower one. Velocities and accelerations stay
+// below one step per tick (see MOTION_MAX_STEPS_PER_TICK) and carry 16 more fraction bits, so that the
+// slow ramps of a fast tick rate are not lost to rounding.
+#define MOTION_FIXED_SHIFT    32
+#define MOTION_FIXED_HALF     ((int64_t)1 << (MOTION_FIXED_SHIFT - 1))
+#define MOTION_VELOCITY_SHIFT 48
+
+// One coordinated straight-line move with a trapezoidal velocity profile.
+// Every constant the tick needs is precomputed by the Planner, so executing
+// it is a fixed number of integer adds per axis and tick.
+struct Segment {
+    // ticks spent accelerating, and again decelerating
+    uint32_t accelTicks;
+    // ticks at constant velocity in between
+    uint32_t cruiseTicks;
+    int32_t  startSteps[DEVICE_MAX_AXES];
+    int32_t  endSteps[DEVICE_MAX_AXES];
+    // per-tick velocity change in steps/tick, Q16.48
+    int64_t  accel[DEVICE_MAX_AXES];
+};
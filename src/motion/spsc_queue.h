@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+// Bounded lock-free queue between exactly one producer and one consumer,
+// e.g. loop() planning segments and the step timer interrupt running them.
+// Neither side ever blocks or allocates; N must be a power of two. Every
+// accessor is kept in IRAM so that an interrupt can use the queue while the
+// flash cache is disabled.
+template <typename T, size_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+    public:
+        SpscQueue() : head(0), tail(0) {}
+
+        // producer side; false when the queue is full
+        IRAM_ATTR bool push(const T &item) {
+            const uint32_t h = head.load(std::memory_order_relaxed);
+            if (h - tail.load(std::memory_order_acquire) == N) return false;
+            items[h & (N - 1)] = item;
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        // consumer side; false when the queue is empty
+        IRAM_ATTR bool pop(T &item) {
+            const uint32_t t = tail.load(std::memory_order_relaxed);
+            if (head.load(std::memory_order_acquire) == t) return false;
+            item = items[t & (N - 1)];
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        // consumer side
+        IRAM_ATTR void clear() {
+            tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+        }
+
+        IRAM_ATTR size_t size() const {
+            return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+        }
+        IRAM_ATTR bool isEmpty() const {return size() == 0;}
+        IRAM_ATTR bool isFull() const {return size() == N;}
+
+    private:
+        T items[N];
+        // free-running counters, wrapped into items[] with a mask
+        std::atomic<uint32_t> head;
+        std::atomic<uint32_t> tail;
+};
@@ -0,0 +1,155 @@
+#include "./stepper.h"
+
+#include "../metrics/trace.h"
+
+Stepper *Stepper::instance = nullptr;
+
+// Segments show up in the trace as spans on the stepper track, the stops and
+// homings that cut them short as instants. Every tick too when built with
+// TRACE_STEPPER_TICKS, at the cost of filling the ring within a fraction of
+// a second.
+static const uint16_t SEGMENT_TRACE = traceName("segment");
+static const uint16_t STOP_TRACE = traceName("stepper_stop");
+static const uint16_t HOME_TRACE = traceName("stepper_home");
+#ifdef TRACE_STEPPER_TICKS
+static const uint16_t TICK_TRACE = traceName("step_tick");
+#endif
+
+Stepper::Stepper(const uint8_t *stepPins, const uint8_t *dirPins, uint32_t tickRate)
+    : tickRate(tickRate), pending(None), busy(false) {
+    for (uint8_t i = 0; i < DEVICE_MAX_AXES; i++) {
+        this->stepPins[i] = stepPins[i];
+        this->dirPins[i] = dirPins[i];
+        wanted[i] = 0;
+        current[i] = 0;
+        forward[i] = true;
+        steps[i].store(0);
+        velocity[i].store(0);
+    }
+}
+
+void Stepper::begin(uint8_t numberOfAxes, const int32_t *position) {
+    this->numberOfAxes = numberOfAxes;
+    for (uint8_t i = 0; i < numberOfAxes; i++) {
+        current[i] = position ? position[i] : 0;
+        wanted[i] = current[i];
+        steps[i].store(current[i]);
+        pinMode(stepPins[i], OUTPUT);
+        pinMode(dirPins[i], OUTPUT);
+        digitalWrite(stepPins[i], LOW);
+        digitalWrite(dirPins[i], HIGH);
+    }
+
+    // the 80 MHz APB clock divided down to 1 MHz, firing every tick
+    instance = this;
+    timer = timerBegin(STEPPER_TIMER, 80, true);
+    timerAttachInterrupt(timer, &Stepper::onTimer, true);
+    timerAlarmWrite(timer, 1000000 / tickRate, true);
+    timerAlarmEnable(timer);
+}
+
+bool Stepper::push(const Segment &segment) {
+    if (!queue.push(segment)) return false;
+    busy.store(true);
+    return true;
+}
+
+bool Stepper::canPush() const {return !queue.isFull();}
+
+size_t Stepper::queued() const {return queue.size();}
+
+void Stepper::stop() {
+    request(Stop);
+}
+
+void Stepper::home() {
+    request(Home);
+}
+
+void Stepper::request(Request request) {
+    if (!timer) return;
+    pending.store(request);
+    while (pending.load() != None) yield();
+}
+
+bool Stepper::isBusy() const {return busy.load();}
+
+void Stepper::getSteps(int32_t *out) const {
+    for (uint8_t i = 0; i < numberOfAxes; i++) {
+        out[i] = steps[i].load(std::memory_order_relaxed);
+    }
+}
+
+int32_t Stepper::getVelocity(uint8_t axis) const {
+    return axis < numberOfAxes ? velocity[axis].load(std::memory_order_relaxed) : 0;
+}
+
+uint32_t Stepper::getTickRate() const {return tickRate;}
+
+void IRAM_ATTR Stepper::onTimer() {
+#ifdef TRACE_STEPPER_TICKS
+    trace(TICK_TRACE, TRACE_BEGIN, TRACK_STEPPER);
+#endif
+    instance->tick();
+#ifdef TRACE_STEPPER_TICKS
+    trace(TICK_TRACE, TRACE_END, TRACK_STEPPER);
+#endif
+}
+
+void IRAM_ATTR Stepper::tick() {
+    // end the pulses raised on the previous tick; those pins rest this tick
+    const uint8_t lowered = pulsing;
+    for (uint8_t i = 0; pulsing; i++) {
+        if (pulsing & (1 << i)) digitalWrite(stepPins[i], LOW);
+        pulsing &= ~(1 << i);
+    }
+
+    const uint8_t request = pending.load();
+    if (request != None) {
+        if (trajectory.isBusy()) trace(SEGMENT_TRACE, TRACE_END, TRACK_STEPPER);
+        trace(request == Home ? HOME_TRACE : STOP_TRACE, TRACE_INSTANT, TRACK_STEPPER);
+        trajectory.stop();
+        while (queue.pop(next)) {}
+        for (uint8_t i = 0; i < numberOfAxes; i++) {
+            if (request == Home) current[i] = 0;
+            wanted[i] = current[i];
+            steps[i].store(current[i], std::memory_order_relaxed);
+            velocity[i].store(0, std::memory_order_relaxed);
+        }
+        busy.store(false);
+        pending.store(None);
+        return;
+    }
+
+    if (!trajectory.isBusy() && queue.pop(next)) {
+        trajectory.start(next, numberOfAxes);
+        trace(SEGMENT_TRACE, TRACE_BEGIN, TRACK_STEPPER, 2 * next.accelTicks + next.cruiseTicks);
+    }
+    if (trajectory.isBusy()) {
+        trajectory.tick(wanted);
+        for (uint8_t i = 0; i < numberOfAxes; i++) {
+            velocity[i].store((int32_t)(trajectory.getVelocity(i) >> 24), std::memory_order_relaxed);
+        }
+        if (!trajectory.isBusy()) trace(SEGMENT_TRACE, TRACE_END, TRACK_STEPPER);
+    }
+
+    // at most one step per axis every other tick towards where the profile wants it
+    bool moving = trajectory.isBusy();
+    for (uint8_t i = 0; i < numberOfAxes; i++) {
+        if (wanted[i] == current[i]) continue;
+        moving = true;
+        bool up = wanted[i] > current[i];
+        if (up != forward[i]) {
+            forward[i] = up;
+            digitalWrite(dirPins[i], up ? HIGH : LOW);
+            continue;
+        }
+        // a step the profile asked for too soon waits for the next tick
+        if (lowered & (1 << i)) continue;
+        digitalWrite(stepPins[i], HIGH);
+        pulsing |= 1 << i;
+        current[i] += up ? 1 : -1;
+        steps[i].store(current[i], std::memory_order_relaxed);
+    }
+    busy.store(moving || !queue.isEmpty());
+}
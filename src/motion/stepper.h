@@ -0,0 +1,86 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <atomic>
+
+#include "./spsc_queue.h"
+#include "./trajectory.h"
+
+// Hardware timer running the step interrupt.
+#ifndef STEPPER_TIMER
+#define STEPPER_TIMER 0
+#endif
+
+// Segments planned ahead of the one being executed.
+#define STEPPER_QUEUE_LENGTH 8
+
+// Step/dir pulse engine. A hardware timer interrupt ticks the Trajectory at
+// a fixed rate and turns its step counts into pulses, so that loop() and the
+// async server task only ever feed it planned Segments through a lock-free
+// queue and can never delay a step.
+//
+// A step pulse lasts one tick: it is raised on one interrupt and lowered on
+// the next, and the pin then stays low for at least one more tick, so the
+// driver always sees a whole tick of low time. When an axis reverses, its dir pin changes one tick before the
+// next step, to honour the driver's direction setup time.
+class Stepper {
+    public:
+        Stepper(const uint8_t *stepPins, const uint8_t *dirPins, uint32_t tickRate);
+
+        // configures the pins and starts the timer interrupt, with the axes
+        // at position (in steps), or at zero
+        void begin(uint8_t numberOfAxes, const int32_t *position = nullptr);
+
+        // producer side, from a single task
+        bool push(const Segment &segment);
+        bool canPush() const;
+        // segments waiting behind the one being executed
+        size_t queued() const;
+
+        // stop at once and drop every queued segment; home() also makes the
+        // current position zero on all axes. Both return once the interrupt
+        // has done it.
+        void stop();
+        void home();
+
+        bool isBusy() const;
+        void getSteps(int32_t *out) const;
+        // current velocity of an axis in steps/tick, Q8.24
+        int32_t getVelocity(uint8_t axis) const;
+
+        uint32_t getTickRate() const;
+
+    private:
+        enum Request { None, Stop, Home };
+
+        void request(Request request);
+        static void onTimer();
+        void tick();
+
+        static Stepper *instance;
+
+        // copied out of the caller's tables, which may live in flash: the
+        // interrupt must keep running while a flash write disables the cache
+        uint8_t stepPins[DEVICE_MAX_AXES];
+        uint8_t dirPins[DEVICE_MAX_AXES];
+        const uint32_t tickRate;
+        uint8_t numberOfAxes = 0;
+        hw_timer_t *timer = nullptr;
+
+        SpscQueue<Segment, STEPPER_QUEUE_LENGTH> queue;
+        std::atomic<uint8_t> pending;
+        std::atomic<bool> busy;
+
+        // interrupt state
+        Trajectory trajectory;
+        Segment next;
+        int32_t wanted[DEVICE_MAX_AXES];
+        int32_t current[DEVICE_MAX_AXES];
+        bool    forward[DEVICE_MAX_AXES];
+        uint8_t pulsing = 0;
+
+        // published by the interrupt for the other tasks
+        std::atomic<int32_t> steps[DEVICE_MAX_AXES];
+        std::atomic<int32_t> velocity[DEVICE_MAX_AXES];
+};
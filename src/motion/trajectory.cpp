@@ -0,0 +1,71 @@
+#include "./trajectory.h"
+
+#include <Arduino.h>
+
+Trajectory::Trajectory() {
+    for (uint8_t i = 0; i < DEVICE_MAX_AXES; i++) {
+        position[i] = 0;
+        velocity[i] = 0;
+        accel[i] = 0;
+        endSteps[i] = 0;
+    }
+}
+
+void IRAM_ATTR Trajectory::start(const Segment &segment, uint8_t numberOfAxes) {
+    this->numberOfAxes = numberOfAxes;
+    accelTicks = segment.accelTicks;
+    cruiseTicks = segment.cruiseTicks;
+    for (uint8_t i = 0; i < numberOfAxes; i++) {
+        position[i] = (int64_t)segment.startSteps[i] << MOTION_FIXED_SHIFT;
+        velocity[i] = 0;
+        accel[i] = segment.accel[i];
+        endSteps[i] = segment.endSteps[i];
+    }
+    ticksLeft = accelTicks;
+    phase = Accelerating;
+}
+
+void IRAM_ATTR Trajectory::stop() {
+    phase = Idle;
+    for (uint8_t i = 0; i < numberOfAxes; i++) {
+        velocity[i] = 0;
+    }
+}
+
+bool IRAM_ATTR Trajectory::isBusy() const {return phase != Idle;}
+
+int64_t IRAM_ATTR Trajectory::getVelocity(uint8_t axis) const {return axis < numberOfAxes ? velocity[axis] : 0;}
+
+bool IRAM_ATTR Trajectory::tick(int32_t *steps) {
+    if (phase == Idle) return false;
+
+    if (phase == Accelerating) {
+        for (uint8_t i = 0; i < numberOfAxes; i++) velocity[i] += accel[i];
+    } else if (phase == Decelerating) {
+        for (uint8_t i = 0; i < numberOfAxes; i++) velocity[i] -= accel[i];
+    }
+    for (uint8_t i = 0; i < numberOfAxes; i++) {
+        position[i] += velocity[i] >> (MOTION_VELOCITY_SHIFT - MOTION_FIXED_SHIFT);
+        steps[i] = (int32_t)((position[i] + MOTION_FIXED_HALF) >> MOTION_FIXED_SHIFT);
+    }
+
+    if (--ticksLeft == 0) nextPhase(steps);
+    return true;
+}
+
+void IRAM_ATTR Trajectory::nextPhase(int32_t *steps) {
+    if (phase == Accelerating && cruiseTicks > 0) {
+        phase = Cruising;
+        ticksLeft = cruiseTicks;
+    } else if (phase != Decelerating) {
+        phase = Decelerating;
+        ticksLeft = accelTicks;
+    } else {
+        // land exactly on the target, whatever the fixed point rounding did
+        for (uint8_t i = 0; i < numberOfAxes; i++) {
+            steps[i] = endSteps[i];
+            velocity[i] = 0;
+        }
+        phase = Idle;
+    }
+}
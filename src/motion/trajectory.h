@@ -0,0 +1,37 @@
+#pragma once
+
+#include "./segment.h"
+
+// Executes one Segment, one tick at a time. Runs in the step interrupt, so
+// everything it calls there is kept in IRAM.
+class Trajectory {
+    public:
+        Trajectory();
+
+        void start(const Segment &segment, uint8_t numberOfAxes);
+        void stop();
+        bool isBusy() const;
+
+        // advances the profile by one tick and writes the step count of each
+        // axis to steps; returns false once the segment has completed
+        bool tick(int32_t *steps);
+
+        // current velocity of an axis in steps/tick, Q16.48
+        int64_t getVelocity(uint8_t axis) const;
+
+    private:
+        enum Phase { Idle, Accelerating, Cruising, Decelerating };
+
+        void nextPhase(int32_t *steps);
+
+        Phase phase = Idle;
+        uint8_t numberOfAxes = 0;
+        uint32_t ticksLeft = 0;
+        uint32_t accelTicks = 0;
+        uint32_t cruiseTicks = 0;
+
+        int64_t position[DEVICE_MAX_AXES];
+        int64_t velocity[DEVICE_MAX_AXES];
+        int64_t accel[DEVICE_MAX_AXES];
+        int32_t endSteps[DEVICE_MAX_AXES];
+};
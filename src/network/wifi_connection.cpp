@@ -0,0 +1,98 @@
+#include "./wifi_connection.h"
+
+#include "../metrics/trace.h"
+
+WifiConnection *WifiConnection::instance = nullptr;
+
+// Link events as instants on the WiFi track, attempts on the loop track;
+// a disconnect carries its reason.
+static const uint16_t GOT_IP_TRACE = traceName("wifi_got_ip");
+static const uint16_t DISCONNECTED_TRACE = traceName("wifi_disconnected");
+static const uint16_t CONNECT_TRACE = traceName("wifi_connect");
+
+WifiConnection::WifiConnection(const char *ssid, const char *pass)
+    : ssid(ssid), pass(pass), linkUp(false), disconnectEvents(0), lastReason(0),
+      state(LINK_DOWN), attempts(0), connects(0), disconnects(0), connectMillis(0), readyMillis(0) {
+}
+
+void WifiConnection::begin() {
+    instance = this;
+    WiFi.mode(WIFI_STA);
+    // retries are paced here, not by the core
+    WiFi.setAutoReconnect(false);
+    WiFi.onEvent(&WifiConnection::onEvent, SYSTEM_EVENT_STA_GOT_IP);
+    WiFi.onEvent(&WifiConnection::onEvent, SYSTEM_EVENT_STA_DISCONNECTED);
+    Serial.printf("WiFi: connecting to %s [%s]\n", ssid, WiFi.macAddress().c_str());
+    connect(millis());
+}
+
+void WifiConnection::onEvent(system_event_id_t event, system_event_info_t info) {
+    WifiConnection *self = instance;
+    if (!self) return;
+    if (event == SYSTEM_EVENT_STA_GOT_IP) {
+        trace(GOT_IP_TRACE, TRACE_INSTANT, TRACK_WIFI);
+        self->linkUp.store(true);
+    } else if (event == SYSTEM_EVENT_STA_DISCONNECTED) {
+        trace(DISCONNECTED_TRACE, TRACE_INSTANT, TRACK_WIFI, info.disconnected.reason);
+        self->linkUp.store(false);
+        self->lastReason.store(info.disconnected.reason);
+        self->disconnectEvents.fetch_add(1);
+    }
+}
+
+void WifiConnection::connect(uint32_t nowMillis) {
+    attemptStart = nowMillis;
+    seenDisconnects = disconnectEvents.load();
+    trace(CONNECT_TRACE, TRACE_INSTANT, TRACK_LOOP, attempts.fetch_add(1) + 1);
+    state.store(LINK_CONNECTING);
+    WiFi.begin(ssid, pass);
+}
+
+void WifiConnection::retryLater(uint32_t nowMillis) {
+    retryAt = nowMillis + backoff;
+    Serial.printf("WiFi: down (reason %u), retrying in %u ms\n", lastReason.load(), (unsigned)backoff);
+    backoff = backoff * 2 < WIFI_BACKOFF_MAX_MS ? backoff * 2 : WIFI_BACKOFF_MAX_MS;
+    state.store(LINK_BACKOFF);
+}
+
+void WifiConnection::service(uint32_t nowMillis) {
+    const bool dropped = disconnectEvents.load() != seenDisconnects;
+    switch (state.load()) {
+        case LINK_CONNECTING:
+            if (linkUp.load() && !dropped) {
+                connectMillis.store(nowMillis - attemptStart);
+                if (readyMillis.load() == 0) readyMillis.store(nowMillis ? nowMillis : 1);
+                connects.fetch_add(1);
+                backoff = WIFI_BACKOFF_MIN_MS;
+                state.store(LINK_UP);
+                Serial.printf("WiFi: %s in %u ms\n", WiFi.localIP().toString().c_str(), (unsigned)(nowMillis - attemptStart));
+            } else if (dropped || nowMillis - attemptStart > WIFI_CONNECT_TIMEOUT_MS) {
+                WiFi.disconnect();
+                retryLater(nowMillis);
+            }
+            break;
+        case LINK_UP:
+            if (dropped) {
+                disconnects.fetch_add(1);
+                retryLater(nowMillis);
+            }
+            break;
+        case LINK_BACKOFF:
+            if ((int32_t)(nowMillis - retryAt) >= 0) connect(nowMillis);
+            break;
+        default:
+            break;
+    }
+}
+
+LinkState WifiConnection::getState() const {return (LinkState)state.load();}
+
+void WifiConnection::getStats(LinkStats &stats) const {
+    stats.state = getState();
+    stats.attempts = attempts.load();
+    stats.connects = connects.load();
+    stats.disconnects = disconnects.load();
+    stats.connectMillis = connectMillis.load();
+    stats.readyMillis = readyMillis.load();
+    stats.lastReason = lastReason.load();
+}
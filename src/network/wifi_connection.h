@@ -0,0 +1,89 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#include <atomic>
+
+// An attempt that has not got an address by then is given up on.
+#ifndef WIFI_CONNECT_TIMEOUT_MS
+#define WIFI_CONNECT_TIMEOUT_MS 10000
+#endif
+
+// Wait before retrying after a failed attempt or a lost link, doubled after
+// every failure up to the maximum.
+#ifndef WIFI_BACKOFF_MIN_MS
+#define WIFI_BACKOFF_MIN_MS 500
+#endif
+#ifndef WIFI_BACKOFF_MAX_MS
+#define WIFI_BACKOFF_MAX_MS 30000
+#endif
+
+enum LinkState {
+    LINK_DOWN,
+    LINK_CONNECTING,
+    LINK_UP,
+    // waiting to retry
+    LINK_BACKOFF,
+};
+
+struct LinkStats {
+    LinkState state;
+    uint32_t attempts;
+    uint32_t connects;
+    uint32_t disconnects;
+    // from WiFi.begin() to an address, of the last successful attempt
+    uint32_t connectMillis;
+    // from boot to the first address, 0 until then
+    uint32_t readyMillis;
+    // reason given by the last disconnect event, a wifi_err_reason_t
+    uint8_t lastReason;
+};
+
+// Brings the station link up without blocking and keeps it up. WiFi events
+// only record what happened; service(), from loop(), acts on it: it starts
+// attempts, gives up on those that hang, and retries with exponential
+// backoff, so setup() returns at once and a lost access point never stalls
+// the control loop. The web server keeps listening throughout and serves
+// again as soon as the link is back.
+class WifiConnection {
+    public:
+        WifiConnection(const char *ssid, const char *pass);
+
+        // registers for the events and starts the first attempt
+        void begin();
+        void service(uint32_t nowMillis);
+
+        LinkState getState() const;
+        // from any task
+        void getStats(LinkStats &stats) const;
+
+    private:
+        static void onEvent(system_event_id_t event, system_event_info_t info);
+        void connect(uint32_t nowMillis);
+        void retryLater(uint32_t nowMillis);
+
+        static WifiConnection *instance;
+
+        const char *ssid;
+        const char *pass;
+
+        // written by the event task
+        std::atomic<bool> linkUp;
+        std::atomic<uint32_t> disconnectEvents;
+        std::atomic<uint8_t> lastReason;
+
+        // loop() side
+        uint32_t seenDisconnects = 0;
+        uint32_t attemptStart = 0;
+        uint32_t retryAt = 0;
+        uint32_t backoff = WIFI_BACKOFF_MIN_MS;
+
+        // published for getStats()
+        std::atomic<uint8_t> state;
+        std::atomic<uint32_t> attempts;
+        std::atomic<uint32_t> connects;
+        std::atomic<uint32_t> disconnects;
+        std::atomic<uint32_t> connectMillis;
+        std::atomic<uint32_t> readyMillis;
+};
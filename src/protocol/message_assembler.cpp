@@ -0,0 +1,75 @@
+#include "./message_assembler.h"
+
+MessageAssembler::MessageAssembler() {
+    for (uint8_t i = 0; i < ASSEMBLER_SLOTS; i++) {
+        slots[i].clientId = 0;
+        slots[i].len = 0;
+    }
+}
+
+MessageAssembler::Slot *MessageAssembler::find(uint32_t clientId) {
+    for (uint8_t i = 0; i < ASSEMBLER_SLOTS; i++) {
+        if (slots[i].clientId == clientId) return &slots[i];
+    }
+    return nullptr;
+}
+
+MessageAssembler::Slot *MessageAssembler::acquire(uint32_t clientId) {
+    Slot *slot = find(clientId);
+    if (!slot) slot = find(0);
+    if (!slot) return nullptr;
+    slot->clientId = clientId;
+    slot->len = 0;
+    return slot;
+}
+
+void MessageAssembler::release(uint32_t clientId) {
+    Slot *slot = find(clientId);
+    if (slot) slot->clientId = 0;
+}
+
+uint8_t MessageAssembler::used() const {
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < ASSEMBLER_SLOTS; i++) {
+        if (slots[i].clientId) count++;
+    }
+    return count;
+}
+
+AssemblerResult MessageAssembler::feed(uint32_t clientId, const AwsFrameInfo &info, uint8_t *data, size_t len, AssembledMessage &message) {
+    // info.message_opcode and info.num are only set when the library splits
+    // a frame over several events, so the message is tracked from info.opcode:
+    // every message starts with a text or binary frame, then continues with
+    // WS_CONTINUATION frames
+    const bool messageStart = info.index == 0 && info.opcode != WS_CONTINUATION;
+    const bool messageEnd = info.final && info.index + len == info.len;
+
+    // the common case: a whole message in a single event
+    if (messageStart && messageEnd) {
+        release(clientId);
+        if (info.len > ASSEMBLER_MAX_MESSAGE) return ASSEMBLER_TOO_BIG;
+        message.opcode = info.opcode;
+        message.data = data;
+        message.len = len;
+        return ASSEMBLER_COMPLETE;
+    }
+
+    Slot *slot = messageStart ? acquire(clientId) : find(clientId);
+    if (!slot) return messageStart ? ASSEMBLER_NO_BUFFER : ASSEMBLER_DISCARDED;
+    if (messageStart) slot->opcode = info.opcode;
+
+    // frame lengths are known up front, so an oversized frame fails early
+    if ((info.index == 0 && slot->len + info.len > ASSEMBLER_MAX_MESSAGE) || slot->len + len > ASSEMBLER_MAX_MESSAGE) {
+        slot->clientId = 0;
+        return ASSEMBLER_TOO_BIG;
+    }
+    memcpy(slot->data + slot->len, data, len);
+    slot->len += len;
+    if (!messageEnd) return ASSEMBLER_PENDING;
+
+    slot->clientId = 0;
+    message.opcode = slot->opcode;
+    message.data = slot->data;
+    message.len = slot->len;
+    return ASSEMBLER_COMPLETE;
+}
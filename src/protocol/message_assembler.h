@@ -0,0 +1,67 @@
+#pragma once
+
+#include <ESPAsyncWebServer.h>
+
+// Messages being reassembled at once, across all clients, and the largest
+// message accepted. The buffers are static, so the pool costs
+// ASSEMBLER_SLOTS * ASSEMBLER_MAX_MESSAGE bytes of RAM and never touches the
+// heap however clients fragment their messages.
+#ifndef ASSEMBLER_SLOTS
+#define ASSEMBLER_SLOTS 4
+#endif
+#ifndef ASSEMBLER_MAX_MESSAGE
+#define ASSEMBLER_MAX_MESSAGE 4096
+#endif
+
+enum AssemblerResult {
+    // more data is needed; nothing to dispatch yet
+    ASSEMBLER_PENDING,
+    ASSEMBLER_COMPLETE,
+    // the message exceeds ASSEMBLER_MAX_MESSAGE and was dropped
+    ASSEMBLER_TOO_BIG,
+    // every buffer is in use; the message was dropped
+    ASSEMBLER_NO_BUFFER,
+    // the rest of a message that was already dropped
+    ASSEMBLER_DISCARDED,
+};
+
+struct AssembledMessage {
+    // WS_TEXT or WS_BINARY
+    uint8_t opcode;
+    uint8_t *data;
+    size_t len;
+};
+
+// Turns the WS_EVT_DATA events of AsyncWebSocket, which deliver frames in
+// pieces and messages as several frames, back into whole messages. A message
+// that arrives in one piece is passed through without a copy; any other is
+// accumulated in a buffer borrowed from the pool for the time it takes.
+//
+// Runs on the async server task only, like the events it is fed.
+class MessageAssembler {
+    public:
+        MessageAssembler();
+
+        // on ASSEMBLER_COMPLETE, message points at the whole payload, valid
+        // until the next call
+        AssemblerResult feed(uint32_t clientId, const AwsFrameInfo &info, uint8_t *data, size_t len, AssembledMessage &message);
+
+        // drops a partial message of a client that went away
+        void release(uint32_t clientId);
+
+        // buffers currently holding a partial message
+        uint8_t used() const;
+
+    private:
+        struct Slot {
+            uint32_t clientId;
+            uint8_t opcode;
+            size_t len;
+            uint8_t data[ASSEMBLER_MAX_MESSAGE];
+        };
+
+        Slot *find(uint32_t clientId);
+        Slot *acquire(uint32_t clientId);
+
+        Slot slots[ASSEMBLER_SLOTS];
+};
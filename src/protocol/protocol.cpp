@@ -0,0 +1,129 @@
+#include "./protocol.h"
+
+#include <string.h>
+
+// Explicit byte order, so the wire format does not depend on the host.
+static void putU16(uint8_t *out, uint16_t value) {
+    out[0] = value;
+    out[1] = value >> 8;
+}
+
+static void putU32(uint8_t *out, uint32_t value) {
+    out[0] = value;
+    out[1] = value >> 8;
+    out[2] = value >> 16;
+    out[3] = value >> 24;
+}
+
+static void putF32(uint8_t *out, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    putU32(out, bits);
+}
+
+static uint16_t getU16(const uint8_t *in) {
+    return in[0] | (uint16_t)in[1] << 8;
+}
+
+static uint32_t getU32(const uint8_t *in) {
+    return in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+static float getF32(const uint8_t *in) {
+    uint32_t bits = getU32(in);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void putHeader(uint8_t *out, uint8_t type, uint8_t numberOfAxes, uint8_t flags, uint32_t seq) {
+    out[0] = PROTOCOL_VERSION;
+    out[1] = type;
+    out[2] = numberOfAxes;
+    out[3] = flags;
+    putU32(out + 4, seq);
+}
+
+AckStatus decodeCommand(const uint8_t *data, size_t len, Command &command) {
+    memset(&command, 0, sizeof(command));
+    if (len < PROTOCOL_HEADER_SIZE) return ACK_BAD_LENGTH;
+
+    FrameHeader &header = command.header;
+    header.version = data[0];
+    header.type = data[1];
+    header.numberOfAxes = data[2];
+    header.flags = data[3];
+    header.seq = getU32(data + 4);
+    if (header.version != PROTOCOL_VERSION) return ACK_BAD_VERSION;
+
+    const uint8_t *payload = data + PROTOCOL_HEADER_SIZE;
+    const size_t payloadLen = len - PROTOCOL_HEADER_SIZE;
+    const uint8_t n = header.numberOfAxes;
+
+    switch (header.type) {
+        case MSG_SET_POSITION:
+            if (n > DEVICE_MAX_AXES || payloadLen != 4 * (size_t)n + 4) return ACK_BAD_LENGTH;
+            for (uint8_t i = 0; i < n; i++) command.positions[i] = getF32(payload + 4 * i);
+            command.feedrate = getF32(payload + 4 * n);
+            return ACK_OK;
+        case MSG_SUBSCRIBE:
+            if (payloadLen != 2) return ACK_BAD_LENGTH;
+            command.rate = getU16(payload);
+            return ACK_OK;
+        case MSG_PROGRAM:
+            if (n > DEVICE_MAX_AXES || payloadLen < 4) return ACK_BAD_LENGTH;
+            command.waypointCount = getU16(payload);
+            command.waypoints = payload + 4;
+            if (payloadLen != 4 + (size_t)command.waypointCount * (4 * n + 4)) return ACK_BAD_LENGTH;
+            return ACK_OK;
+        case MSG_HOME:
+        case MSG_TOGGLE:
+        case MSG_PAUSE:
+        case MSG_RESUME:
+        case MSG_ABORT:
+        case MSG_STATUS:
+            return payloadLen == 0 ? ACK_OK : ACK_BAD_LENGTH;
+        default:
+            return ACK_BAD_TYPE;
+    }
+}
+
+void getWaypoint(const Command &command, uint16_t index, float *positions, float &feedrate) {
+    const uint8_t n = command.header.numberOfAxes;
+    const uint8_t *waypoint = command.waypoints + (size_t)index * (4 * n + 4);
+    for (uint8_t i = 0; i < n; i++) positions[i] = getF32(waypoint + 4 * i);
+    feedrate = getF32(waypoint + 4 * n);
+}
+
+size_t encodeAck(uint32_t seq, AckStatus status, uint8_t *out, size_t size) {
+    if (size < PROTOCOL_HEADER_SIZE) return 0;
+    putHeader(out, MSG_ACK, 0, status, seq);
+    return PROTOCOL_HEADER_SIZE;
+}
+
+size_t encodeTelemetry(const TelemetrySample &sample, uint8_t *out, size_t size) {
+    const uint8_t n = sample.numberOfAxes;
+    const size_t len = PROTOCOL_HEADER_SIZE + 8 + 8 * (size_t)n;
+    if (size < len) return 0;
+
+    putHeader(out, MSG_TELEMETRY, n, sample.moving ? TELEMETRY_FLAG_MOVING : 0, sample.seq);
+    uint8_t *payload = out + PROTOCOL_HEADER_SIZE;
+    putU32(payload, sample.time);
+    putU32(payload + 4, sample.homedMask);
+    for (uint8_t i = 0; i < n; i++) {
+        putF32(payload + 8 + 4 * i, sample.positions[i]);
+        putF32(payload + 8 + 4 * (n + i), sample.velocities[i]);
+    }
+    return len;
+}
+
+size_t encodeProgramStatus(uint32_t seq, uint8_t state, uint16_t pending, uint16_t capacity, uint32_t started, uint8_t *out, size_t size) {
+    const size_t len = PROTOCOL_HEADER_SIZE + 8;
+    if (size < len) return 0;
+
+    putHeader(out, MSG_PROGRAM_STATUS, 0, state, seq);
+    putU16(out + PROTOCOL_HEADER_SIZE, pending);
+    putU16(out + PROTOCOL_HEADER_SIZE + 2, capacity);
+    putU32(out + PROTOCOL_HEADER_SIZE + 4, started);
+    return len;
+}
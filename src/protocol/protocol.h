@@ -0,0 +1,122 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../device/device.h"
+
+// ----------------------------------------------------------------------------
+// Binary WebSocket protocol
+// ----------------------------------------------------------------------------
+//
+// Sent as WS_BINARY messages, next to the JSON text protocol. Every frame
+// starts with the same 8 byte header; all fields are little-endian and floats
+// are IEEE 754 single precision.
+//
+//   offset size
+//   0      1    version       PROTOCOL_VERSION
+//   1      1    type          MessageType
+//   2      1    numberOfAxes  axes in the per-axis arrays that follow
+//   3      1    flags         meaning depends on the type
+//   4      4    seq           chosen by the sender, echoed by an Ack
+//
+// Commands (client -> device):
+//   SetPosition  flags: axis mask        float position[n], float feedrate
+//                                        (feedrate <= 0 keeps the current one)
+//   Home         -
+//   Subscribe    flags: axis mask        uint16 rate in Hz (0 unsubscribes);
+//                (0: all axes)           telemetry then carries only the
+//                                        masked axes, see below
+//   Toggle       -
+//   Program      flags: axis mask        uint16 count, uint16 0, then count x
+//                                        (float position[n], float feedrate)
+//   Pause, Resume, Abort                 -
+//   Status       -                       answered with a ProgramStatus
+//
+// Replies and telemetry (device -> client):
+//   Ack          flags: AckStatus        -
+//   Telemetry    flags: bit 0 moving     uint32 time (ms), uint32 homed mask,
+//                seq: sample number      float position[n], float velocity[n]
+//                                        for the subscribed axes in ascending
+//                                        order; homed mask bit i is the i-th
+//                                        of them
+//   ProgramStatus flags: MotionState     uint16 pending, uint16 capacity,
+//                seq: echoed             uint32 started
+//
+// Frames of an unknown version are answered with an Ack BadVersion, so a
+// client can detect a firmware that speaks a different revision.
+// ----------------------------------------------------------------------------
+
+#define PROTOCOL_VERSION     1
+#define PROTOCOL_HEADER_SIZE 8
+
+// largest frame either side sends: a telemetry frame for every axis
+#define PROTOCOL_MAX_FRAME_SIZE (PROTOCOL_HEADER_SIZE + 8 + 8 * DEVICE_MAX_AXES)
+
+enum MessageType {
+    MSG_SET_POSITION = 0x01,
+    MSG_HOME         = 0x02,
+    MSG_SUBSCRIBE    = 0x03,
+    MSG_TOGGLE       = 0x04,
+    MSG_PROGRAM      = 0x05,
+    MSG_PAUSE        = 0x06,
+    MSG_RESUME       = 0x07,
+    MSG_ABORT        = 0x08,
+    MSG_STATUS       = 0x09,
+
+    MSG_ACK            = 0x80,
+    MSG_TELEMETRY      = 0x81,
+    MSG_PROGRAM_STATUS = 0x82,
+};
+
+enum AckStatus {
+    ACK_OK          = 0,
+    ACK_BAD_VERSION = 1,
+    ACK_BAD_TYPE    = 2,
+    ACK_BAD_LENGTH  = 3,
+    ACK_REJECTED    = 4,
+    // the program queue has no room for the whole batch
+    ACK_FULL        = 5,
+};
+
+#define TELEMETRY_FLAG_MOVING 0x01
+
+struct FrameHeader {
+    uint8_t  version;
+    uint8_t  type;
+    uint8_t  numberOfAxes;
+    uint8_t  flags;
+    uint32_t seq;
+};
+
+// A decoded command; only the fields of its type are set.
+struct Command {
+    FrameHeader header;
+    float    positions[DEVICE_MAX_AXES];
+    float    feedrate;
+    uint16_t rate;
+    // MSG_PROGRAM: read the waypoints with getWaypoint()
+    uint16_t waypointCount;
+    const uint8_t *waypoints;
+};
+
+// One telemetry sample, shared by the binary and the JSON encodings.
+struct TelemetrySample {
+    uint32_t seq;
+    uint32_t time;
+    uint8_t  numberOfAxes;
+    bool     moving;
+    uint32_t homedMask;
+    float    positions[DEVICE_MAX_AXES];
+    float    velocities[DEVICE_MAX_AXES];
+};
+
+// Parses a complete binary message. Returns ACK_OK, or the status to reply
+// with when the frame cannot be used.
+AckStatus decodeCommand(const uint8_t *data, size_t len, Command &command);
+void getWaypoint(const Command &command, uint16_t index, float *positions, float &feedrate);
+
+// Each returns the frame length, or 0 when size is too small.
+size_t encodeAck(uint32_t seq, AckStatus status, uint8_t *out, size_t size);
+size_t encodeTelemetry(const TelemetrySample &sample, uint8_t *out, size_t size);
+size_t encodeProgramStatus(uint32_t seq, uint8_t state, uint16_t pending, uint16_t capacity, uint32_t started, uint8_t *out, size_t size);
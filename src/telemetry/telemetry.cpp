@@ -0,0 +1,201 @@
+#include "./telemetry.h"
+
+#include <ArduinoJson.h>
+#include <string.h>
+
+#include "../web/json_response.h"
+
+
+Telemetry::Telemetry(AsyncWebSocket &ws, Device &device, Motion &motion, JsonArena &arena)
+    : ws(ws), device(device), motion(motion), arena(arena) {
+    for (uint8_t i = 0; i < DEFAULT_MAX_WS_CLIENTS; i++) {
+        clientIds[i].store(0);
+        periods[i].store(0);
+        formats[i].store(TELEMETRY_JSON);
+        axisMasks[i].store(0);
+        servedIds[i] = 0;
+        lastSent[i] = 0;
+    }
+}
+
+bool Telemetry::subscribe(uint32_t clientId, uint32_t rate, TelemetryFormat format, uint8_t axisMask) {
+    if (rate == 0) {
+        unsubscribe(clientId);
+        return true;
+    }
+    if (rate > TELEMETRY_MAX_RATE) rate = TELEMETRY_MAX_RATE;
+    const uint16_t period = 1000 / rate;
+
+    for (uint8_t i = 0; i < DEFAULT_MAX_WS_CLIENTS; i++) {
+        if (clientIds[i].load() == clientId) {
+            periods[i].store(period);
+            formats[i].store(format);
+            axisMasks[i].store(axisMask);
+            return true;
+        }
+    }
+    for (uint8_t i = 0; i < DEFAULT_MAX_WS_CLIENTS; i++) {
+        uint32_t free = 0;
+        if (clientIds[i].compare_exchange_strong(free, clientId)) {
+            periods[i].store(period);
+            formats[i].store(format);
+            axisMasks[i].store(axisMask);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Telemetry::unsubscribe(uint32_t clientId) {
+    for (uint8_t i = 0; i < DEFAULT_MAX_WS_CLIENTS; i++) {
+        uint32_t expected = clientId;
+        clientIds[i].compare_exchange_strong(expected, 0);
+    }
+}
+
+bool Telemetry::service(uint32_t nowMillis) {
+    uint32_t due = 0;
+    for (uint8_t i = 0; i < DEFAULT_MAX_WS_CLIENTS; i++) {
+        const uint32_t clientId = clientIds[i].load();
+        if (clientId == 0) continue;
+        // a new subscriber gets its first sample right away
+        if (servedIds[i] != clientId) {
+            servedIds[i] = clientId;
+            lastSent[i] = nowMillis - periods[i].load();
+        }
+        if (nowMillis - lastSent[i] >= periods[i].load()) due |= (uint32_t)1 << i;
+    }
+    // with the server task behind, the slots stay due for a later pass
+    if (due == 0 || posts.isFull()) return false;
+
+    Post post;
+    sample(post.sample, nowMillis);
+    post.due = due;
+    posts.push(post);
+    for (uint8_t i = 0; i < DEFAULT_MAX_WS_CLIENTS; i++) {
+        if (due & ((uint32_t)1 << i)) lastSent[i] = nowMillis;
+    }
+    return true;
+}
+
+void Telemetry::send() {
+    // only the newest sample is sent, to every slot due in any of them
+    Post post, newer;
+    if (!posts.pop(post)) return;
+    while (posts.pop(newer)) {
+        newer.due |= post.due;
+        post = newer;
+    }
+    const TelemetrySample &last = post.sample;
+
+    // one buffer per format and axis mask, serialized at most once per pass
+    struct Group {
+        uint8_t format;
+        uint8_t axisMask;
+        AsyncWebSocketMessageBuffer *buffer;
+    };
+    Group groups[DEFAULT_MAX_WS_CLIENTS];
+    uint8_t groupCount = 0;
+
+    for (uint8_t i = 0; i < DEFAULT_MAX_WS_CLIENTS; i++) {
+        if (!(post.due & ((uint32_t)1 << i))) continue;
+        const uint32_t clientId = clientIds[i].load();
+        if (clientId == 0) continue;
+        AsyncWebSocketClient *client = ws.client(clientId);
+        if (!client) {
+            unsubscribe(clientId);
+            continue;
+        }
+        // still sending an earlier frame: skip this sample, not queue it
+        if (client->queueLen() > 0) continue;
+
+        // axes that are not configured (any more) are dropped, none left means all
+        const uint8_t allAxes = (1 << last.numberOfAxes) - 1;
+        uint8_t axisMask = axisMasks[i].load() & allAxes;
+        if (axisMask == 0) axisMask = allAxes;
+        const uint8_t format = formats[i].load();
+
+        uint8_t g = 0;
+        while (g < groupCount && (groups[g].format != format || groups[g].axisMask != axisMask)) g++;
+        if (g == groupCount) {
+            groups[g].format = format;
+            groups[g].axisMask = axisMask;
+            groups[g].buffer = encode(last, (TelemetryFormat)format, axisMask);
+            // a broadcast reclaims unreferenced buffers: keep this one until
+            // the pass has queued it everywhere
+            if (groups[g].buffer) groups[g].buffer->lock();
+            groupCount++;
+        }
+        if (!groups[g].buffer) continue;
+
+        if (format == TELEMETRY_BINARY) {
+            client->binary(groups[g].buffer);
+        } else {
+            client->text(groups[g].buffer);
+        }
+    }
+
+    // the queued messages hold them now; the server frees them once sent
+    for (uint8_t g = 0; g < groupCount; g++) {
+        if (groups[g].buffer) groups[g].buffer->unlock();
+    }
+}
+
+void Telemetry::sample(TelemetrySample &out, uint32_t nowMillis) {
+    DeviceSnapshot state;
+    device.getSnapshot(state);
+    memset(&out, 0, sizeof(out));
+    out.seq = ++seq;
+    out.time = nowMillis;
+    out.numberOfAxes = state.numberOfAxes;
+    out.moving = motion.isMoving();
+    out.homedMask = state.homedMask;
+    memcpy(out.positions, state.positions, sizeof(out.positions));
+    for (uint8_t i = 0; i < state.numberOfAxes; i++) {
+        out.velocities[i] = motion.getVelocity(i);
+    }
+}
+
+AsyncWebSocketMessageBuffer *Telemetry::encode(const TelemetrySample &last, TelemetryFormat format, uint8_t axisMask) {
+    if (format != TELEMETRY_BINARY) return toJson(last, axisMask);
+
+    // the selected axes, renumbered from 0
+    TelemetrySample selected = last;
+    selected.numberOfAxes = 0;
+    selected.homedMask = 0;
+    for (uint8_t i = 0; i < last.numberOfAxes; i++) {
+        if (!(axisMask & (1 << i))) continue;
+        const uint8_t n = selected.numberOfAxes++;
+        selected.positions[n] = last.positions[i];
+        selected.velocities[n] = last.velocities[i];
+        selected.homedMask |= (last.homedMask >> i & 1) << n;
+    }
+
+    uint8_t frame[PROTOCOL_MAX_FRAME_SIZE];
+    const size_t len = encodeTelemetry(selected, frame, sizeof(frame));
+    if (len == 0) return nullptr;
+    AsyncWebSocketMessageBuffer *buffer = ws.makeBuffer(frame, len);
+    // an unused buffer is reclaimed by the server along with sent ones
+    if (!buffer || !buffer->get()) return nullptr;
+    return buffer;
+}
+
+AsyncWebSocketMessageBuffer *Telemetry::toJson(const TelemetrySample &last, uint8_t axisMask) {
+    JsonDocument json(&arena);
+    json["type"] = "telemetry";
+    json["seq"] = last.seq;
+    json["time"] = last.time;
+    json["moving"] = last.moving;
+    JsonArray axes = json["axes"].to<JsonArray>();
+    JsonArray position = json["position"].to<JsonArray>();
+    JsonArray velocity = json["velocity"].to<JsonArray>();
+    JsonArray homed = json["homed"].to<JsonArray>();
+    for (uint8_t i = 0; i < last.numberOfAxes; i++) {
+        if (!(axisMask & (1 << i))) continue;
+        axes.add(i + 1);
+        position.add(last.positions[i]);
+        velocity.add(last.velocities[i]);
+        homed.add((last.homedMask >> i & 1) != 0);
+    }
+    return makeJsonBuffer(ws, json);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <ESPAsyncWebServer.h>
+
+#include <atomic>
+
+#include "../device/device.h"
+#include "../json/json_arena.h"
+#include "../motion/motion.h"
+#include "../motion/spsc_queue.h"
+#include "../protocol/protocol.h"
+
+// Rate given to a subscription that does not ask for one, and the fastest
+// one granted, in samples per second.
+#define TELEMETRY_DEFAULT_RATE 10
+#define TELEMETRY_MAX_RATE     50
+
+// Samples handed from loop() to the server task and not sent yet.
+#define TELEMETRY_QUEUE_LENGTH 4
+
+enum TelemetryFormat {
+    TELEMETRY_JSON,
+    // MSG_TELEMETRY frames of the binary protocol
+    TELEMETRY_BINARY,
+};
+
+// Pushes position, velocity and homing state to the WebSocket clients that
+// subscribed, each at its own rate. Updates are coalesced: a client still
+// draining its previous sample is skipped, so a slow link sees the latest
+// state at a lower rate instead of a growing backlog.
+//
+// A subscription may name the axes it wants with a mask, bit i for axis
+// i + 1; 0 asks for all of them. Frames then list only those axes, in
+// ascending order.
+//
+// JSON frames look like
+//   {"type":"telemetry","seq":42,"time":12345,"moving":true,"axes":[1,2,3],
+//    "position":[...],"velocity":[...],"homed":[...]}
+// where axes are numbered from 1, as in the rest of the API, and seq counts
+// samples taken, so gaps show how many were skipped. Binary subscribers get
+// the same sample as a MSG_TELEMETRY frame (see protocol.h).
+//
+// loop() only decides which subscriptions are due and takes the sample;
+// the WebSocket clients are only touched on the server task, which send()
+// runs on. There each sample is serialized once per format and axis mask
+// into a shared AsyncWebSocketMessageBuffer, queued to every client of that
+// group without a copy.
+class Telemetry {
+    public:
+        // JSON frames are built in arena, which must belong to the server task
+        Telemetry(AsyncWebSocket &ws, Device &device, Motion &motion, JsonArena &arena);
+
+        // from any task; rate in Hz, 0 unsubscribes, above TELEMETRY_MAX_RATE
+        // is capped to it
+        bool subscribe(uint32_t clientId, uint32_t rate = TELEMETRY_DEFAULT_RATE, TelemetryFormat format = TELEMETRY_JSON,
+                       uint8_t axisMask = 0);
+        void unsubscribe(uint32_t clientId);
+
+        // Takes a sample for the subscriptions that fell due, from loop()
+        // only. Returns true when one was queued for send(), which the
+        // server task must then be made to run.
+        bool service(uint32_t nowMillis);
+        // sends the queued samples, from the server task only
+        void send();
+
+    private:
+        // a sample and the slots it is due to
+        struct Post {
+            TelemetrySample sample;
+            uint32_t due;
+        };
+        static_assert(DEFAULT_MAX_WS_CLIENTS <= 32, "Telemetry due masks hold 32 slots");
+
+        void sample(TelemetrySample &out, uint32_t nowMillis);
+        AsyncWebSocketMessageBuffer *encode(const TelemetrySample &sample, TelemetryFormat format, uint8_t axisMask);
+        AsyncWebSocketMessageBuffer *toJson(const TelemetrySample &sample, uint8_t axisMask);
+
+        AsyncWebSocket &ws;
+        Device &device;
+        Motion &motion;
+        JsonArena &arena;
+
+        // slots written by subscribe() on the server task: clientId 0 is free
+        std::atomic<uint32_t> clientIds[DEFAULT_MAX_WS_CLIENTS];
+        std::atomic<uint16_t> periods[DEFAULT_MAX_WS_CLIENTS];
+        std::atomic<uint8_t>  formats[DEFAULT_MAX_WS_CLIENTS];
+        std::atomic<uint8_t>  axisMasks[DEFAULT_MAX_WS_CLIENTS];
+
+        // loop() side bookkeeping of the same slots
+        uint32_t servedIds[DEFAULT_MAX_WS_CLIENTS];
+        uint32_t lastSent[DEFAULT_MAX_WS_CLIENTS];
+        uint32_t seq = 0;
+
+        SpscQueue<Post, TELEMETRY_QUEUE_LENGTH> posts;
+};
@@ -0,0 +1,122 @@
+#include "./asset_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+CachedAsset::CachedAsset(size_t len) : len(len) {
+#ifdef BOARD_HAS_PSRAM
+    data = (uint8_t *)ps_malloc(len);
+#else
+    data = (uint8_t *)malloc(len);
+#endif
+    etag[0] = '\0';
+}
+
+CachedAsset::~CachedAsset() {
+    free(data);
+}
+
+AssetRef loadAsset(fs::FS &fs, const char *path, size_t maxLen) {
+    String name = path;
+    bool gzipped = false;
+    if (!fs.exists(name)) {
+        name += ".gz";
+        gzipped = true;
+        if (!fs.exists(name)) return AssetRef();
+    }
+
+    File file = fs.open(name, "r");
+    if (!file || file.size() > maxLen) return AssetRef();
+    AssetRef asset = std::make_shared<CachedAsset>(file.size());
+    if (!asset->data || file.read(asset->data, asset->len) != asset->len) return AssetRef();
+    file.close();
+
+    asset->gzipped = gzipped;
+    formatETag(asset->etag, etagHash(asset->data, asset->len));
+    return asset;
+}
+
+void sendAsset(AsyncWebServerRequest *request, const AssetRef &asset, const char *contentType, const char *cacheControl) {
+    AsyncWebHeader *match = request->getHeader("If-None-Match");
+    AsyncWebServerResponse *response;
+    if (match && match->value() == asset->etag) {
+        response = request->beginResponse(304);
+    } else {
+        // the response holds its own reference until the last byte is out
+        AssetRef body = asset;
+        response = request->beginResponse(contentType, body->len, [body](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+            size_t len = body->len - index;
+            if (len > maxLen) len = maxLen;
+            memcpy(buffer, body->data + index, len);
+            return len;
+        });
+        if (asset->gzipped) response->addHeader("Content-Encoding", "gzip");
+    }
+    response->addHeader("ETag", asset->etag);
+    response->addHeader("Cache-Control", cacheControl);
+    request->send(response);
+}
+
+AssetCache::AssetCache(size_t budget) : budget(budget) {
+    for (uint8_t i = 0; i < ASSET_CACHE_ENTRIES; i++) {
+        entries[i].key[0] = '\0';
+        entries[i].lastUsed = 0;
+    }
+}
+
+AssetRef AssetCache::get(const char *key) {
+    for (uint8_t i = 0; i < ASSET_CACHE_ENTRIES; i++) {
+        Entry &entry = entries[i];
+        if (!entry.asset || strcmp(entry.key, key) != 0) continue;
+        entry.lastUsed = ++clock;
+        hits++;
+        return entry.asset;
+    }
+    misses++;
+    return AssetRef();
+}
+
+void AssetCache::put(const char *key, const AssetRef &asset) {
+    if (!asset || asset->len > budget || strlen(key) >= ASSET_CACHE_KEY_SIZE) return;
+
+    Entry *slot = nullptr;
+    for (uint8_t i = 0; i < ASSET_CACHE_ENTRIES; i++) {
+        if (entries[i].asset && strcmp(entries[i].key, key) == 0) evict(entries[i]);
+    }
+    while (true) {
+        Entry *oldest = nullptr;
+        slot = nullptr;
+        for (uint8_t i = 0; i < ASSET_CACHE_ENTRIES; i++) {
+            Entry &entry = entries[i];
+            if (!entry.asset) {
+                if (!slot) slot = &entry;
+            } else if (!oldest || entry.lastUsed < oldest->lastUsed) {
+                oldest = &entry;
+            }
+        }
+        if (slot && used + asset->len <= budget) break;
+        evict(*oldest);
+        evictions++;
+    }
+
+    strcpy(slot->key, key);
+    slot->asset = asset;
+    slot->lastUsed = ++clock;
+    used += asset->len;
+}
+
+void AssetCache::evict(Entry &entry) {
+    used -= entry.asset->len;
+    entry.asset.reset();
+    entry.key[0] = '\0';
+}
+
+size_t AssetCache::getUsed() const {return used;}
+
+size_t AssetCache::getBudget() const {return budget;}
+
+uint32_t AssetCache::getHits() const {return hits;}
+
+uint32_t AssetCache::getMisses() const {return misses;}
+
+uint32_t AssetCache::getEvictions() const {return evictions;}
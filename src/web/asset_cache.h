@@ -0,0 +1,83 @@
+#pragma once
+
+#include <ESPAsyncWebServer.h>
+#include <FS.h>
+
+#include <memory>
+
+#include "./etag.h"
+
+// Bytes of asset bodies the cache may hold, and the number of bodies. Bodies
+// go to PSRAM on boards that have it.
+#ifndef ASSET_CACHE_BUDGET
+#define ASSET_CACHE_BUDGET 16384
+#endif
+#ifndef ASSET_CACHE_ENTRIES
+#define ASSET_CACHE_ENTRIES 8
+#endif
+
+#define ASSET_CACHE_KEY_SIZE 32
+
+// A response body held in RAM, with its ETag. Shared between the cache and
+// the responses sending it, so evicting a body never pulls it from under a
+// response still in flight.
+struct CachedAsset {
+    explicit CachedAsset(size_t len);
+    ~CachedAsset();
+
+    uint8_t *data;
+    size_t len;
+    bool gzipped = false;
+    char etag[ETAG_SIZE];
+};
+
+typedef std::shared_ptr<CachedAsset> AssetRef;
+
+// Reads path, or path + ".gz" when only that exists; nullptr when neither
+// does or the body is larger than maxLen.
+AssetRef loadAsset(fs::FS &fs, const char *path, size_t maxLen = ASSET_CACHE_BUDGET);
+
+// Replies with asset, or with a bodiless 304 when the request carries its
+// ETag in If-None-Match. The body is copied straight from RAM into the
+// connection.
+void sendAsset(AsyncWebServerRequest *request, const AssetRef &asset, const char *contentType, const char *cacheControl);
+
+// Least recently used cache of asset bodies, keyed by name (a path, or a
+// path plus the variant of a rendered template), within a byte budget.
+// Keeps page loads off the flash, whose reads serialize with every other
+// SPIFFS user. Used from the server task only.
+//
+// Nothing writes SPIFFS while the firmware runs (uploadfs reflashes it and
+// reboots), so bodies are never invalidated: the cache lives until reboot.
+class AssetCache {
+    public:
+        explicit AssetCache(size_t budget = ASSET_CACHE_BUDGET);
+
+        AssetRef get(const char *key);
+        // evicts the least recently used bodies until asset fits; one larger
+        // than the whole budget is not kept
+        void put(const char *key, const AssetRef &asset);
+
+        size_t getUsed() const;
+        size_t getBudget() const;
+        uint32_t getHits() const;
+        uint32_t getMisses() const;
+        uint32_t getEvictions() const;
+
+    private:
+        struct Entry {
+            char key[ASSET_CACHE_KEY_SIZE];
+            AssetRef asset;
+            uint32_t lastUsed;
+        };
+
+        void evict(Entry &entry);
+
+        const size_t budget;
+        size_t used = 0;
+        uint32_t clock = 0;
+        uint32_t hits = 0;
+        uint32_t misses = 0;
+        uint32_t evictions = 0;
+        Entry entries[ASSET_CACHE_ENTRIES];
+};
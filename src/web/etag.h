@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// FNV-1a: cheap, and any content change shows in the tag. Feed a body in
+// pieces by passing the previous result back in as h.
+#define ETAG_HASH_INIT 2166136261u
+
+inline uint32_t etagHash(const void *data, size_t len, uint32_t h = ETAG_HASH_INIT) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= bytes[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// a quoted tag, as sent in ETag and compared with If-None-Match
+#define ETAG_SIZE 11
+
+inline void formatETag(char *etag, uint32_t hash) {
+    snprintf(etag, ETAG_SIZE, "\"%08x\"", (unsigned)hash);
+}
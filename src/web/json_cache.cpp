@@ -0,0 +1,42 @@
+#include "./json_cache.h"
+
+JsonCache::JsonCache(const Device &device, JsonArena &arena, Builder builder)
+    : device(device), arena(arena), builder(builder) {
+    etag[0] = '\0';
+}
+
+bool JsonCache::rebuild(const DeviceSnapshot &state) {
+    JsonDocument json(&arena);
+    builder(json, state);
+    version = state.configVersion;
+
+    len = measureJson(json);
+    valid = !json.overflowed() && len < sizeof(body);
+    if (!valid) {
+        Serial.printf("JsonCache: %u byte body exceeds JSON_CACHE_SIZE or the arena\n", (unsigned)len);
+        return false;
+    }
+    serializeJson(json, body, sizeof(body));
+    formatETag(etag, etagHash(body, len));
+    return true;
+}
+
+void JsonCache::send(AsyncWebServerRequest *request) {
+    DeviceSnapshot state;
+    device.getSnapshot(state);
+    if ((!valid || version != state.configVersion) && !rebuild(state)) {
+        request->send(500);
+        return;
+    }
+
+    AsyncWebHeader *match = request->getHeader("If-None-Match");
+    AsyncWebServerResponse *response;
+    if (match && match->value() == etag) {
+        response = request->beginResponse(304);
+    } else {
+        response = request->beginResponse_P(200, "application/json", (const uint8_t *)body, len);
+    }
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
+}
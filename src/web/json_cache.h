@@ -0,0 +1,43 @@
+#pragma once
+
+#include <ESPAsyncWebServer.h>
+#include <ArduinoJson.h>
+
+#include "../device/device.h"
+#include "../json/json_arena.h"
+#include "./etag.h"
+
+// Room for one cached body. Kept below a TCP segment, so that the server
+// copies a body out in the first write of its response.
+#ifndef JSON_CACHE_SIZE
+#define JSON_CACHE_SIZE 384
+#endif
+
+// A JSON response whose content only depends on the Device configuration.
+// The body is built from a single DeviceSnapshot and serialized once into a
+// static buffer, with its length, an ETag and the snapshot's configVersion,
+// and served from there until a later snapshot's configVersion moves on;
+// a request carrying the current ETag in If-None-Match gets a bodiless 304.
+//
+// Rebuilding happens lazily in send(), on the server task that also copies
+// the body into the socket, so a response never sees the buffer change.
+class JsonCache {
+    public:
+        typedef void (*Builder)(JsonDocument &json, const DeviceSnapshot &state);
+
+        JsonCache(const Device &device, JsonArena &arena, Builder builder);
+
+        void send(AsyncWebServerRequest *request);
+
+    private:
+        bool rebuild(const DeviceSnapshot &state);
+
+        const Device &device;
+        JsonArena &arena;
+        const Builder builder;
+        uint32_t version = 0;
+        bool valid = false;
+        size_t len = 0;
+        char etag[ETAG_SIZE];
+        char body[JSON_CACHE_SIZE];
+};
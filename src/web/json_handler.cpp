@@ -0,0 +1,63 @@
+#include "./json_handler.h"
+
+JsonBodyHandler::Slot JsonBodyHandler::slots[JSON_BODY_SLOTS];
+
+JsonBodyHandler::JsonBodyHandler(const char *uri, JsonArena &arena, JsonRequestCallback onRequest)
+    : uri(uri), arena(arena), onRequest(onRequest) {
+}
+
+JsonBodyHandler::Slot *JsonBodyHandler::find(AsyncWebServerRequest *request) {
+    for (uint8_t i = 0; i < JSON_BODY_SLOTS; i++) {
+        if (slots[i].request == request) return &slots[i];
+    }
+    return nullptr;
+}
+
+JsonBodyHandler::Slot *JsonBodyHandler::acquire(AsyncWebServerRequest *request) {
+    // a request never holds two slots
+    Slot *slot = find(request);
+    if (!slot) slot = find(nullptr);
+    if (!slot) return nullptr;
+    slot->request = request;
+    slot->len = 0;
+    request->onDisconnect([request]() { release(request); });
+    return slot;
+}
+
+void JsonBodyHandler::release(AsyncWebServerRequest *request) {
+    Slot *slot = find(request);
+    if (slot) slot->request = nullptr;
+}
+
+bool JsonBodyHandler::canHandle(AsyncWebServerRequest *request) {
+    if (!(request->method() & (HTTP_POST | HTTP_PUT | HTTP_PATCH))) return false;
+    if (request->url() != uri) return false;
+    return request->contentType().equalsIgnoreCase("application/json");
+}
+
+void JsonBodyHandler::handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    if (total > JSON_BODY_SIZE) return;
+    Slot *slot = index == 0 ? acquire(request) : find(request);
+    if (!slot || index != slot->len) return;
+    memcpy(slot->data + index, data, len);
+    slot->len += len;
+}
+
+void JsonBodyHandler::handleRequest(AsyncWebServerRequest *request) {
+    Slot *slot = find(request);
+    if (!slot || slot->len != request->contentLength()) {
+        if (slot) slot->request = nullptr;
+        request->send(request->contentLength() > JSON_BODY_SIZE ? 413 : !slot && request->contentLength() ? 503 : 400);
+        return;
+    }
+
+    JsonDocument json(&arena);
+    DeserializationError error = deserializeJson(json, (const char *)slot->data, slot->len);
+    slot->request = nullptr;
+    if (error) {
+        request->send(error == DeserializationError::NoMemory ? 413 : 400);
+        return;
+    }
+    JsonVariant variant = json.as<JsonVariant>();
+    onRequest(request, variant);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <ESPAsyncWebServer.h>
+#include <ArduinoJson.h>
+
+#include <functional>
+
+#include "../json/json_arena.h"
+
+// Request bodies being received at once, across all JSON endpoints, and the
+// largest body accepted.
+#ifndef JSON_BODY_SLOTS
+#define JSON_BODY_SLOTS 2
+#endif
+#ifndef JSON_BODY_SIZE
+#define JSON_BODY_SIZE 4096
+#endif
+
+typedef std::function<void(AsyncWebServerRequest *request, JsonVariant &json)> JsonRequestCallback;
+
+// Takes the place of AsyncCallbackJsonWebHandler without its per-request
+// heap traffic: the body is collected into a buffer borrowed from a static
+// pool and parsed into a document backed by a JsonArena. A body that is too
+// large gets 413, one arriving while every buffer is busy gets 503. A
+// buffer goes back to the pool with its request, also when the client
+// drops mid-upload.
+class JsonBodyHandler : public AsyncWebHandler {
+    public:
+        JsonBodyHandler(const char *uri, JsonArena &arena, JsonRequestCallback onRequest);
+
+        bool canHandle(AsyncWebServerRequest *request) override;
+        void handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) override;
+        void handleRequest(AsyncWebServerRequest *request) override;
+        bool isRequestHandlerTrivial() override {return false;}
+
+    private:
+        struct Slot {
+            AsyncWebServerRequest *request;
+            size_t len;
+            char data[JSON_BODY_SIZE];
+        };
+
+        static Slot *find(AsyncWebServerRequest *request);
+        static Slot *acquire(AsyncWebServerRequest *request);
+        static void release(AsyncWebServerRequest *request);
+
+        static Slot slots[JSON_BODY_SLOTS];
+
+        const char *uri;
+        JsonArena &arena;
+        JsonRequestCallback onRequest;
+};
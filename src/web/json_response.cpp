@@ -0,0 +1,26 @@
+#include "./json_response.h"
+
+void sendJson(AsyncWebServerRequest *request, const JsonDocument &json, int code) {
+    if (json.overflowed()) {
+        request->send(500);
+        return;
+    }
+
+    // the stream's buffer is sized once, to the exact body length
+    AsyncResponseStream *response = request->beginResponseStream("application/json", measureJson(json));
+    response->setCode(code);
+    serializeJson(json, *response);
+    request->send(response);
+}
+
+AsyncWebSocketMessageBuffer *makeJsonBuffer(AsyncWebSocket &ws, const JsonDocument &json) {
+    if (json.overflowed()) return nullptr;
+
+    // makeBuffer() keeps a byte past size for the terminator serializeJson writes
+    const size_t len = measureJson(json);
+    AsyncWebSocketMessageBuffer *buffer = ws.makeBuffer(len);
+    // an unused buffer is reclaimed by the server along with sent ones
+    if (!buffer || !buffer->get()) return nullptr;
+    serializeJson(json, (char *)buffer->get(), len + 1);
+    return buffer;
+}
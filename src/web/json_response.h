@@ -0,0 +1,19 @@
+#pragma once
+
+#include <ESPAsyncWebServer.h>
+#include <ArduinoJson.h>
+
+// Serializing a document straight into what goes out on the wire, measured
+// first, so a body is never truncated to fit a stack buffer and never copied
+// through one.
+
+// Replies with json as an application/json body, or with 500 when the
+// document overflowed its arena and would only be a partial answer. The
+// body is serialized once, into a stream sized to the measured length; a
+// callback response would serialize it again for every chunk it is asked
+// for.
+void sendJson(AsyncWebServerRequest *request, const JsonDocument &json, int code = 200);
+
+// A WebSocket message buffer holding json, for client->text() or textAll();
+// nullptr when the document overflowed or no buffer could be had.
+AsyncWebSocketMessageBuffer *makeJsonBuffer(AsyncWebSocket &ws, const JsonDocument &json);
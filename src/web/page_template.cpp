@@ -0,0 +1,112 @@
+#include "./page_template.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+TemplateVar::TemplateVar(const char *name, TextGetter getter) : name(name), text(getter), number(nullptr) {
+}
+
+TemplateVar::TemplateVar(const char *name, NumberGetter getter) : name(name), text(nullptr), number(getter) {
+}
+
+const char *TemplateVar::getName() const {return name;}
+
+size_t TemplateVar::format(char *out, size_t size) const {
+    int len = text ? snprintf(out, size, "%s", text()) : snprintf(out, size, "%ld", (long)number());
+    if (len < 0) return 0;
+    return (size_t)len < size ? len : size - 1;
+}
+
+PageTemplate::PageTemplate(const TemplateVar *vars, uint8_t count) : vars(vars), count(count) {
+}
+
+PageTemplate::~PageTemplate() {
+    free(source);
+}
+
+bool PageTemplate::load(fs::FS &fs, const char *path) {
+    File file = fs.open(path, "r");
+    if (!file) return false;
+    const size_t len = file.size();
+    free(source);
+    source = (char *)malloc(len);
+    segmentCount = 0;
+    if (!source || len > UINT16_MAX || file.read((uint8_t *)source, len) != len) return false;
+    file.close();
+
+    size_t start = 0;
+    for (size_t open = 0; open < len; open++) {
+        if (source[open] != '%') continue;
+        const char *close = (const char *)memchr(source + open + 1, '%', len - open - 1);
+        if (!close) break;
+        const size_t end = close - source;
+
+        int8_t var = -1;
+        if (end == open + 1) {
+            // %% renders as the first %
+            if (!add(start, open + 1 - start, -1)) return false;
+        } else if ((var = find(source + open + 1, end - open - 1)) >= 0) {
+            if (!add(start, open - start, -1) || !add(0, 0, var)) return false;
+        } else {
+            // not ours: the text up to the second % stays literal, which may
+            // open the next placeholder
+            if (!add(start, end - start, -1)) return false;
+            start = end;
+            open = end - 1;
+            continue;
+        }
+        start = end + 1;
+        open = end;
+    }
+    if (!add(start, len - start, -1)) return false;
+
+    Serial.printf("PageTemplate: %s split into %u segments\n", path, segmentCount);
+    return true;
+}
+
+bool PageTemplate::add(uint16_t offset, uint16_t len, int8_t var) {
+    if (var < 0 && len == 0) return true;
+    if (segmentCount == TEMPLATE_MAX_SEGMENTS) {
+        Serial.println("PageTemplate: more segments than TEMPLATE_MAX_SEGMENTS");
+        segmentCount = 0;
+        return false;
+    }
+    Segment &segment = segments[segmentCount++];
+    segment.offset = offset;
+    segment.len = len;
+    segment.var = var;
+    return true;
+}
+
+int8_t PageTemplate::find(const char *name, size_t len) const {
+    for (uint8_t i = 0; i < count; i++) {
+        const char *candidate = vars[i].getName();
+        if (strlen(candidate) == len && memcmp(candidate, name, len) == 0) return i;
+    }
+    return -1;
+}
+
+AssetRef PageTemplate::render() const {
+    if (segmentCount == 0) return AssetRef();
+
+    // values first, so that the body is allocated once at its final size
+    char values[TEMPLATE_MAX_SEGMENTS][TEMPLATE_VALUE_SIZE];
+    size_t lens[TEMPLATE_MAX_SEGMENTS];
+    size_t total = 0;
+    for (uint8_t i = 0; i < segmentCount; i++) {
+        const Segment &segment = segments[i];
+        lens[i] = segment.var < 0 ? segment.len : vars[segment.var].format(values[i], TEMPLATE_VALUE_SIZE);
+        total += lens[i];
+    }
+
+    AssetRef page = std::make_shared<CachedAsset>(total);
+    if (!page->data) return AssetRef();
+    uint8_t *out = page->data;
+    for (uint8_t i = 0; i < segmentCount; i++) {
+        const Segment &segment = segments[i];
+        memcpy(out, segment.var < 0 ? source + segment.offset : values[i], lens[i]);
+        out += lens[i];
+    }
+    formatETag(page->etag, etagHash(page->data, page->len));
+    return page;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <FS.h>
+
+#include "./asset_cache.h"
+
+// Literal spans plus placeholders a template may be split into, and the
+// longest value a placeholder renders to.
+#ifndef TEMPLATE_MAX_SEGMENTS
+#define TEMPLATE_MAX_SEGMENTS 16
+#endif
+#define TEMPLATE_VALUE_SIZE 32
+
+// A %NAME% placeholder bound to a getter of its value.
+class TemplateVar {
+    public:
+        typedef const char *(*TextGetter)();
+        typedef int32_t (*NumberGetter)();
+
+        TemplateVar(const char *name, TextGetter getter);
+        TemplateVar(const char *name, NumberGetter getter);
+
+        const char *getName() const;
+        // writes the current value to out, returns its length
+        size_t format(char *out, size_t size) const;
+
+    private:
+        const char *name;
+        TextGetter text;
+        NumberGetter number;
+};
+
+// A template read and split once, in load(), into literal spans and bound
+// placeholders; rendering then only copies spans and formats the values,
+// without scanning the text or building a String per placeholder. %% stands
+// for a literal %, and a %NAME% with no variable bound is kept as it is.
+class PageTemplate {
+    public:
+        PageTemplate(const TemplateVar *vars, uint8_t count);
+        ~PageTemplate();
+
+        bool load(fs::FS &fs, const char *path);
+        // nullptr when not loaded or out of memory
+        AssetRef render() const;
+
+    private:
+        struct Segment {
+            uint16_t offset;
+            uint16_t len;
+            // index into vars, or -1 for the literal source[offset, offset + len)
+            int8_t var;
+        };
+
+        bool add(uint16_t offset, uint16_t len, int8_t var);
+        int8_t find(const char *name, size_t len) const;
+
+        const TemplateVar *vars;
+        const uint8_t count;
+        char *source = nullptr;
+        uint8_t segmentCount = 0;
+        Segment segments[TEMPLATE_MAX_SEGMENTS];
+};
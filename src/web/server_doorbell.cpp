@@ -0,0 +1,35 @@
+#include "./server_doorbell.h"
+
+ServerDoorbell::ServerDoorbell(uint16_t port, Handler handler)
+    : server(IPAddress(127, 0, 0, 1), port), port(port), handler(handler), pending(false) {
+}
+
+void ServerDoorbell::begin() {
+    server.onClient(&ServerDoorbell::onClient, this);
+    server.setNoDelay(true);
+    server.begin();
+}
+
+void ServerDoorbell::onClient(void *arg, AsyncClient *client) {
+    client->onData([](void *arg, AsyncClient *client, void *data, size_t len) {
+        ServerDoorbell *doorbell = (ServerDoorbell *)arg;
+        // cleared first: a ring while the handler runs must run it again
+        doorbell->pending.store(false);
+        doorbell->handler();
+    }, arg);
+    client->onDisconnect([](void *arg, AsyncClient *client) {
+        delete client;
+    }, arg);
+}
+
+bool ServerDoorbell::ring() {
+    if (!bell.connected()) {
+        // a ring still pending went with the old connection
+        pending.store(false);
+        if (!bell.connect(IPAddress(127, 0, 0, 1), port)) return false;
+    }
+    if (pending.exchange(true)) return true;
+    if (bell.write((uint8_t)1) == 1) return true;
+    pending.store(false);
+    return false;
+}
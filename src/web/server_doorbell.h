@@ -0,0 +1,40 @@
+#pragma once
+
+#include <AsyncTCP.h>
+#include <WiFi.h>
+
+#include <atomic>
+
+// Loopback port the doorbell connects through; nothing outside the device
+// ever connects to it.
+#ifndef SERVER_DOORBELL_PORT
+#define SERVER_DOORBELL_PORT 8079
+#endif
+
+// Runs a handler on the async server task at the request of another task.
+// That task only runs for network events and AsyncTCP offers no queue to
+// post work to, so the doorbell is a loopback connection: ring() writes a
+// byte into it, and the byte arriving runs the handler on the server task,
+// serialized with every request handler and WebSocket event. Rings made
+// while one is still pending are merged into it.
+class ServerDoorbell {
+    public:
+        typedef void (*Handler)();
+
+        ServerDoorbell(uint16_t port, Handler handler);
+
+        // from setup(), once the network stack is up
+        void begin();
+        // from a single task other than the server's; false, with nothing
+        // rung, when the connection could not be made
+        bool ring();
+
+    private:
+        static void onClient(void *arg, AsyncClient *client);
+
+        AsyncServer server;
+        WiFiClient bell;
+        const uint16_t port;
+        const Handler handler;
+        std::atomic<bool> pending;
+};
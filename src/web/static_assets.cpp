@@ -0,0 +1,86 @@
+#include "./static_assets.h"
+
+#define STRINGIFY(x) #x
+#define TO_STRING(x) STRINGIFY(x)
+
+static const char CACHE_CONTROL[] = "public, max-age=" TO_STRING(STATIC_ASSET_MAX_AGE);
+
+StaticAssets::StaticAssets(fs::FS &fs, AssetCache &cache, const StaticAsset *assets, uint8_t count)
+    : fs(fs), cache(cache), assets(assets), count(count < STATIC_ASSETS_MAX ? count : STATIC_ASSETS_MAX) {
+    for (uint8_t i = 0; i < STATIC_ASSETS_MAX; i++) {
+        found[i] = false;
+        etags[i][0] = '\0';
+    }
+}
+
+void StaticAssets::begin() {
+    for (uint8_t i = 0; i < count; i++) {
+        found[i] = tag(i);
+        if (!found[i]) Serial.printf("StaticAssets: %s not found\n", assets[i].path);
+    }
+}
+
+bool StaticAssets::tag(uint8_t index) {
+    AssetRef asset = loadAsset(fs, assets[index].path);
+    if (asset) {
+        memcpy(etags[index], asset->etag, ETAG_SIZE);
+        cache.put(assets[index].path, asset);
+        return true;
+    }
+
+    // too large for RAM: hashed from the file, and served from it
+    String path = assets[index].path;
+    if (!fs.exists(path)) path += ".gz";
+    if (!fs.exists(path)) return false;
+
+    File file = fs.open(path, "r");
+    if (!file) return false;
+    uint8_t chunk[256];
+    uint32_t hash = ETAG_HASH_INIT;
+    size_t len;
+    while ((len = file.read(chunk, sizeof(chunk))) > 0) hash = etagHash(chunk, len, hash);
+    file.close();
+
+    formatETag(etags[index], hash);
+    return true;
+}
+
+int8_t StaticAssets::find(const String &url) const {
+    for (uint8_t i = 0; i < count; i++) {
+        if (found[i] && url == assets[i].path) return i;
+    }
+    return -1;
+}
+
+bool StaticAssets::canHandle(AsyncWebServerRequest *request) {
+    return (request->method() & (HTTP_GET | HTTP_HEAD)) && find(request->url()) >= 0;
+}
+
+void StaticAssets::handleRequest(AsyncWebServerRequest *request) {
+    const int8_t i = find(request->url());
+    if (i < 0) {
+        request->send(404);
+        return;
+    }
+
+    AsyncWebHeader *match = request->getHeader("If-None-Match");
+    AsyncWebServerResponse *response;
+    if (match && match->value() == etags[i]) {
+        response = request->beginResponse(304);
+    } else {
+        AssetRef asset = cache.get(assets[i].path);
+        if (!asset) {
+            asset = loadAsset(fs, assets[i].path);
+            cache.put(assets[i].path, asset);
+        }
+        if (asset) {
+            sendAsset(request, asset, assets[i].contentType, CACHE_CONTROL);
+            return;
+        }
+        // the file response picks path + ".gz" and adds Content-Encoding itself
+        response = request->beginResponse(fs, assets[i].path, assets[i].contentType);
+    }
+    response->addHeader("ETag", etags[i]);
+    response->addHeader("Cache-Control", CACHE_CONTROL);
+    request->send(response);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <ESPAsyncWebServer.h>
+#include <FS.h>
+
+#include "./asset_cache.h"
+#include "./etag.h"
+
+// How long a browser may use an asset without asking again, in seconds.
+// Assets keep their URL across firmware updates, so this bounds how stale a
+// page can get; past it, a revalidation costs a bodiless 304.
+#ifndef STATIC_ASSET_MAX_AGE
+#define STATIC_ASSET_MAX_AGE 86400
+#endif
+
+#define STATIC_ASSETS_MAX 8
+
+struct StaticAsset {
+    const char *path;
+    const char *contentType;
+};
+
+// Serves a fixed set of files with a content-hash ETag and a Cache-Control
+// max-age, answering a matching If-None-Match with 304 so a page reload does
+// not read the files again. Bodies are served from an AssetCache and only
+// read from flash on a miss; one that cannot be held in RAM is streamed from
+// the file.
+//
+// tools/compress_assets.py stores assets gzipped; a file found as
+// path + ".gz" is sent as is with Content-Encoding: gzip, which every browser
+// accepts. The tags are hashed from the stored bytes once, in begin().
+class StaticAssets : public AsyncWebHandler {
+    public:
+        StaticAssets(fs::FS &fs, AssetCache &cache, const StaticAsset *assets, uint8_t count);
+
+        // reads every asset once to tag and cache it; missing ones are not
+        // served. Tags and cached bodies are kept until the next boot, so a
+        // change to the filesystem is only served after a reboot.
+        void begin();
+
+        bool canHandle(AsyncWebServerRequest *request) override;
+        void handleRequest(AsyncWebServerRequest *request) override;
+
+    private:
+        int8_t find(const String &url) const;
+        bool tag(uint8_t index);
+
+        fs::FS &fs;
+        AssetCache &cache;
+        const StaticAsset *assets;
+        const uint8_t count;
+        bool found[STATIC_ASSETS_MAX];
+        char etags[STATIC_ASSETS_MAX][ETAG_SIZE];
+};
@@ -0,0 +1,88 @@
+// Device::publish() and getSnapshot() across threads: a writer publishes
+// every axis at the same step count, readers check that no snapshot mixes
+// two publishes.
+
+#include <unity.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "device/device.h"
+
+static const uint32_t PUBLISHES = 200000;
+static const int READERS = 3;
+
+void setUp() {}
+void tearDown() {}
+
+void test_snapshot_single_thread() {
+    Device device(3, 100.0);
+    const int32_t steps[DEVICE_MAX_AXES] = { 10, 20, 30 };
+    device.setSteps(steps);
+    device.publish();
+
+    DeviceSnapshot snapshot;
+    device.getSnapshot(snapshot);
+    TEST_ASSERT_EQUAL_UINT8(3, snapshot.numberOfAxes);
+    TEST_ASSERT_EQUAL_INT32(10, snapshot.steps[0]);
+    TEST_ASSERT_EQUAL_INT32(30, snapshot.steps[2]);
+    TEST_ASSERT_EQUAL_FLOAT(20.0, snapshot.positions[1]);
+    TEST_ASSERT_EQUAL_FLOAT(100.0, snapshot.limits[2]);
+}
+
+void test_snapshot_never_torn() {
+    Device device(DEVICE_MAX_AXES, 100.0);
+    std::atomic<bool> done(false);
+    std::atomic<uint32_t> torn(0);
+    std::atomic<uint32_t> backwards(0);
+    std::atomic<uint32_t> reads(0);
+    std::atomic<int> started(0);
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READERS; r++) {
+        readers.push_back(std::thread([&]() {
+            DeviceSnapshot snapshot;
+            uint32_t lastSequence = 0;
+            uint32_t count = 0;
+            started++;
+            do {
+                device.getSnapshot(snapshot);
+                count++;
+                for (uint8_t i = 1; i < snapshot.numberOfAxes; i++) {
+                    if (snapshot.steps[i] != snapshot.steps[0] || snapshot.positions[i] != snapshot.positions[0]) {
+                        torn++;
+                        break;
+                    }
+                }
+                if ((int32_t)snapshot.sequence != snapshot.steps[0] + 1) torn++;
+                if (snapshot.sequence < lastSequence) backwards++;
+                lastSequence = snapshot.sequence;
+            } while (!done.load());
+            reads += count;
+        }));
+    }
+
+    // publish() numbers its snapshots from 1, the constructor's being the
+    // first, so publish n carries n - 1 steps
+    int32_t steps[DEVICE_MAX_AXES];
+    while (started.load() < READERS) std::this_thread::yield();
+    for (uint32_t n = 1; n < PUBLISHES; n++) {
+        for (uint8_t i = 0; i < DEVICE_MAX_AXES; i++) steps[i] = n;
+        device.setSteps(steps);
+        device.publish();
+    }
+    done.store(true);
+    for (std::thread &reader : readers) reader.join();
+
+    TEST_ASSERT_TRUE(reads.load() > 0);
+    TEST_ASSERT_EQUAL_UINT32(0, torn.load());
+    TEST_ASSERT_EQUAL_UINT32(0, backwards.load());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_snapshot_single_thread);
+    RUN_TEST(test_snapshot_never_torn);
+    return UNITY_END();
+}
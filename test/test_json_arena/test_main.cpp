@@ -0,0 +1,102 @@
+// JsonArena driven through the ArduinoJson::Allocator calls a document
+// makes: blocks stack up, the top one grows and shrinks in place, and the
+// arena rewinds once nothing is live.
+
+#include <unity.h>
+
+#include <string.h>
+
+#include "json/json_arena.h"
+
+static const size_t HEADER = 16;
+
+static uint8_t buffer[256] __attribute__((aligned(8)));
+
+void setUp() {}
+void tearDown() {}
+
+void test_allocate_and_rewind() {
+    JsonArena arena(buffer, sizeof(buffer));
+    void *a = arena.allocate(10);
+    void *b = arena.allocate(8);
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NOT_NULL(b);
+    TEST_ASSERT_EQUAL_size_t(0, (uintptr_t)a % 8);
+    TEST_ASSERT_EQUAL_size_t(0, (uintptr_t)b % 8);
+    TEST_ASSERT_EQUAL_size_t(2 * HEADER + 16 + 8, arena.getUsed());
+
+    // freeing below the top leaves the top where it is
+    arena.deallocate(a);
+    TEST_ASSERT_EQUAL_size_t(2 * HEADER + 16 + 8, arena.getUsed());
+    // freeing the last live block rewinds everything
+    arena.deallocate(b);
+    TEST_ASSERT_EQUAL_size_t(0, arena.getUsed());
+    TEST_ASSERT_EQUAL_size_t(2 * HEADER + 16 + 8, arena.getPeak());
+    TEST_ASSERT_EQUAL_PTR(a, arena.allocate(4));
+}
+
+void test_free_top_in_place() {
+    JsonArena arena(buffer, sizeof(buffer));
+    void *a = arena.allocate(8);
+    void *b = arena.allocate(8);
+    arena.deallocate(b);
+    TEST_ASSERT_EQUAL_size_t(HEADER + 8, arena.getUsed());
+    TEST_ASSERT_EQUAL_PTR(b, arena.allocate(8));
+    (void)a;
+}
+
+void test_reallocate_top_in_place() {
+    JsonArena arena(buffer, sizeof(buffer));
+    arena.allocate(8);
+    char *top = (char *)arena.allocate(8);
+    memcpy(top, "abcdefg", 8);
+
+    TEST_ASSERT_EQUAL_PTR(top, arena.reallocate(top, 64));
+    TEST_ASSERT_EQUAL_size_t(2 * HEADER + 8 + 64, arena.getUsed());
+    TEST_ASSERT_EQUAL_MEMORY("abcdefg", top, 8);
+
+    TEST_ASSERT_EQUAL_PTR(top, arena.reallocate(top, 1));
+    TEST_ASSERT_EQUAL_size_t(2 * HEADER + 8 + 8, arena.getUsed());
+    TEST_ASSERT_EQUAL_size_t(2 * HEADER + 8 + 64, arena.getPeak());
+}
+
+void test_reallocate_below_top_moves() {
+    JsonArena arena(buffer, sizeof(buffer));
+    char *a = (char *)arena.allocate(8);
+    memcpy(a, "abcdefg", 8);
+    arena.allocate(8);
+
+    // shrinking keeps the block, growing copies it to the top
+    TEST_ASSERT_EQUAL_PTR(a, arena.reallocate(a, 4));
+    char *moved = (char *)arena.reallocate(a, 32);
+    TEST_ASSERT_NOT_NULL(moved);
+    TEST_ASSERT_TRUE(moved != a);
+    TEST_ASSERT_EQUAL_MEMORY("abcdefg", moved, 8);
+    TEST_ASSERT_EQUAL_size_t(3 * HEADER + 8 + 8 + 32, arena.getUsed());
+}
+
+void test_failures_when_full() {
+    JsonArena arena(buffer, sizeof(buffer));
+    TEST_ASSERT_NULL(arena.allocate(sizeof(buffer)));
+    TEST_ASSERT_EQUAL_UINT32(1, arena.getFailures());
+
+    void *a = arena.allocate(sizeof(buffer) - HEADER);
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_EQUAL_size_t(sizeof(buffer), arena.getUsed());
+    TEST_ASSERT_NULL(arena.allocate(1));
+    TEST_ASSERT_NULL(arena.reallocate(a, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_UINT32(3, arena.getFailures());
+
+    arena.deallocate(a);
+    TEST_ASSERT_NOT_NULL(arena.allocate(1));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_allocate_and_rewind);
+    RUN_TEST(test_free_top_in_place);
+    RUN_TEST(test_reallocate_top_in_place);
+    RUN_TEST(test_reallocate_below_top_moves);
+    RUN_TEST(test_failures_when_full);
+    return UNITY_END();
+}
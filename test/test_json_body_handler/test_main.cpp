@@ -0,0 +1,140 @@
+// JsonBodyHandler's pool of body buffers: a request holds one from its
+// first body chunk until it is handled or goes away, and a request finding
+// them all busy gets 503.
+
+#include <unity.h>
+
+#include <string.h>
+
+#include "json/json_arena.h"
+#include "web/json_handler.h"
+
+static const char BODY[] = "{\"position\":[1]}";
+
+static uint32_t handled = 0;
+
+static JsonBodyHandler handler("/setPosition", serverJsonArena, [](AsyncWebServerRequest *request, JsonVariant &json) {
+    handled++;
+    request->send(200);
+});
+
+static AsyncWebServerRequest *post() {
+    AsyncWebServerRequest *request = new AsyncWebServerRequest(nullptr, nullptr);
+    String head = "POST /setPosition HTTP/1.1\r\nContent-Type: application/json\r\nContent-Length: ";
+    head += String((unsigned)strlen(BODY));
+    head += "\r\n";
+    request->_parse(head.c_str());
+    return request;
+}
+
+// the first few bytes of the body, which is when a buffer is taken
+static void start(AsyncWebServerRequest *request) {
+    handler.handleBody(request, (uint8_t *)BODY, 4, 0, strlen(BODY));
+}
+
+static void finish(AsyncWebServerRequest *request) {
+    handler.handleBody(request, (uint8_t *)BODY + 4, strlen(BODY) - 4, 4, strlen(BODY));
+    handler.handleRequest(request);
+}
+
+static int status(AsyncWebServerRequest *request) {
+    AsyncWebServerResponse *response = request->_takeResponse();
+    const int code = response ? response->code() : 0;
+    delete response;
+    return code;
+}
+
+// every buffer can be had: as many requests as buffers all go through.
+// requests are allocated before any earlier one is freed, so that none
+// reuses the address of a request a buffer may still wrongly point to.
+static void assertPoolFree(AsyncWebServerRequest **requests) {
+    for (uint8_t i = 0; i < JSON_BODY_SLOTS; i++) start(requests[i]);
+    for (uint8_t i = 0; i < JSON_BODY_SLOTS; i++) {
+        finish(requests[i]);
+        TEST_ASSERT_EQUAL(200, status(requests[i]));
+        delete requests[i];
+    }
+}
+
+void setUp() {
+    handled = 0;
+}
+
+void tearDown() {}
+
+void test_handles_a_whole_body() {
+    AsyncWebServerRequest *request = post();
+    TEST_ASSERT_TRUE(handler.canHandle(request));
+    start(request);
+    finish(request);
+    TEST_ASSERT_EQUAL_UINT32(1, handled);
+    TEST_ASSERT_EQUAL(200, status(request));
+    delete request;
+}
+
+void test_busy_pool_replies_503() {
+    AsyncWebServerRequest *requests[JSON_BODY_SLOTS + 1];
+    for (uint8_t i = 0; i <= JSON_BODY_SLOTS; i++) {
+        requests[i] = post();
+        start(requests[i]);
+    }
+    finish(requests[JSON_BODY_SLOTS]);
+    TEST_ASSERT_EQUAL(503, status(requests[JSON_BODY_SLOTS]));
+    TEST_ASSERT_EQUAL_UINT32(0, handled);
+
+    // the others still complete
+    for (uint8_t i = 0; i < JSON_BODY_SLOTS; i++) {
+        finish(requests[i]);
+        TEST_ASSERT_EQUAL(200, status(requests[i]));
+    }
+    for (AsyncWebServerRequest *request : requests) delete request;
+}
+
+void test_handled_request_frees_its_buffer() {
+    for (uint8_t round = 0; round < 3 * JSON_BODY_SLOTS; round++) {
+        AsyncWebServerRequest *request = post();
+        start(request);
+        finish(request);
+        TEST_ASSERT_EQUAL(200, status(request));
+        delete request;
+    }
+    TEST_ASSERT_EQUAL_UINT32(3 * JSON_BODY_SLOTS, handled);
+}
+
+// a client that drops mid-upload never reaches handleRequest()
+void test_dropped_request_frees_its_buffer() {
+    AsyncWebServerRequest *dropped[JSON_BODY_SLOTS];
+    AsyncWebServerRequest *requests[JSON_BODY_SLOTS];
+    for (uint8_t i = 0; i < JSON_BODY_SLOTS; i++) {
+        dropped[i] = post();
+        start(dropped[i]);
+        requests[i] = post();
+    }
+    for (AsyncWebServerRequest *request : dropped) delete request;
+    assertPoolFree(requests);
+}
+
+void test_body_too_large() {
+    AsyncWebServerRequest *requests[JSON_BODY_SLOTS];
+    for (AsyncWebServerRequest *&request : requests) request = post();
+    AsyncWebServerRequest *request = new AsyncWebServerRequest(nullptr, nullptr);
+    String head = "POST /setPosition HTTP/1.1\r\nContent-Type: application/json\r\nContent-Length: ";
+    head += String((unsigned)(JSON_BODY_SIZE + 1));
+    head += "\r\n";
+    request->_parse(head.c_str());
+    handler.handleBody(request, (uint8_t *)BODY, 4, 0, JSON_BODY_SIZE + 1);
+    handler.handleRequest(request);
+    TEST_ASSERT_EQUAL(413, status(request));
+    delete request;
+    assertPoolFree(requests);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_handles_a_whole_body);
+    RUN_TEST(test_busy_pool_replies_503);
+    RUN_TEST(test_handled_request_frees_its_buffer);
+    RUN_TEST(test_dropped_request_frees_its_buffer);
+    RUN_TEST(test_body_too_large);
+    return UNITY_END();
+}
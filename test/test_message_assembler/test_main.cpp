@@ -0,0 +1,145 @@
+// MessageAssembler fed the WS_EVT_DATA events ESPAsyncWebServer raises.
+// The library sets AwsFrameInfo::message_opcode and num only for a frame it
+// splits over several events; for a whole frame they hold whatever the
+// previous message left, which the tests imitate with STALE values.
+
+#include <unity.h>
+
+#include <string.h>
+
+#include "protocol/message_assembler.h"
+
+static const uint8_t STALE_OPCODE = 0x0b;
+static const uint32_t STALE_NUM = 7;
+
+static MessageAssembler assembler;
+
+// info for a whole frame delivered in one event
+static AwsFrameInfo frame(uint8_t opcode, bool final, size_t len) {
+    AwsFrameInfo info;
+    memset(&info, 0, sizeof(info));
+    info.message_opcode = STALE_OPCODE;
+    info.num = STALE_NUM;
+    info.opcode = opcode;
+    info.final = final;
+    info.len = len;
+    info.index = 0;
+    return info;
+}
+
+static AssemblerResult feed(uint32_t clientId, AwsFrameInfo &info, const char *data, size_t len, AssembledMessage &message) {
+    AssemblerResult result = assembler.feed(clientId, info, (uint8_t *)data, len, message);
+    info.index += len;
+    return result;
+}
+
+void setUp() {
+    for (uint32_t id = 1; id <= ASSEMBLER_SLOTS + 1; id++) assembler.release(id);
+}
+
+void tearDown() {}
+
+void test_single_frame() {
+    char text[] = "{\"action\":\"toggle\"}";
+    AwsFrameInfo info = frame(WS_TEXT, true, strlen(text));
+    AssembledMessage message;
+    TEST_ASSERT_EQUAL(ASSEMBLER_COMPLETE, feed(1, info, text, strlen(text), message));
+    TEST_ASSERT_EQUAL_UINT8(WS_TEXT, message.opcode);
+    // passed through without a copy
+    TEST_ASSERT_EQUAL_PTR(text, message.data);
+    TEST_ASSERT_EQUAL_size_t(strlen(text), message.len);
+    TEST_ASSERT_EQUAL_UINT8(0, assembler.used());
+}
+
+void test_split_frame() {
+    const char *binary = "0123456789";
+    AwsFrameInfo info = frame(WS_BINARY, true, 10);
+    // the library only fills these in for a frame it splits
+    info.message_opcode = WS_BINARY;
+    info.num = 0;
+
+    AssembledMessage message;
+    TEST_ASSERT_EQUAL(ASSEMBLER_PENDING, feed(1, info, binary, 4, message));
+    TEST_ASSERT_EQUAL_UINT8(1, assembler.used());
+    TEST_ASSERT_EQUAL(ASSEMBLER_COMPLETE, feed(1, info, binary + 4, 6, message));
+    TEST_ASSERT_EQUAL_UINT8(WS_BINARY, message.opcode);
+    TEST_ASSERT_EQUAL_size_t(10, message.len);
+    TEST_ASSERT_EQUAL_MEMORY(binary, message.data, 10);
+    TEST_ASSERT_EQUAL_UINT8(0, assembler.used());
+}
+
+void test_fragmented_message() {
+    AssembledMessage message;
+    AwsFrameInfo first = frame(WS_TEXT, false, 5);
+    TEST_ASSERT_EQUAL(ASSEMBLER_PENDING, feed(1, first, "hello", 5, message));
+    AwsFrameInfo second = frame(WS_CONTINUATION, false, 1);
+    TEST_ASSERT_EQUAL(ASSEMBLER_PENDING, feed(1, second, " ", 1, message));
+    AwsFrameInfo last = frame(WS_CONTINUATION, true, 5);
+    TEST_ASSERT_EQUAL(ASSEMBLER_COMPLETE, feed(1, last, "world", 5, message));
+    TEST_ASSERT_EQUAL_UINT8(WS_TEXT, message.opcode);
+    TEST_ASSERT_EQUAL_size_t(11, message.len);
+    TEST_ASSERT_EQUAL_MEMORY("hello world", message.data, 11);
+}
+
+void test_interleaved_clients() {
+    AssembledMessage message;
+    AwsFrameInfo a = frame(WS_BINARY, false, 2);
+    AwsFrameInfo b = frame(WS_TEXT, false, 2);
+    TEST_ASSERT_EQUAL(ASSEMBLER_PENDING, feed(1, a, "ab", 2, message));
+    TEST_ASSERT_EQUAL(ASSEMBLER_PENDING, feed(2, b, "xy", 2, message));
+
+    AwsFrameInfo aEnd = frame(WS_CONTINUATION, true, 1);
+    TEST_ASSERT_EQUAL(ASSEMBLER_COMPLETE, feed(1, aEnd, "c", 1, message));
+    TEST_ASSERT_EQUAL_UINT8(WS_BINARY, message.opcode);
+    TEST_ASSERT_EQUAL_MEMORY("abc", message.data, 3);
+
+    AwsFrameInfo bEnd = frame(WS_CONTINUATION, true, 1);
+    TEST_ASSERT_EQUAL(ASSEMBLER_COMPLETE, feed(2, bEnd, "z", 1, message));
+    TEST_ASSERT_EQUAL_UINT8(WS_TEXT, message.opcode);
+    TEST_ASSERT_EQUAL_MEMORY("xyz", message.data, 3);
+}
+
+void test_too_big() {
+    AssembledMessage message;
+    AwsFrameInfo whole = frame(WS_BINARY, true, ASSEMBLER_MAX_MESSAGE + 1);
+    TEST_ASSERT_EQUAL(ASSEMBLER_TOO_BIG, feed(1, whole, "x", 1, message));
+
+    AwsFrameInfo first = frame(WS_TEXT, false, ASSEMBLER_MAX_MESSAGE);
+    static char filler[ASSEMBLER_MAX_MESSAGE];
+    TEST_ASSERT_EQUAL(ASSEMBLER_PENDING, feed(1, first, filler, sizeof(filler), message));
+    AwsFrameInfo more = frame(WS_CONTINUATION, true, 1);
+    TEST_ASSERT_EQUAL(ASSEMBLER_TOO_BIG, feed(1, more, "x", 1, message));
+    TEST_ASSERT_EQUAL_UINT8(0, assembler.used());
+}
+
+void test_no_buffer_and_discarded() {
+    AssembledMessage message;
+    for (uint32_t id = 1; id <= ASSEMBLER_SLOTS; id++) {
+        AwsFrameInfo info = frame(WS_TEXT, false, 1);
+        TEST_ASSERT_EQUAL(ASSEMBLER_PENDING, feed(id, info, "a", 1, message));
+    }
+    AwsFrameInfo info = frame(WS_TEXT, false, 1);
+    TEST_ASSERT_EQUAL(ASSEMBLER_NO_BUFFER, feed(ASSEMBLER_SLOTS + 1, info, "a", 1, message));
+    AwsFrameInfo rest = frame(WS_CONTINUATION, true, 1);
+    TEST_ASSERT_EQUAL(ASSEMBLER_DISCARDED, feed(ASSEMBLER_SLOTS + 1, rest, "b", 1, message));
+
+    // a whole message still gets through without a buffer
+    AwsFrameInfo whole = frame(WS_BINARY, true, 3);
+    TEST_ASSERT_EQUAL(ASSEMBLER_COMPLETE, feed(ASSEMBLER_SLOTS + 1, whole, "abc", 3, message));
+
+    assembler.release(1);
+    TEST_ASSERT_EQUAL_UINT8(ASSEMBLER_SLOTS - 1, assembler.used());
+    AwsFrameInfo afterRelease = frame(WS_CONTINUATION, true, 1);
+    TEST_ASSERT_EQUAL(ASSEMBLER_DISCARDED, feed(1, afterRelease, "b", 1, message));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_single_frame);
+    RUN_TEST(test_split_frame);
+    RUN_TEST(test_fragmented_message);
+    RUN_TEST(test_interleaved_clients);
+    RUN_TEST(test_too_big);
+    RUN_TEST(test_no_buffer_and_discarded);
+    return UNITY_END();
+}
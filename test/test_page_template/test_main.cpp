@@ -0,0 +1,100 @@
+// PageTemplate loaded from a file and rendered: placeholders take their
+// getters' current values, %% is a literal %, and unknown names are kept.
+
+#include <unity.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "web/page_template.h"
+
+static char root[] = "/tmp/page_template_XXXXXX";
+
+static const char *name = "axis";
+static int32_t count = 3;
+
+static const char *getName() {return name;}
+static int32_t getCount() {return count;}
+
+static const TemplateVar VARS[] = {
+    TemplateVar("NAME", getName),
+    TemplateVar("COUNT", getCount),
+};
+
+static fs::FS &volume() {
+    static fs::FS fs(root);
+    return fs;
+}
+
+static void write(const char *path, const char *text) {
+    File file = volume().open(path, "w");
+    file.write((const uint8_t *)text, strlen(text));
+    file.close();
+}
+
+static void assertPage(const char *expected, const AssetRef &page) {
+    TEST_ASSERT_NOT_NULL(page.get());
+    TEST_ASSERT_EQUAL_size_t(strlen(expected), page->len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, page->data, page->len);
+}
+
+void setUp() {
+    name = "axis";
+    count = 3;
+}
+
+void tearDown() {}
+
+void test_renders_current_values() {
+    write("/index.html", "<p>%COUNT% x %NAME%</p>");
+    PageTemplate page(VARS, 2);
+    TEST_ASSERT_TRUE(page.load(volume(), "/index.html"));
+    assertPage("<p>3 x axis</p>", page.render());
+
+    name = "motor";
+    count = -12;
+    assertPage("<p>-12 x motor</p>", page.render());
+}
+
+void test_literal_percent_and_unknown_names() {
+    write("/index.html", "100%% %WIDTH% %NAME%%");
+    PageTemplate page(VARS, 2);
+    TEST_ASSERT_TRUE(page.load(volume(), "/index.html"));
+    assertPage("100% %WIDTH% axis%", page.render());
+}
+
+void test_etag_follows_the_body() {
+    write("/index.html", "%COUNT%");
+    PageTemplate page(VARS, 2);
+    TEST_ASSERT_TRUE(page.load(volume(), "/index.html"));
+    AssetRef first = page.render();
+    TEST_ASSERT_EQUAL_STRING(first->etag, page.render()->etag);
+    count = 4;
+    TEST_ASSERT_TRUE(strcmp(first->etag, page.render()->etag) != 0);
+}
+
+void test_missing_file_renders_nothing() {
+    PageTemplate page(VARS, 2);
+    TEST_ASSERT_FALSE(page.load(volume(), "/missing.html"));
+    TEST_ASSERT_NULL(page.render().get());
+}
+
+void test_too_many_segments_renders_nothing() {
+    String text;
+    for (uint8_t i = 0; i < TEMPLATE_MAX_SEGMENTS; i++) text += "-%NAME%";
+    write("/index.html", text.c_str());
+    PageTemplate page(VARS, 2);
+    TEST_ASSERT_FALSE(page.load(volume(), "/index.html"));
+    TEST_ASSERT_NULL(page.render().get());
+}
+
+int main(int argc, char **argv) {
+    if (!mkdtemp(root)) return 1;
+    UNITY_BEGIN();
+    RUN_TEST(test_renders_current_values);
+    RUN_TEST(test_literal_percent_and_unknown_names);
+    RUN_TEST(test_etag_follows_the_body);
+    RUN_TEST(test_missing_file_renders_nothing);
+    RUN_TEST(test_too_many_segments_renders_nothing);
+    return UNITY_END();
+}
@@ -0,0 +1,145 @@
+// Planner segments run through a Trajectory tick by tick, as the step
+// interrupt does: every axis must end exactly on its target, move at most
+// one step per tick and never step on two ticks in a row.
+
+#include <unity.h>
+
+#include <stdlib.h>
+
+#include "device/device.h"
+#include "motion/planner.h"
+#include "motion/trajectory.h"
+
+static const uint32_t TICK_RATE = 10000;
+
+struct Result {
+    uint32_t ticks;
+    int32_t  steps[DEVICE_MAX_AXES];
+    bool     tooFast;
+    bool     backToBack;
+};
+
+static void configure(Device &device, float ratio, float accel) {
+    float limits[DEVICE_MAX_AXES], ratios[DEVICE_MAX_AXES], accels[DEVICE_MAX_AXES];
+    for (uint8_t i = 0; i < DEVICE_MAX_AXES; i++) {
+        limits[i] = DEVICE_MAX_STEPS / ratio;
+        if (limits[i] > DEVICE_MAX_LIMIT) limits[i] = DEVICE_MAX_LIMIT;
+        ratios[i] = ratio;
+        accels[i] = accel;
+    }
+    device.restoreConfig(limits, ratios, accels);
+}
+
+static Result run(const Device &device, const int32_t *from, const int32_t *to, float feedrate) {
+    const uint8_t n = device.getNumberOfAxes();
+    Planner planner(device, TICK_RATE);
+    Segment segment;
+    TEST_ASSERT_TRUE(planner.plan(from, to, feedrate, segment));
+
+    Result result;
+    result.ticks = 0;
+    result.tooFast = false;
+    result.backToBack = false;
+    int32_t previous[DEVICE_MAX_AXES];
+    bool steppedLastTick[DEVICE_MAX_AXES];
+    for (uint8_t i = 0; i < n; i++) {
+        previous[i] = from[i];
+        steppedLastTick[i] = false;
+    }
+
+    Trajectory trajectory;
+    trajectory.start(segment, n);
+    while (trajectory.tick(result.steps)) {
+        result.ticks++;
+        for (uint8_t i = 0; i < n; i++) {
+            const int32_t delta = abs(result.steps[i] - previous[i]);
+            if (delta > 1) result.tooFast = true;
+            if (delta && steppedLastTick[i]) result.backToBack = true;
+            steppedLastTick[i] = delta != 0;
+            previous[i] = result.steps[i];
+        }
+        TEST_ASSERT_TRUE(result.ticks < 100000000);
+    }
+    return result;
+}
+
+static void assertMove(const Device &device, const int32_t *from, const int32_t *to, float feedrate) {
+    const Result result = run(device, from, to, feedrate);
+    int32_t maxSteps = 0;
+    for (uint8_t i = 0; i < device.getNumberOfAxes(); i++) {
+        TEST_ASSERT_EQUAL_INT32(to[i], result.steps[i]);
+        if (abs(to[i] - from[i]) > maxSteps) maxSteps = abs(to[i] - from[i]);
+    }
+    TEST_ASSERT_FALSE(result.tooFast);
+    TEST_ASSERT_FALSE(result.backToBack);
+    TEST_ASSERT_GREATER_OR_EQUAL((uint32_t)(maxSteps / MOTION_MAX_STEPS_PER_TICK), result.ticks);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_nothing_to_move() {
+    Device device(2);
+    Planner planner(device, TICK_RATE);
+    const int32_t at[DEVICE_MAX_AXES] = { 5, -5 };
+    Segment segment;
+    TEST_ASSERT_FALSE(planner.plan(at, at, 10.0, segment));
+}
+
+void test_single_axis_trapezoid() {
+    Device device(1);
+    configure(device, 100.0, 200.0);
+    const int32_t from[DEVICE_MAX_AXES] = { 0 };
+    const int32_t to[DEVICE_MAX_AXES] = { 20000 };
+    assertMove(device, from, to, 20.0);
+}
+
+void test_short_triangle() {
+    Device device(1);
+    configure(device, 100.0, 50.0);
+    const int32_t from[DEVICE_MAX_AXES] = { 1000 };
+    const int32_t to[DEVICE_MAX_AXES] = { 1007 };
+    assertMove(device, from, to, 50.0);
+}
+
+void test_reverse_and_diagonal() {
+    Device device(3);
+    configure(device, 80.0, 500.0);
+    const int32_t from[DEVICE_MAX_AXES] = { 40000, 0, 1234 };
+    const int32_t to[DEVICE_MAX_AXES] = { 0, 17321, 1234 };
+    assertMove(device, from, to, 60.0);
+}
+
+// a feedrate far beyond the tick rate is capped at the planner's step rate
+void test_capped_at_max_step_rate() {
+    Device device(2);
+    configure(device, 1000.0, 10000.0);
+    const int32_t from[DEVICE_MAX_AXES] = { 0, 0 };
+    const int32_t to[DEVICE_MAX_AXES] = { 100000, -33333 };
+    assertMove(device, from, to, 1000.0);
+}
+
+void test_step_totals_over_many_moves() {
+    Device device(2);
+    configure(device, 100.0, 300.0);
+    int32_t from[DEVICE_MAX_AXES] = { 0, 0 };
+    srand(1);
+    for (int move = 0; move < 50; move++) {
+        int32_t to[DEVICE_MAX_AXES] = { rand() % 20000 - 10000, rand() % 2000 - 1000 };
+        if (to[0] == from[0] && to[1] == from[1]) continue;
+        assertMove(device, from, to, 5.0 + rand() % 100);
+        from[0] = to[0];
+        from[1] = to[1];
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_nothing_to_move);
+    RUN_TEST(test_single_axis_trapezoid);
+    RUN_TEST(test_short_triangle);
+    RUN_TEST(test_reverse_and_diagonal);
+    RUN_TEST(test_capped_at_max_step_rate);
+    RUN_TEST(test_step_totals_over_many_moves);
+    return UNITY_END();
+}
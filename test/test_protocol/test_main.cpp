@@ -0,0 +1,173 @@
+// Binary protocol: decodeCommand() against hand-built frames, and the
+// byte layout of the frames the device sends (see protocol.h).
+
+#include <unity.h>
+
+#include <string.h>
+
+#include "protocol/protocol.h"
+
+// frames are built and read with memcpy: the native test host is
+// little-endian, like the wire format
+static size_t putHeader(uint8_t *out, uint8_t type, uint8_t numberOfAxes, uint8_t flags, uint32_t seq) {
+    out[0] = PROTOCOL_VERSION;
+    out[1] = type;
+    out[2] = numberOfAxes;
+    out[3] = flags;
+    memcpy(out + 4, &seq, 4);
+    return PROTOCOL_HEADER_SIZE;
+}
+
+static uint32_t getU32(const uint8_t *in) {
+    uint32_t value;
+    memcpy(&value, in, 4);
+    return value;
+}
+
+static float getF32(const uint8_t *in) {
+    float value;
+    memcpy(&value, in, 4);
+    return value;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_decode_set_position() {
+    uint8_t frame[64];
+    size_t len = putHeader(frame, MSG_SET_POSITION, 2, 0x03, 0x01020304);
+    const float payload[3] = { 12.5, -1.0, 40.0 };
+    memcpy(frame + len, payload, sizeof(payload));
+    len += sizeof(payload);
+
+    Command command;
+    TEST_ASSERT_EQUAL(ACK_OK, decodeCommand(frame, len, command));
+    TEST_ASSERT_EQUAL_UINT8(MSG_SET_POSITION, command.header.type);
+    TEST_ASSERT_EQUAL_UINT8(0x03, command.header.flags);
+    TEST_ASSERT_EQUAL_UINT32(0x01020304, command.header.seq);
+    TEST_ASSERT_EQUAL_FLOAT(12.5, command.positions[0]);
+    TEST_ASSERT_EQUAL_FLOAT(-1.0, command.positions[1]);
+    TEST_ASSERT_EQUAL_FLOAT(40.0, command.feedrate);
+
+    TEST_ASSERT_EQUAL(ACK_BAD_LENGTH, decodeCommand(frame, len - 1, command));
+}
+
+void test_decode_subscribe() {
+    uint8_t frame[16];
+    size_t len = putHeader(frame, MSG_SUBSCRIBE, 0, 0x05, 7);
+    frame[len++] = 20;
+    frame[len++] = 1;
+
+    Command command;
+    TEST_ASSERT_EQUAL(ACK_OK, decodeCommand(frame, len, command));
+    TEST_ASSERT_EQUAL_UINT16(276, command.rate);
+    TEST_ASSERT_EQUAL_UINT8(0x05, command.header.flags);
+}
+
+void test_decode_program() {
+    uint8_t frame[64];
+    size_t len = putHeader(frame, MSG_PROGRAM, 2, 0x03, 9);
+    const uint16_t header[2] = { 2, 0 };
+    memcpy(frame + len, header, sizeof(header));
+    len += sizeof(header);
+    const float waypoints[6] = { 1.0, 2.0, 10.0, 3.0, 4.0, 0.0 };
+    memcpy(frame + len, waypoints, sizeof(waypoints));
+    len += sizeof(waypoints);
+
+    Command command;
+    TEST_ASSERT_EQUAL(ACK_OK, decodeCommand(frame, len, command));
+    TEST_ASSERT_EQUAL_UINT16(2, command.waypointCount);
+
+    float positions[DEVICE_MAX_AXES];
+    float feedrate;
+    getWaypoint(command, 1, positions, feedrate);
+    TEST_ASSERT_EQUAL_FLOAT(3.0, positions[0]);
+    TEST_ASSERT_EQUAL_FLOAT(4.0, positions[1]);
+    TEST_ASSERT_EQUAL_FLOAT(0.0, feedrate);
+
+    // a count that does not match the payload
+    frame[PROTOCOL_HEADER_SIZE] = 3;
+    TEST_ASSERT_EQUAL(ACK_BAD_LENGTH, decodeCommand(frame, len, command));
+}
+
+void test_decode_errors() {
+    uint8_t frame[64];
+    Command command;
+    size_t len = putHeader(frame, MSG_HOME, 0, 0, 1);
+    TEST_ASSERT_EQUAL(ACK_OK, decodeCommand(frame, len, command));
+    TEST_ASSERT_EQUAL(ACK_BAD_LENGTH, decodeCommand(frame, len - 1, command));
+    TEST_ASSERT_EQUAL(ACK_BAD_LENGTH, decodeCommand(frame, len + 1, command));
+
+    frame[0] = PROTOCOL_VERSION + 1;
+    TEST_ASSERT_EQUAL(ACK_BAD_VERSION, decodeCommand(frame, len, command));
+    // the seq is still decoded, so the Ack can echo it
+    TEST_ASSERT_EQUAL_UINT32(1, command.header.seq);
+
+    putHeader(frame, 0x7f, 0, 0, 1);
+    TEST_ASSERT_EQUAL(ACK_BAD_TYPE, decodeCommand(frame, len, command));
+
+    putHeader(frame, MSG_SET_POSITION, DEVICE_MAX_AXES + 1, 0, 1);
+    TEST_ASSERT_EQUAL(ACK_BAD_LENGTH, decodeCommand(frame, PROTOCOL_HEADER_SIZE + 4 * (DEVICE_MAX_AXES + 2), command));
+}
+
+void test_encode_ack() {
+    uint8_t out[PROTOCOL_HEADER_SIZE];
+    TEST_ASSERT_EQUAL_size_t(PROTOCOL_HEADER_SIZE, encodeAck(42, ACK_FULL, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_UINT8(PROTOCOL_VERSION, out[0]);
+    TEST_ASSERT_EQUAL_UINT8(MSG_ACK, out[1]);
+    TEST_ASSERT_EQUAL_UINT8(ACK_FULL, out[3]);
+    TEST_ASSERT_EQUAL_UINT32(42, getU32(out + 4));
+    TEST_ASSERT_EQUAL_size_t(0, encodeAck(42, ACK_OK, out, sizeof(out) - 1));
+}
+
+void test_encode_telemetry() {
+    TelemetrySample sample;
+    memset(&sample, 0, sizeof(sample));
+    sample.seq = 5;
+    sample.time = 123456;
+    sample.numberOfAxes = 2;
+    sample.moving = true;
+    sample.homedMask = 0x2;
+    sample.positions[0] = 1.5;
+    sample.positions[1] = 2.5;
+    sample.velocities[0] = -3.0;
+    sample.velocities[1] = 4.0;
+
+    uint8_t out[PROTOCOL_MAX_FRAME_SIZE];
+    const size_t len = encodeTelemetry(sample, out, sizeof(out));
+    TEST_ASSERT_EQUAL_size_t(PROTOCOL_HEADER_SIZE + 8 + 16, len);
+    TEST_ASSERT_EQUAL_UINT8(MSG_TELEMETRY, out[1]);
+    TEST_ASSERT_EQUAL_UINT8(2, out[2]);
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_FLAG_MOVING, out[3]);
+    TEST_ASSERT_EQUAL_UINT32(5, getU32(out + 4));
+    TEST_ASSERT_EQUAL_UINT32(123456, getU32(out + 8));
+    TEST_ASSERT_EQUAL_UINT32(0x2, getU32(out + 12));
+    TEST_ASSERT_EQUAL_FLOAT(1.5, getF32(out + 16));
+    TEST_ASSERT_EQUAL_FLOAT(2.5, getF32(out + 20));
+    TEST_ASSERT_EQUAL_FLOAT(-3.0, getF32(out + 24));
+    TEST_ASSERT_EQUAL_FLOAT(4.0, getF32(out + 28));
+    TEST_ASSERT_EQUAL_size_t(0, encodeTelemetry(sample, out, len - 1));
+}
+
+void test_encode_program_status() {
+    uint8_t out[PROTOCOL_HEADER_SIZE + 8];
+    TEST_ASSERT_EQUAL_size_t(sizeof(out), encodeProgramStatus(3, 1, 10, 64, 77, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_UINT8(MSG_PROGRAM_STATUS, out[1]);
+    TEST_ASSERT_EQUAL_UINT8(1, out[3]);
+    TEST_ASSERT_EQUAL_UINT32(3, getU32(out + 4));
+    TEST_ASSERT_EQUAL_UINT8(10, out[8]);
+    TEST_ASSERT_EQUAL_UINT8(64, out[10]);
+    TEST_ASSERT_EQUAL_UINT32(77, getU32(out + 12));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_decode_set_position);
+    RUN_TEST(test_decode_subscribe);
+    RUN_TEST(test_decode_program);
+    RUN_TEST(test_decode_errors);
+    RUN_TEST(test_encode_ack);
+    RUN_TEST(test_encode_telemetry);
+    RUN_TEST(test_encode_program_status);
+    return UNITY_END();
+}
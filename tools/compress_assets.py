@@ -0,0 +1,53 @@
+"""Gzips the web assets in data/ before they go into the SPIFFS image.
+
+Used by platformio.ini as a pre script: the assets are written to
+$BUILD_DIR/data, which becomes the directory `pio run -t buildfs/uploadfs`
+packs. Every file is stored as <name>.gz, except templates (files holding
+%PLACEHOLDER% markers), which the firmware has to read as text and are
+copied unchanged. The output is deterministic, so the ETags the firmware
+hashes from it only change with the content.
+
+Also runs standalone, e.g. for the native build:
+
+    python tools/compress_assets.py data .pio/build/native/data
+"""
+
+import gzip
+import os
+import re
+import shutil
+import sys
+
+TEMPLATE = re.compile(rb"%[A-Z0-9_]+%")
+
+
+def compress_assets(source, target):
+    shutil.rmtree(target, ignore_errors=True)
+    os.makedirs(target)
+    for name in sorted(os.listdir(source)):
+        path = os.path.join(source, name)
+        if not os.path.isfile(path):
+            continue
+        with open(path, "rb") as f:
+            content = f.read()
+        if TEMPLATE.search(content):
+            shutil.copyfile(path, os.path.join(target, name))
+            print("assets: %s kept as template (%d bytes)" % (name, len(content)))
+            continue
+        with open(os.path.join(target, name + ".gz"), "wb") as f:
+            # no name or mtime in the header, so equal input gives equal output
+            with gzip.GzipFile(filename="", mode="wb", fileobj=f, compresslevel=9, mtime=0) as gz:
+                gz.write(content)
+        packed = os.path.getsize(os.path.join(target, name + ".gz"))
+        print("assets: %s %d -> %d bytes" % (name, len(content), packed))
+
+
+try:
+    Import("env")  # noqa: F821, provided by PlatformIO
+except NameError:
+    compress_assets(sys.argv[1], sys.argv[2])
+else:
+    source = env.subst("$PROJECT_DATA_DIR")  # noqa: F821
+    target = os.path.join(env.subst("$BUILD_DIR"), "data")  # noqa: F821
+    compress_assets(source, target)
+    env.Replace(PROJECT_DATA_DIR=target)  # noqa: F821
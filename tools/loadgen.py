@@ -0,0 +1,465 @@
+"""Emulates many operator stations against one controller.
+
+Opens N WebSocket connections to /ws (dashboards and controllers) and runs
+M HTTP pollers against /getPosition and /setPosition, each at a fixed rate,
+then reports latency histograms, errors and the telemetry frames that never
+arrived. Works against the native build and against a real device:
+
+    python tools/loadgen.py --host 127.0.0.1 --port 8080 --ws 8 --http 4
+    python tools/loadgen.py --host 192.168.1.50 --port 80 --ws 4 --telemetry 20
+
+Load is open loop: calls go out on schedule whether or not earlier ones were
+answered, so a stalled controller shows up as latency rather than as a lower
+request rate. Message mixes are weights, e.g. --ws-mix set=3,status=1:
+
+  WebSocket  set     binary SetPosition, answered with an Ack
+             status  binary Status, answered with a ProgramStatus
+             text    {"action":"status"}, answered with a programStatus text
+  HTTP       get     GET /getPosition
+             set     POST /setPosition
+
+With --telemetry every WebSocket subscribes to binary telemetry at that rate.
+Frames count as dropped when fewer arrive than the rate asks for; the
+firmware skips a sample for a client still sending the previous one. (The
+sample numbers in the frames count samples taken for all clients, so their
+gaps say nothing about one connection.)
+
+Only needs the Python 3 standard library; --json writes the results,
+histogram buckets included, for comparison between firmware builds.
+"""
+
+import argparse
+import asyncio
+import base64
+import json
+import math
+import os
+import random
+import struct
+import sys
+import time
+
+PROTOCOL_VERSION = 1
+MSG_SET_POSITION = 0x01
+MSG_SUBSCRIBE = 0x03
+MSG_STATUS = 0x09
+MSG_ACK = 0x80
+MSG_TELEMETRY = 0x81
+MSG_PROGRAM_STATUS = 0x82
+
+# fastest telemetry rate the firmware grants (TELEMETRY_MAX_RATE)
+TELEMETRY_MAX_RATE = 50
+
+HTTP_TIMEOUT = 5.0
+REPLY_TIMEOUT = 5.0
+RECONNECT_DELAY = 1.0
+# requests one HTTP poller keeps in flight before it skips its schedule
+HTTP_MAX_IN_FLIGHT = 8
+
+
+# ----------------------------------------------------------------------------
+# Statistics
+# ----------------------------------------------------------------------------
+
+class Histogram:
+    """Latencies in buckets a quarter octave wide, from 1 us up."""
+
+    STEPS = 4
+
+    def __init__(self):
+        self.buckets = {}
+        self.count = 0
+        self.max = 0.0
+
+    def record(self, seconds):
+        us = max(seconds * 1e6, 1.0)
+        index = int(math.log2(us) * self.STEPS)
+        self.buckets[index] = self.buckets.get(index, 0) + 1
+        self.count += 1
+        self.max = max(self.max, us)
+
+    def upper(self, index):
+        return 2 ** ((index + 1) / self.STEPS)
+
+    def percentile(self, p):
+        """Upper edge of the bucket holding the p-th percentile, in us."""
+        if not self.count:
+            return 0.0
+        rank = p / 100.0 * self.count
+        seen = 0
+        for index in sorted(self.buckets):
+            seen += self.buckets[index]
+            if seen >= rank:
+                return min(self.upper(index), self.max)
+        return self.max
+
+    def to_json(self):
+        return {
+            "count": self.count,
+            "p50_us": self.percentile(50),
+            "p90_us": self.percentile(90),
+            "p99_us": self.percentile(99),
+            "p999_us": self.percentile(99.9),
+            "max_us": self.max,
+            "buckets": [[round(self.upper(i), 1), n] for i, n in sorted(self.buckets.items())],
+        }
+
+
+class Stats:
+    def __init__(self):
+        self.latency = {}
+        self.counters = {}
+
+    def record(self, name, seconds):
+        self.latency.setdefault(name, Histogram()).record(seconds)
+
+    def count(self, name, n=1):
+        self.counters[name] = self.counters.get(name, 0) + n
+
+
+# ----------------------------------------------------------------------------
+# Protocol helpers
+# ----------------------------------------------------------------------------
+
+def parse_mix(text, kinds):
+    mix = []
+    for item in text.split(","):
+        name, _, weight = item.partition("=")
+        if name not in kinds:
+            raise argparse.ArgumentTypeError("unknown message %r, expected one of %s" % (name, ", ".join(kinds)))
+        weight = float(weight or 1)
+        if weight > 0:
+            mix.append((name, weight))
+    if not mix:
+        raise argparse.ArgumentTypeError("the mix has no message with a weight")
+    return mix
+
+
+def pick(rng, mix):
+    return rng.choices([name for name, _ in mix], [weight for _, weight in mix])[0]
+
+
+def frame_header(kind, axes, flags, seq):
+    return struct.pack("<BBBBI", PROTOCOL_VERSION, kind, axes, flags, seq)
+
+
+def set_position_frame(axes, seq, positions, feedrate):
+    mask = (1 << axes) - 1
+    return frame_header(MSG_SET_POSITION, axes, mask, seq) + struct.pack("<%df" % (axes + 1), *positions, feedrate)
+
+
+async def http_request(host, port, method, path, body=b""):
+    """One request on its own connection; returns (status, body)."""
+    reader, writer = await asyncio.open_connection(host, port)
+    try:
+        head = "%s %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n" % (method, path, host)
+        if body:
+            head += "Content-Type: application/json\r\nContent-Length: %d\r\n" % len(body)
+        writer.write(head.encode() + b"\r\n" + body)
+        response = await reader.read()
+    finally:
+        writer.close()
+    status_line, _, rest = response.partition(b"\r\n")
+    parts = status_line.split()
+    status = int(parts[1]) if len(parts) > 1 and parts[1].isdigit() else 0
+    return status, rest.partition(b"\r\n\r\n")[2]
+
+
+class WebSocket:
+    """Just enough of RFC 6455 for the firmware's /ws."""
+
+    def __init__(self, reader, writer):
+        self.reader = reader
+        self.writer = writer
+
+    @classmethod
+    async def connect(cls, host, port, path="/ws"):
+        reader, writer = await asyncio.open_connection(host, port)
+        key = base64.b64encode(os.urandom(16)).decode()
+        writer.write(("GET %s HTTP/1.1\r\nHost: %s\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                      "Sec-WebSocket-Key: %s\r\nSec-WebSocket-Version: 13\r\n\r\n" % (path, host, key)).encode())
+        head = await reader.readuntil(b"\r\n\r\n")
+        if not head.startswith(b"HTTP/1.1 101"):
+            writer.close()
+            raise ConnectionError(head.split(b"\r\n")[0].decode(errors="replace"))
+        return cls(reader, writer)
+
+    def send(self, opcode, payload):
+        mask = os.urandom(4)
+        n = len(payload)
+        if n < 126:
+            head = struct.pack("!BB", 0x80 | opcode, 0x80 | n)
+        elif n < 65536:
+            head = struct.pack("!BBH", 0x80 | opcode, 0x80 | 126, n)
+        else:
+            head = struct.pack("!BBQ", 0x80 | opcode, 0x80 | 127, n)
+        masked = bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+        self.writer.write(head + mask + masked)
+
+    async def receive(self):
+        """Next data frame as (opcode, payload); answers pings on the way."""
+        while True:
+            b0, b1 = await self.reader.readexactly(2)
+            n = b1 & 0x7F
+            if n == 126:
+                n = struct.unpack("!H", await self.reader.readexactly(2))[0]
+            elif n == 127:
+                n = struct.unpack("!Q", await self.reader.readexactly(8))[0]
+            payload = await self.reader.readexactly(n)
+            opcode = b0 & 0x0F
+            if opcode == 0x8:
+                raise ConnectionError("closed by the server")
+            if opcode == 0x9:
+                self.send(0xA, payload)
+                continue
+            if opcode in (0x1, 0x2):
+                return opcode, payload
+
+    def close(self):
+        self.writer.close()
+
+
+# ----------------------------------------------------------------------------
+# Clients
+# ----------------------------------------------------------------------------
+
+async def ticks(rate, deadline, rng):
+    """Yields on a fixed schedule of rate per second, from a random phase."""
+    period = 1.0 / rate
+    due = time.monotonic() + rng.uniform(0, period)
+    while due < deadline:
+        delay = due - time.monotonic()
+        if delay > 0:
+            await asyncio.sleep(delay)
+        yield
+        due += period
+
+
+async def http_poller(args, stats, rng, deadline):
+    in_flight = set()
+
+    async def call(kind):
+        start = time.monotonic()
+        try:
+            if kind == "get":
+                request = http_request(args.host, args.port, "GET", "/getPosition")
+            else:
+                positions = [round(rng.uniform(0, args.span), 2) for _ in range(args.axes)]
+                body = json.dumps({"position": positions, "feedrate": args.feedrate}).encode()
+                request = http_request(args.host, args.port, "POST", "/setPosition", body)
+            status, _ = await asyncio.wait_for(request, HTTP_TIMEOUT)
+        except asyncio.TimeoutError:
+            stats.count("http %s timeouts" % kind)
+            return
+        except OSError:
+            stats.count("http %s connect errors" % kind)
+            return
+        stats.record("http %s" % kind, time.monotonic() - start)
+        if not 200 <= status < 300:
+            stats.count("http %s status %d" % (kind, status))
+
+    async for _ in ticks(args.http_rate, deadline, rng):
+        if len(in_flight) >= HTTP_MAX_IN_FLIGHT:
+            stats.count("http skipped (in flight)")
+            continue
+        task = asyncio.ensure_future(call(pick(rng, args.http_mix)))
+        in_flight.add(task)
+        task.add_done_callback(in_flight.discard)
+    if in_flight:
+        await asyncio.wait(in_flight)
+
+
+async def ws_client(args, stats, rng, deadline):
+    seq = 0
+    while time.monotonic() < deadline:
+        try:
+            ws = await asyncio.wait_for(WebSocket.connect(args.host, args.port), HTTP_TIMEOUT)
+        except (OSError, asyncio.TimeoutError, asyncio.IncompleteReadError, ConnectionError):
+            stats.count("ws connect errors")
+            await asyncio.sleep(RECONNECT_DELAY)
+            continue
+        stats.count("ws connections")
+
+        # replies the binary protocol echoes by seq, text replies in order
+        pending = {}
+        text_pending = []
+        telemetry = {"since": time.monotonic(), "frames": 0}
+
+        if args.telemetry:
+            ws.send(0x2, frame_header(MSG_SUBSCRIBE, 0, 0, 0) + struct.pack("<H", args.telemetry))
+
+        async def read():
+            while True:
+                opcode, payload = await ws.receive()
+                now = time.monotonic()
+                if opcode == 0x1:
+                    if b'"programStatus"' in payload and text_pending:
+                        stats.record("ws text", now - text_pending.pop(0))
+                    continue
+                if len(payload) < 8:
+                    continue
+                kind, flags, frame_seq = payload[1], payload[3], struct.unpack_from("<I", payload, 4)[0]
+                if kind == MSG_TELEMETRY:
+                    telemetry["frames"] += 1
+                elif kind in (MSG_ACK, MSG_PROGRAM_STATUS) and frame_seq in pending:
+                    name, start = pending.pop(frame_seq)
+                    stats.record("ws %s" % name, now - start)
+                    if kind == MSG_ACK and flags != 0:
+                        stats.count("ws %s nack %d" % (name, flags))
+
+        reader = asyncio.ensure_future(read())
+        try:
+            async for _ in ticks(args.ws_rate, deadline, rng):
+                if reader.done():
+                    break
+                now = time.monotonic()
+                for frame_seq in [s for s, (_, start) in pending.items() if now - start > REPLY_TIMEOUT]:
+                    stats.count("ws %s lost" % pending.pop(frame_seq)[0])
+                kind = pick(rng, args.ws_mix)
+                seq = (seq + 1) & 0xFFFFFFFF
+                if kind == "set":
+                    positions = [rng.uniform(0, args.span) for _ in range(args.axes)]
+                    ws.send(0x2, set_position_frame(args.axes, seq, positions, args.feedrate))
+                    pending[seq] = (kind, now)
+                elif kind == "status":
+                    ws.send(0x2, frame_header(MSG_STATUS, 0, 0, seq))
+                    pending[seq] = (kind, now)
+                else:
+                    ws.send(0x1, b'{"action":"status"}')
+                    text_pending.append(now)
+                await ws.writer.drain()
+            if not reader.done():
+                # give the last replies time to arrive
+                await asyncio.sleep(min(REPLY_TIMEOUT, 0.5))
+        except (OSError, ConnectionError):
+            pass
+        finally:
+            reader.cancel()
+            ws.close()
+
+        if reader.done() and not reader.cancelled() and reader.exception() is not None:
+            stats.count("ws disconnects")
+        for name, _ in pending.values():
+            stats.count("ws %s lost" % name)
+        stats.count("ws text lost", len(text_pending))
+
+        if args.telemetry:
+            elapsed = time.monotonic() - telemetry["since"]
+            expected = int(elapsed * min(args.telemetry, TELEMETRY_MAX_RATE))
+            stats.count("telemetry frames", telemetry["frames"])
+            stats.count("telemetry expected", expected)
+            stats.count("telemetry dropped", max(0, expected - telemetry["frames"]))
+
+        if time.monotonic() < deadline:
+            await asyncio.sleep(RECONNECT_DELAY)
+
+
+# ----------------------------------------------------------------------------
+# Main
+# ----------------------------------------------------------------------------
+
+async def number_of_axes(args):
+    try:
+        status, body = await asyncio.wait_for(http_request(args.host, args.port, "GET", "/getNumberOfAxes"), HTTP_TIMEOUT)
+        if status == 200:
+            return int(json.loads(body.decode())["numberOfAxes"])
+    except (OSError, ValueError, KeyError, asyncio.TimeoutError):
+        pass
+    return 0
+
+
+async def progress(stats, interval, deadline):
+    start = time.monotonic()
+    last = {}
+    while time.monotonic() + interval < deadline:
+        await asyncio.sleep(interval)
+        parts = []
+        for name, histogram in sorted(stats.latency.items()):
+            rate = (histogram.count - last.get(name, 0)) / interval
+            last[name] = histogram.count
+            parts.append("%s %.0f/s p99 %.1f ms" % (name, rate, histogram.percentile(99) / 1000))
+        print("[%5.0fs] %s" % (time.monotonic() - start, ", ".join(parts) or "no replies"), flush=True)
+
+
+def report(stats, args, elapsed):
+    print()
+    print("%-12s %8s %8s %9s %9s %9s %9s %9s" % ("latency", "count", "per s", "p50 ms", "p90 ms", "p99 ms", "p99.9 ms", "max ms"))
+    for name, h in sorted(stats.latency.items()):
+        print("%-12s %8d %8.1f %9.2f %9.2f %9.2f %9.2f %9.2f" % (
+            name, h.count, h.count / elapsed, h.percentile(50) / 1000, h.percentile(90) / 1000,
+            h.percentile(99) / 1000, h.percentile(99.9) / 1000, h.max / 1000))
+    if stats.counters:
+        print()
+        for name, value in sorted(stats.counters.items()):
+            print("%-28s %d" % (name, value))
+    if args.histogram:
+        for name, h in sorted(stats.latency.items()):
+            print("\n%s" % name)
+            peak = max(h.buckets.values())
+            for index, n in sorted(h.buckets.items()):
+                print("  <= %10.1f us %8d %s" % (h.upper(index), n, "#" * max(1, int(40 * n / peak))))
+
+
+async def run(args):
+    if not args.axes:
+        args.axes = await number_of_axes(args)
+        if not args.axes:
+            print("loadgen: %s:%d did not answer /getNumberOfAxes" % (args.host, args.port), file=sys.stderr)
+            return 1
+
+    print("loadgen: %s:%d, %d axes, %d WebSocket x %.1f/s, %d HTTP x %.1f/s, telemetry %d Hz, %.0f s" % (
+        args.host, args.port, args.axes, args.ws, args.ws_rate, args.http, args.http_rate,
+        args.telemetry, args.duration), flush=True)
+
+    stats = Stats()
+    rng = random.Random(args.seed)
+    start = time.monotonic()
+    deadline = start + args.duration
+    clients = [ws_client(args, stats, random.Random(rng.random()), deadline) for _ in range(args.ws)]
+    clients += [http_poller(args, stats, random.Random(rng.random()), deadline) for _ in range(args.http)]
+    if args.interval > 0:
+        clients.append(progress(stats, args.interval, deadline))
+    await asyncio.gather(*clients)
+    elapsed = time.monotonic() - start
+
+    report(stats, args, elapsed)
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump({
+                "target": "%s:%d" % (args.host, args.port),
+                "config": {k: v for k, v in vars(args).items() if k != "json"},
+                "elapsed_s": elapsed,
+                "latency": {name: h.to_json() for name, h in stats.latency.items()},
+                "counters": stats.counters,
+            }, f, indent=2)
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8080, help="8080 for the native build, 80 for a device")
+    parser.add_argument("--duration", type=float, default=30, help="seconds of load")
+    parser.add_argument("--ws", type=int, default=4, help="WebSocket connections")
+    parser.add_argument("--ws-rate", type=float, default=10, help="messages per second per WebSocket")
+    parser.add_argument("--ws-mix", type=lambda s: parse_mix(s, ("set", "status", "text")), default="set=3,status=1")
+    parser.add_argument("--telemetry", type=int, default=10, help="telemetry rate each WebSocket subscribes to, 0: none")
+    parser.add_argument("--http", type=int, default=2, help="HTTP pollers")
+    parser.add_argument("--http-rate", type=float, default=5, help="requests per second per poller")
+    parser.add_argument("--http-mix", type=lambda s: parse_mix(s, ("get", "set")), default="get=4,set=1")
+    parser.add_argument("--axes", type=int, default=0, help="axes to command, 0: ask /getNumberOfAxes")
+    parser.add_argument("--span", type=float, default=10, help="positions are drawn from [0, span] mm")
+    parser.add_argument("--feedrate", type=float, default=20, help="mm/s sent with every move")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--interval", type=float, default=5, help="seconds between progress lines, 0: none")
+    parser.add_argument("--histogram", action="store_true", help="print the latency buckets")
+    parser.add_argument("--json", help="write the results to this file")
+    args = parser.parse_args()
+    if args.ws_rate <= 0 or args.http_rate <= 0:
+        parser.error("rates must be positive")
+
+    sys.exit(asyncio.run(run(args)))
+
+
+if __name__ == "__main__":
+    main()
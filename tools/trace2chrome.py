@@ -0,0 +1,123 @@
+"""Converts a /trace dump of the firmware to the Chrome trace event format.
+
+The result opens in chrome://tracing or https://ui.perfetto.dev, one row per
+track: server task (HTTP and WebSocket handlers), loop task, stepper
+interrupt and WiFi events. The dump format is described in
+src/metrics/trace.h.
+
+    curl -o trace.bin http://192.168.1.50/trace
+    python tools/trace2chrome.py trace.bin trace.json
+
+The input may also be the URL itself, and the output defaults to stdout:
+
+    python tools/trace2chrome.py http://127.0.0.1:8080/trace > trace.json
+"""
+
+import json
+import struct
+import sys
+import urllib.request
+
+MAGIC = b"RCTR"
+FORMAT_VERSION = 1
+EVENT = struct.Struct("<IHBBI")
+
+TYPES = {0: "B", 1: "E", 2: "i", 3: "X"}
+TRACKS = {0: "server task", 1: "loop task", 2: "stepper interrupt", 3: "WiFi events"}
+
+
+def parse(data):
+    if data[:4] != MAGIC:
+        raise ValueError("not a trace dump")
+    if data[4] != FORMAT_VERSION:
+        raise ValueError("trace format %d, expected %d" % (data[4], FORMAT_VERSION))
+    offset = 6
+    names = []
+    for _ in range(data[5]):
+        length = data[offset]
+        names.append(data[offset + 1:offset + 1 + length].decode(errors="replace"))
+        offset += 1 + length
+    recorded, now = struct.unpack_from("<II", data, offset)
+    offset += 8
+    events = [EVENT.unpack_from(data, at) for at in range(offset, len(data) - EVENT.size + 1, EVENT.size)]
+    return names, recorded, now, events
+
+
+def convert(names, now, events):
+    """Chrome events, with micros() unwrapped and made relative to the first
+    event. Ends whose begin was overwritten are dropped and spans still open
+    are closed when the dump was taken, so every track nests."""
+    if not events:
+        return []
+    base = events[0][0]
+    wraps = 0
+    previous = base
+    open_spans = {}
+    kept = []
+    for time, name, kind, track, arg in events:
+        # events come in recording order, give or take a preemption
+        if time < previous and previous - time > 1 << 31:
+            wraps += 1
+        elif time > previous and time - previous > 1 << 31:
+            wraps -= 1
+        previous = time
+        ts = time + (wraps << 32) - base
+        label = names[name] if name < len(names) else "#%d" % name
+        stack = open_spans.setdefault(track, [])
+        if kind == 0:
+            stack.append(len(kept))
+        elif kind == 1:
+            if not stack:
+                continue
+            stack.pop()
+        event = {"name": label, "ph": TYPES.get(kind, "i"), "ts": ts, "pid": 1, "tid": track}
+        if kind == 2:
+            event["s"] = "t"
+        if kind == 3:
+            event["dur"] = arg
+        elif arg:
+            event["args"] = {"arg": arg}
+        kept.append(event)
+    # the dump was taken after the last event
+    end = previous + ((now - previous) & 0xFFFFFFFF) + (wraps << 32) - base
+    for track, stack in open_spans.items():
+        for i in reversed(stack):
+            kept.append({"name": kept[i]["name"], "ph": "E", "ts": end, "pid": 1, "tid": track})
+    result = kept
+
+    metadata = [{"name": "process_name", "ph": "M", "pid": 1, "args": {"name": "controller"}}]
+    for track in sorted({event["tid"] for event in result}):
+        metadata.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": track,
+                         "args": {"name": TRACKS.get(track, "track %d" % track)}})
+        metadata.append({"name": "thread_sort_index", "ph": "M", "pid": 1, "tid": track,
+                         "args": {"sort_index": track}})
+    return metadata + result
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        print(__doc__.strip(), file=sys.stderr)
+        sys.exit(2)
+    source = sys.argv[1]
+    if source.startswith(("http://", "https://")):
+        with urllib.request.urlopen(source) as response:
+            data = response.read()
+    else:
+        with open(source, "rb") as f:
+            data = f.read()
+
+    names, recorded, now, events = parse(data)
+    trace = {"traceEvents": convert(names, now, events), "displayTimeUnit": "ms"}
+    lost = recorded - len(events)
+    print("trace2chrome: %d events%s" % (len(events), ", %d older ones not in the dump" % lost if lost > 0 else ""),
+          file=sys.stderr)
+
+    if len(sys.argv) == 3:
+        with open(sys.argv[2], "w") as f:
+            json.dump(trace, f)
+    else:
+        json.dump(trace, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()